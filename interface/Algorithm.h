@@ -8,6 +8,7 @@
 #ifndef BSM_ALGORITHM
 #define BSM_ALGORITHM
 
+#include <string>
 #include <vector>
 
 #include <boost/shared_ptr.hpp>
@@ -48,8 +49,65 @@ namespace bsm
     class NeutrinoReconstruct : public core::Object
     {
         public:
-            typedef boost::shared_ptr<LorentzVector> LorentzVectorPtr;
-            typedef std::vector<LorentzVectorPtr> Solutions;
+            // Fixed capacity container of solutions: there are at most
+            // two solutions, they are kept by value
+            //
+            class Solutions
+            {
+                public:
+                    enum
+                    {
+                        CAPACITY = 2
+                    };
+
+                    typedef const LorentzVector *const_iterator;
+
+                    Solutions():
+                        _size(0)
+                    {
+                    }
+
+                    inline uint32_t size() const
+                    {
+                        return _size;
+                    }
+
+                    inline bool empty() const
+                    {
+                        return !_size;
+                    }
+
+                    inline const_iterator begin() const
+                    {
+                        return _solutions;
+                    }
+
+                    inline const_iterator end() const
+                    {
+                        return _solutions + _size;
+                    }
+
+                    inline const LorentzVector &operator[](
+                            const uint32_t &index) const
+                    {
+                        return _solutions[index];
+                    }
+
+                    inline void clear()
+                    {
+                        _size = 0;
+                    }
+
+                    // Solution is a copy of the MET with given pz. Solutions
+                    // over capacity are ignored
+                    //
+                    void push_back(const LorentzVector &met,
+                                   const double &pz);
+
+                private:
+                    LorentzVector _solutions[CAPACITY];
+                    uint32_t _size;
+            };
 
             NeutrinoReconstruct();
             NeutrinoReconstruct(const NeutrinoReconstruct &);
@@ -60,6 +118,12 @@ namespace bsm
             Solutions operator()(const LorentzVector &lepton,
                     const LorentzVector &neutrino);
 
+            // Same as above without the copy of solutions: use in loops
+            //
+            void operator()(const LorentzVector &lepton,
+                    const LorentzVector &neutrino,
+                    Solutions &);
+
             int solutions() const;
 
             // Object interface
@@ -186,7 +250,7 @@ namespace bsm
                 LorentzVector wlep;
                 LorentzVector whad;
                 LorentzVector neutrino;     // Selected MET solution
-                LorentzVectors neutrinos;   // All MET solutions
+                NeutrinoReconstruct::Solutions neutrinos; // All MET solutions
                 LorentzVector ltop;
                 LorentzVector htop;
 
@@ -204,160 +268,466 @@ namespace bsm
                 bool valid;
             };
 
+            // Hypotheses search: loop over all jets assignments or assign
+            // jets one by one and drop partial assignments that can not
+            // give leptonic discriminator below the best solution. Both
+            // searches find the same solution: pruning assumes leptonic
+            // jet is one of the leptonic side jets, or the last one if
+            // validity says so.
+            //
+            // Incremental search loops over all assignments in Gray order
+            // and updates hadronic p4 with one jet per hypothesis instead of
+            // summing all hadronic jets. The sum may differ from the
+            // exhaustive one at the level of rounding
+            //
+            enum Search
+            {
+                EXHAUSTIVE = 0,
+                PRUNED,
+                INCREMENTAL
+            };
+
+            ResonanceReconstructor();
+
+            void setSearch(const Search &);
+            Search search() const;
+
+            // Hypotheses are searched in the policy reconstructor: there
+            // is one virtual call per event
+            //
             virtual Mttbar run(const LorentzVector &lepton,
                                const LorentzVector &met,
-                               const SynchSelector::GoodJets &) const;
+                               const SynchSelector::GoodJets &) const = 0;
 
             // Object interface
             //
             virtual void print(std::ostream &) const;
 
         protected:
-            virtual bool isValidHadronicSide(const LorentzVector &,
-                                             const Iterators &) const = 0;
-
-            virtual bool isValidLeptonicSide(const LorentzVector &,
-                                             const Iterators &) const = 0;
-
-            virtual bool isValidNeutralSide(const LorentzVector &,
-                                            const Iterators &) const = 0;
+            typedef NeutrinoReconstruct::Solutions Neutrinos;
 
-            virtual LorentzVector getLeptonicJet(const Iterators &) const = 0;
+            // Best Solution should have minimum value of the leptonic
+            // discriminator and maximum value of the hadronic discriminator
+            // in case the same leptonic discriminator is found
+            //
+            struct Solution
+            {
+                Solution();
 
-            virtual float getLeptonicDiscriminator(
-                    const LorentzVector &ltop,
-                    const LorentzVector &lepton,
-                    const LorentzVector &neutrino,
-                    const LorentzVector &jet) const = 0;
+                LorentzVector ltop; // Reconstructed leptonic leg
+                LorentzVector htop; // Reconstructed hadronic leg
+                LorentzVector missing_energy;
 
-            virtual float getHadronicDiscriminator(
-                    const LorentzVector &ltop,
-                    const LorentzVector &htop,
-                    const Iterators &htop_jets) const = 0;
-    };
+                CorrectedJets htop_jets;
+                CorrectedJets ltop_jets;
 
-    class SimpleResonanceReconstructor: public ResonanceReconstructor
-    {
-        public:
-            // Object interface
-            //
-            virtual uint32_t id() const;
-            virtual ObjectPtr clone() const;
+                LorentzVector ltop_jet; // Used jet in the ltop reconstruction
 
-            virtual void print(std::ostream &) const;
+                float htop_discriminator;
+                float ltop_discriminator;
+                int htop_njets;
 
-        protected:
-            virtual bool isValidHadronicSide(const LorentzVector &,
-                                             const Iterators &) const;
+                // Hypothesis position in counting order: the first found of
+                // equal solutions is kept in any order of search
+                //
+                uint32_t index;
 
-            virtual bool isValidLeptonicSide(const LorentzVector &,
-                                             const Iterators &) const;
+                bool valid;
+            };
 
-            virtual bool isValidNeutralSide(const LorentzVector &,
-                                            const Iterators &) const;
+            // Partial assignment of jets in the pruned search
+            //
+            struct Branch;
 
-            virtual LorentzVector getLeptonicJet(const Iterators &) const;
+            // Compare hypothesis with all neutrino solutions against the
+            // best solution. Hadronic jets are summed unless htop is given.
+            // Shootout evaluates every hypothesis with several
+            // reconstructors
+            //
+            virtual void evaluate(const LorentzVector &lepton,
+                                  const Neutrinos &,
+                                  const Generator::Hypothesis &,
+                                  const uint32_t &index,
+                                  const LorentzVector *htop,
+                                  Solution &) const = 0;
+
+            // Copy best solution into result
+            //
+            void fillResult(const LorentzVector &lepton,
+                            const Solution &,
+                            Mttbar &) const;
 
-            virtual float getLeptonicDiscriminator(
-                    const LorentzVector &ltop,
-                    const LorentzVector &lepton,
-                    const LorentzVector &neutrino,
-                    const LorentzVector &jet) const;
+        private:
+            Search _search;
 
-            virtual float getHadronicDiscriminator(
-                    const LorentzVector &ltop,
-                    const LorentzVector &htop,
-                    const Iterators &htop_jets) const;
+            // Shootout evaluates hypotheses of several reconstructors
+            //
+            friend class ResonanceShootout;
     };
 
-    class BtagResonanceReconstructor: public SimpleResonanceReconstructor
+    // Resonance reconstruction policies
+    //
+    // Validity policy accepts jets assignment to the decay sides and picks
+    // the leptonic jet:
+    //
+    //      bool isValidHadronicSide(lepton, jets) const;
+    //      bool isValidLeptonicSide(lepton, jets) const;
+    //      bool isValidNeutralSide(lepton, jets) const;
+    //      LorentzVector getLeptonicJet(jets) const;
+    //
+    // and tells if the leptonic jet is always the last jet of the leptonic
+    // side with positive pT (pruned search uses it to bound hypotheses):
+    //
+    //      bool isLastLeptonicJet() const;
+    //
+    // Leptonic and Hadronic discriminator policies give discriminators of
+    // the hypothesis:
+    //
+    //      float discriminator(ltop, lepton, neutrino, jet) const;
+    //      float discriminator(ltop, htop, htop_jets) const;
+    //
+    // Policies are defined in Algorithm.cc
+    //
+    class SimpleValidity
     {
         public:
-            // Object interface
-            //
-            virtual uint32_t id() const;
-            virtual ObjectPtr clone() const;
+            typedef ResonanceReconstructor::Iterators Iterators;
 
-            virtual void print(std::ostream &) const;
+            bool isValidHadronicSide(const LorentzVector &,
+                                     const Iterators &) const;
+
+            bool isValidLeptonicSide(const LorentzVector &,
+                                     const Iterators &) const;
+
+            bool isValidNeutralSide(const LorentzVector &,
+                                    const Iterators &) const;
+
+            // Last jet with positive pT
+            //
+            LorentzVector getLeptonicJet(const Iterators &) const;
+            bool isLastLeptonicJet() const;
 
         protected:
-            virtual bool isValidHadronicSide(const LorentzVector &,
-                                             const Iterators &) const;
+            // Last jet is the one with the highest position in the event:
+            // the same jet is selected for any order of jets in the leg
+            //
+            const CorrectedJet &lastJet(const Iterators &) const;
+    };
+
+    // At most one b-tagged jet on each top side and none of the neutral
+    // jets. B-tagged jet is used in the leptonic top
+    //
+    class BtagValidity: public SimpleValidity
+    {
+        public:
+            bool isValidHadronicSide(const LorentzVector &,
+                                     const Iterators &) const;
 
-            virtual bool isValidLeptonicSide(const LorentzVector &,
-                                             const Iterators &) const;
+            bool isValidLeptonicSide(const LorentzVector &,
+                                     const Iterators &) const;
 
-            virtual bool isValidNeutralSide(const LorentzVector &,
-                                            const Iterators &) const;
+            bool isValidNeutralSide(const LorentzVector &,
+                                    const Iterators &) const;
 
-            virtual LorentzVector getLeptonicJet(const Iterators &) const;
+            LorentzVector getLeptonicJet(const Iterators &) const;
+            bool isLastLeptonicJet() const;
 
         private:
             uint32_t countBtags(const Iterators &) const;
             bool isBtagJet(const Jet *jet) const;
     };
 
-    class SimpleDrResonanceReconstructor: public SimpleResonanceReconstructor
+    // Leptonic jets are close to lepton, hadronic jets are far away and
+    // neutral jets are in between
+    //
+    class SimpleDrValidity: public SimpleValidity
     {
         public:
-            SimpleDrResonanceReconstructor():
+            SimpleDrValidity():
                 _leptonic_dr(1),
                 _hadronic_dr(3.14)
             {
             }
 
-            // Object interface
-            //
-            virtual uint32_t id() const;
-            virtual ObjectPtr clone() const;
-
-            virtual void print(std::ostream &) const;
+            bool isValidHadronicSide(const LorentzVector &,
+                                     const Iterators &) const;
 
-        protected:
-            virtual bool isValidHadronicSide(const LorentzVector &,
-                                             const Iterators &) const;
+            bool isValidLeptonicSide(const LorentzVector &,
+                                     const Iterators &) const;
 
-            virtual bool isValidLeptonicSide(const LorentzVector &,
-                                             const Iterators &) const;
-
-            virtual bool isValidNeutralSide(const LorentzVector &,
-                                            const Iterators &) const;
+            bool isValidNeutralSide(const LorentzVector &,
+                                    const Iterators &) const;
 
         private:
             const float _leptonic_dr;
             const float _hadronic_dr;
     };
 
-    class HemisphereResonanceReconstructor: public SimpleResonanceReconstructor
+    // Leptonic jets are in the lepton hemisphere, hadronic jets are in the
+    // opposite one. There are no neutral jets
+    //
+    class HemisphereValidity: public SimpleValidity
     {
         public:
-            HemisphereResonanceReconstructor():
+            HemisphereValidity():
                 _half_pi(3.14159265 / 2)
             {
             }
 
+            bool isValidHadronicSide(const LorentzVector &,
+                                     const Iterators &) const;
+
+            bool isValidLeptonicSide(const LorentzVector &,
+                                     const Iterators &) const;
+
+            bool isValidNeutralSide(const LorentzVector &,
+                                    const Iterators &) const;
+
+        private:
+            const float _half_pi;
+    };
+
+    // Ltop: sum of delta R between ltop and its decay products
+    //
+    class DeltaRSumDiscriminator
+    {
+        public:
+            float discriminator(const LorentzVector &ltop,
+                                const LorentzVector &lepton,
+                                const LorentzVector &neutrino,
+                                const LorentzVector &jet) const;
+    };
+
+    // Ltop mass constrain
+    //
+    class LtopMassConstrain
+    {
+        public:
+            float discriminator(const LorentzVector &ltop,
+                                const LorentzVector &lepton,
+                                const LorentzVector &neutrino,
+                                const LorentzVector &jet) const;
+    };
+
+    // Delta R between htop and ltop
+    //
+    class DeltaRDiscriminator
+    {
+        public:
+            typedef ResonanceReconstructor::Iterators Iterators;
+
+            float discriminator(const LorentzVector &ltop,
+                                const LorentzVector &htop,
+                                const Iterators &htop_jets) const;
+    };
+
+    // Htop mass constrain
+    //
+    class HtopMassConstrain
+    {
+        public:
+            typedef ResonanceReconstructor::Iterators Iterators;
+
+            float discriminator(const LorentzVector &ltop,
+                                const LorentzVector &htop,
+                                const Iterators &htop_jets) const;
+    };
+
+    // Delta phi between htop and ltop is close to pi
+    //
+    class DeltaPhiConstrain
+    {
+        public:
+            typedef ResonanceReconstructor::Iterators Iterators;
+
+            float discriminator(const LorentzVector &ltop,
+                                const LorentzVector &htop,
+                                const Iterators &htop_jets) const;
+    };
+
+    // Product of two leptonic or two hadronic discriminators
+    //
+    template<class Left, class Right>
+    class DiscriminatorProduct
+    {
+        public:
+            typedef ResonanceReconstructor::Iterators Iterators;
+
+            float discriminator(const LorentzVector &ltop,
+                                const LorentzVector &lepton,
+                                const LorentzVector &neutrino,
+                                const LorentzVector &jet) const;
+
+            float discriminator(const LorentzVector &ltop,
+                                const LorentzVector &htop,
+                                const Iterators &htop_jets) const;
+
+        private:
+            Left _left;
+            Right _right;
+    };
+
+    // Hadronic discriminator is divided by the sum of delta R between htop
+    // and its jets if there are two or more jets
+    //
+    template<class Hadronic>
+    class CollimatedDiscriminator
+    {
+        public:
+            typedef ResonanceReconstructor::Iterators Iterators;
+
+            float discriminator(const LorentzVector &ltop,
+                                const LorentzVector &htop,
+                                const Iterators &htop_jets) const;
+
+        private:
+            Hadronic _hadronic;
+    };
+
+    // Reconstructor composed of policies: policies are called directly in
+    // the hypotheses loop and are inlined. Every combination in use is
+    // instantiated in Algorithm.cc
+    //
+    template<class Validity, class Leptonic, class Hadronic>
+    class PolicyResonanceReconstructor: public ResonanceReconstructor
+    {
+        public:
+            virtual Mttbar run(const LorentzVector &lepton,
+                               const LorentzVector &met,
+                               const SynchSelector::GoodJets &) const;
+
+        protected:
+            inline bool isValidHadronicSide(const LorentzVector &lepton,
+                                            const Iterators &jets) const
+            {
+                return _validity.isValidHadronicSide(lepton, jets);
+            }
+
+            inline bool isValidLeptonicSide(const LorentzVector &lepton,
+                                            const Iterators &jets) const
+            {
+                return _validity.isValidLeptonicSide(lepton, jets);
+            }
+
+            inline bool isValidNeutralSide(const LorentzVector &lepton,
+                                           const Iterators &jets) const
+            {
+                return _validity.isValidNeutralSide(lepton, jets);
+            }
+
+            inline LorentzVector getLeptonicJet(const Iterators &jets) const
+            {
+                return _validity.getLeptonicJet(jets);
+            }
+
+            virtual void evaluate(const LorentzVector &lepton,
+                                  const Neutrinos &,
+                                  const Generator::Hypothesis &,
+                                  const uint32_t &index,
+                                  const LorentzVector *htop,
+                                  Solution &) const;
+
+        private:
+            // Loop over hypotheses with the search in use: hypotheses are
+            // evaluated without virtual calls
+            //
+            void searchHypotheses(const LorentzVector &lepton,
+                                  const Neutrinos &,
+                                  const CorrectedJets &,
+                                  Solution &) const;
+
+            void check(const LorentzVector &lepton,
+                       const Neutrinos &,
+                       const Generator::Hypothesis &,
+                       const uint32_t &index,
+                       const LorentzVector *htop,
+                       Solution &) const;
+
+            // Lowest leptonic discriminator of hypotheses with given
+            // leptonic jet: bound of the pruned search
+            //
+            float leptonicBound(const LorentzVector &lepton,
+                                const Neutrinos &,
+                                const LorentzVector &jet) const;
+
+            // Assign the last unassigned jet to every side of the decay
+            // and go deeper unless partial assignment is worse than the best
+            // solution
+            //
+            void branch(Branch &,
+                        const uint32_t &unassigned_jets,
+                        const float &leptonic_bound,
+                        Solution &) const;
+
+            Validity _validity;
+            Leptonic _leptonic;
+            Hadronic _hadronic;
+    };
+
+    // Pre-instantiated combinations
+    //
+    typedef DiscriminatorProduct<HtopMassConstrain, DeltaPhiConstrain>
+        HtopMassAndDeltaPhiConstrain;
+
+    typedef DiscriminatorProduct<DeltaRDiscriminator, HtopMassConstrain>
+        DeltaRWithHtopMassConstrain;
+
+    typedef DiscriminatorProduct<DeltaRDiscriminator,
+                                 HtopMassAndDeltaPhiConstrain>
+        DeltaRWithHtopMassAndDeltaPhiConstrain;
+
+    typedef CollimatedDiscriminator<DeltaRWithHtopMassConstrain>
+        CollimatedDeltaRWithHtopMassConstrain;
+
+    typedef DiscriminatorProduct<DeltaRSumDiscriminator, LtopMassConstrain>
+        DeltaRSumWithLtopMassConstrain;
+
+    class SimpleResonanceReconstructor:
+        public PolicyResonanceReconstructor<SimpleValidity,
+                                            DeltaRSumDiscriminator,
+                                            DeltaRDiscriminator>
+    {
+        public:
             // Object interface
             //
             virtual uint32_t id() const;
             virtual ObjectPtr clone() const;
 
             virtual void print(std::ostream &) const;
+    };
 
-        protected:
-            virtual bool isValidHadronicSide(const LorentzVector &,
-                                             const Iterators &) const;
+    class BtagResonanceReconstructor:
+        public PolicyResonanceReconstructor<BtagValidity,
+                                            DeltaRSumDiscriminator,
+                                            DeltaRDiscriminator>
+    {
+        public:
+            // Object interface
+            //
+            virtual uint32_t id() const;
+            virtual ObjectPtr clone() const;
 
-            virtual bool isValidLeptonicSide(const LorentzVector &,
-                                             const Iterators &) const;
+            virtual void print(std::ostream &) const;
+    };
 
-            virtual bool isValidNeutralSide(const LorentzVector &,
-                                            const Iterators &) const;
+    class SimpleDrResonanceReconstructor:
+        public PolicyResonanceReconstructor<SimpleDrValidity,
+                                            DeltaRSumDiscriminator,
+                                            DeltaRDiscriminator>
+    {
+        public:
+            // Object interface
+            //
+            virtual uint32_t id() const;
+            virtual ObjectPtr clone() const;
 
-        private:
-            const float _half_pi;
+            virtual void print(std::ostream &) const;
     };
 
-    class ResonanceReconstructorWithMass: virtual public SimpleResonanceReconstructor
+    class HemisphereResonanceReconstructor:
+        public PolicyResonanceReconstructor<HemisphereValidity,
+                                            DeltaRSumDiscriminator,
+                                            DeltaRDiscriminator>
     {
         public:
             // Object interface
@@ -366,15 +736,12 @@ namespace bsm
             virtual ObjectPtr clone() const;
 
             virtual void print(std::ostream &) const;
-
-        protected:
-            virtual float getHadronicDiscriminator(
-                    const LorentzVector &ltop,
-                    const LorentzVector &htop,
-                    const Iterators &htop_jets) const;
     };
 
-    class ResonanceReconstructorWithPhi: virtual public SimpleResonanceReconstructor
+    class ResonanceReconstructorWithMass:
+        public PolicyResonanceReconstructor<SimpleValidity,
+                                            DeltaRSumDiscriminator,
+                                            HtopMassConstrain>
     {
         public:
             // Object interface
@@ -383,17 +750,26 @@ namespace bsm
             virtual ObjectPtr clone() const;
 
             virtual void print(std::ostream &) const;
+    };
 
-        protected:
-            virtual float getHadronicDiscriminator(
-                    const LorentzVector &ltop,
-                    const LorentzVector &htop,
-                    const Iterators &htop_jets) const;
+    class ResonanceReconstructorWithPhi:
+        public PolicyResonanceReconstructor<SimpleValidity,
+                                            DeltaRSumDiscriminator,
+                                            DeltaPhiConstrain>
+    {
+        public:
+            // Object interface
+            //
+            virtual uint32_t id() const;
+            virtual ObjectPtr clone() const;
+
+            virtual void print(std::ostream &) const;
     };
 
     class ResonanceReconstructorWithMassAndPhi:
-        public ResonanceReconstructorWithMass,
-        public ResonanceReconstructorWithPhi
+        public PolicyResonanceReconstructor<SimpleValidity,
+                                            DeltaRSumDiscriminator,
+                                            HtopMassAndDeltaPhiConstrain>
     {
         public:
             // Object interface
@@ -402,16 +778,12 @@ namespace bsm
             virtual ObjectPtr clone() const;
 
             virtual void print(std::ostream &) const;
-
-        protected:
-            virtual float getHadronicDiscriminator(
-                    const LorentzVector &ltop,
-                    const LorentzVector &htop,
-                    const Iterators &htop_jets) const;
     };
 
     class SimpleResonanceReconstructorWithMassAndPhi:
-        public ResonanceReconstructorWithMassAndPhi
+        public PolicyResonanceReconstructor<SimpleValidity,
+                                            DeltaRSumDiscriminator,
+                                            DeltaRWithHtopMassAndDeltaPhiConstrain>
     {
         public:
             // Object interface
@@ -420,16 +792,12 @@ namespace bsm
             virtual ObjectPtr clone() const;
 
             virtual void print(std::ostream &) const;
-
-        protected:
-            virtual float getHadronicDiscriminator(
-                    const LorentzVector &ltop,
-                    const LorentzVector &htop,
-                    const Iterators &htop_jets) const;
     };
 
     class SimpleResonanceReconstructorWithMass:
-        public ResonanceReconstructorWithMass
+        public PolicyResonanceReconstructor<SimpleValidity,
+                                            DeltaRSumDiscriminator,
+                                            DeltaRWithHtopMassConstrain>
     {
         public:
             // Object interface
@@ -438,16 +806,12 @@ namespace bsm
             virtual ObjectPtr clone() const;
 
             virtual void print(std::ostream &) const;
-
-        protected:
-            virtual float getHadronicDiscriminator(
-                    const LorentzVector &ltop,
-                    const LorentzVector &htop,
-                    const Iterators &htop_jets) const;
     };
 
     class CollimatedSimpleResonanceReconstructorWithMass:
-        public SimpleResonanceReconstructorWithMass
+        public PolicyResonanceReconstructor<SimpleValidity,
+                                            DeltaRSumDiscriminator,
+                                            CollimatedDeltaRWithHtopMassConstrain>
     {
         public:
             // Object interface
@@ -456,16 +820,12 @@ namespace bsm
             virtual ObjectPtr clone() const;
 
             virtual void print(std::ostream &) const;
-
-        protected:
-            virtual float getHadronicDiscriminator(
-                    const LorentzVector &ltop,
-                    const LorentzVector &htop,
-                    const Iterators &htop_jets) const;
     };
 
     class CollimatedSimpleResonanceReconstructorWithTopMass:
-        public CollimatedSimpleResonanceReconstructorWithMass
+        public PolicyResonanceReconstructor<SimpleValidity,
+                                            LtopMassConstrain,
+                                            CollimatedDeltaRWithHtopMassConstrain>
     {
         public:
             // Object interface
@@ -474,20 +834,12 @@ namespace bsm
             virtual ObjectPtr clone() const;
 
             virtual void print(std::ostream &) const;
-
-        protected:
-            virtual bool isValidLeptonicSide(const LorentzVector &,
-                                             const Iterators &jets);
-
-            virtual float getLeptonicDiscriminator(
-                    const LorentzVector &ltop,
-                    const LorentzVector &lepton,
-                    const LorentzVector &neutrino,
-                    const LorentzVector &jet) const;
     };
 
     class ResonanceReconstructorWithCollimatedTops:
-        public CollimatedSimpleResonanceReconstructorWithTopMass
+        public PolicyResonanceReconstructor<SimpleValidity,
+                                            DeltaRSumWithLtopMassConstrain,
+                                            CollimatedDeltaRWithHtopMassConstrain>
     {
         public:
             // Object interface
@@ -496,13 +848,6 @@ namespace bsm
             virtual ObjectPtr clone() const;
 
             virtual void print(std::ostream &) const;
-
-        protected:
-            virtual float getLeptonicDiscriminator(
-                    const LorentzVector &ltop,
-                    const LorentzVector &lepton,
-                    const LorentzVector &neutrino,
-                    const LorentzVector &jet) const;
     };
 
     struct Chi2Hypothesis
@@ -526,6 +871,100 @@ namespace bsm
         Iterators htop_jets;
     };
 
+    // Block of chi2 hypotheses in structure-of-arrays layout: every
+    // component is kept in a separate array for kernels to process several
+    // hypotheses at once
+    //
+    struct Chi2Batch
+    {
+        typedef DecayGenerator<CorrectedJet> Generator;
+
+        enum { SIZE = 32 };
+
+        struct P4s
+        {
+            double e[SIZE];
+            double px[SIZE];
+            double py[SIZE];
+            double pz[SIZE];
+        };
+
+        // Event jets with direction computed once per event
+        //
+        struct Jets
+        {
+            double e[Generator::MAX_OBJECTS];
+            double px[Generator::MAX_OBJECTS];
+            double py[Generator::MAX_OBJECTS];
+            double pz[Generator::MAX_OBJECTS];
+            double eta[Generator::MAX_OBJECTS];
+            double phi[Generator::MAX_OBJECTS];
+        };
+
+        // Best hypothesis found in batches
+        //
+        struct Best
+        {
+            Best();
+
+            bool valid;
+
+            float ltop_chi2;
+            float htop_chi2;
+
+            uint32_t ltop_jets;
+            uint32_t htop_jets;
+            uint32_t neutrino_index;
+        };
+
+        Chi2Batch();
+
+        void clear();
+        bool full() const;
+
+        // Decay hypothesis with given jets masks
+        //
+        void decay(const uint32_t &ltop_jets,
+                   const uint32_t &htop_jets,
+                   Generator::Hypothesis &) const;
+
+        Chi2Hypothesis hypothesis(const uint32_t &index) const;
+
+        // Append hypothesis with given neutrino: ltop is a sum of lepton,
+        // jet and neutrino. Jets are bit masks of jet positions in the event
+        //
+        void push_back(const LorentzVector &neutrino,
+                       const LorentzVector &ltop_jet,
+                       const LorentzVector &htop,
+                       const uint32_t &ltop_jets,
+                       const uint32_t &htop_jets,
+                       const uint32_t &neutrino_index);
+
+        uint32_t size;
+
+        const Generator::Objects *objects;
+
+        LorentzVector lepton;
+        double lepton_eta;
+        double lepton_phi;
+
+        Jets jets;
+
+        P4s ltop;
+        P4s neutrino;
+        P4s ltop_jet;
+        P4s htop;
+
+        uint32_t ltop_jets[SIZE];
+        uint32_t htop_jets[SIZE];
+        uint32_t neutrino_index[SIZE];
+
+        // Discriminators add chi2 of every hypothesis
+        //
+        float ltop_chi2[SIZE];
+        float htop_chi2[SIZE];
+    };
+
     class Chi2Discriminator: public core::Object
     {
         public:
@@ -541,6 +980,11 @@ namespace bsm
 
             virtual float calculate(const Chi2Hypothesis &) const = 0;
 
+            // Add chi2 of all hypotheses in the batch. Hypotheses are
+            // scored one by one unless discriminator has batch kernel
+            //
+            virtual void calculateBatch(const Chi2Batch &, float *chi2) const;
+
             // Object interface
             //
             virtual uint32_t id() const;
@@ -567,6 +1011,7 @@ namespace bsm
             }
 
             virtual float calculate(const Chi2Hypothesis &hypothesis) const;
+            virtual void calculateBatch(const Chi2Batch &, float *chi2) const;
 
             // Object interface
             //
@@ -583,6 +1028,7 @@ namespace bsm
             }
 
             virtual float calculate(const Chi2Hypothesis &hypothesis) const;
+            virtual void calculateBatch(const Chi2Batch &, float *chi2) const;
 
             // Object interface
             //
@@ -599,6 +1045,7 @@ namespace bsm
             }
 
             virtual float calculate(const Chi2Hypothesis &hypothesis) const;
+            virtual void calculateBatch(const Chi2Batch &, float *chi2) const;
 
             // Object interface
             //
@@ -615,6 +1062,7 @@ namespace bsm
             }
 
             virtual float calculate(const Chi2Hypothesis &hypothesis) const;
+            virtual void calculateBatch(const Chi2Batch &, float *chi2) const;
 
             // Object interface
             //
@@ -631,6 +1079,7 @@ namespace bsm
             }
 
             virtual float calculate(const Chi2Hypothesis &hypothesis) const;
+            virtual void calculateBatch(const Chi2Batch &, float *chi2) const;
 
             // Object interface
             //
@@ -644,7 +1093,8 @@ namespace bsm
             typedef boost::shared_ptr<Chi2Discriminator> Chi2DiscriminatorPtr;
             typedef std::vector<Chi2DiscriminatorPtr> Chi2Discriminators;
             
-            Chi2ResonanceReconstructor()
+            Chi2ResonanceReconstructor():
+                _batch(false)
             {
             }
 
@@ -664,9 +1114,137 @@ namespace bsm
             void setLtopDiscriminators(const Chi2Discriminators &);
             void setHtopDiscriminators(const Chi2Discriminators &);
 
+            // Score hypotheses in blocks with batch discriminators. Chi2 of
+            // the best hypothesis is recomputed one by one: batch kernels
+            // may differ from regular calculation at the level of rounding
+            // (see Chi2Batch kernels in Algorithm.cc)
+            //
+            void setBatch(const bool &);
+            bool batch() const;
+
         private:
+            // Leptonic jet, ltop and htop without neutrino
+            //
+            void prepare(const LorentzVector &lepton, Chi2Hypothesis &) const;
+
+            float ltopChi2(const Chi2Hypothesis &) const;
+            float htopChi2(const Chi2Hypothesis &) const;
+
+            Chi2Hypothesis runBatch(const LorentzVector &lepton,
+                                    const NeutrinoReconstruct::Solutions &,
+                                    const SynchSelector::GoodJets &) const;
+
+            // Score hypotheses in the batch and compare against the best
+            // one in the order hypotheses were added
+            //
+            void score(Chi2Batch &, Chi2Batch::Best &) const;
+
             Chi2Discriminators _ltop_discriminators;
             Chi2Discriminators _htop_discriminators;
+
+            bool _batch;
+    };
+
+    // Run several reconstructors in one pass: neutrino solutions, jets
+    // assignments and hadronic top p4 are shared by all reconstructors,
+    // every reconstructor keeps its own best solution. Results are the
+    // same as of exhaustive search of every reconstructor. Chi2
+    // reconstructors use their own loop over hypotheses
+    //
+    class ResonanceShootout: public core::Object
+    {
+        public:
+            typedef ResonanceReconstructor::Mttbar Mttbar;
+            typedef boost::shared_ptr<ResonanceReconstructor>
+                ReconstructorPtr;
+            typedef std::vector<Mttbar> Results;
+
+            ResonanceShootout();
+            ResonanceShootout(const ResonanceShootout &);
+
+            void add(const std::string &name, const ReconstructorPtr &);
+
+            uint32_t size() const;
+            const std::string &name(const uint32_t &index) const;
+            const ReconstructorPtr reconstructor(const uint32_t &index) const;
+
+            // Results are stored in the order reconstructors were added
+            //
+            void run(const LorentzVector &lepton,
+                     const LorentzVector &met,
+                     const SynchSelector::GoodJets &,
+                     Results &) const;
+
+            // Object interface
+            //
+            virtual uint32_t id() const;
+            virtual ObjectPtr clone() const;
+
+            virtual void print(std::ostream &) const;
+
+        private:
+            typedef ResonanceReconstructor::Generator Generator;
+            typedef ResonanceReconstructor::Solution Solution;
+            typedef std::vector<Solution> Solutions;
+
+            struct Entry
+            {
+                Entry(const std::string &name,
+                      const ReconstructorPtr &reconstructor);
+
+                std::string name;
+                ReconstructorPtr reconstructor;
+
+                // Reconstructor has its own loop over hypotheses
+                //
+                bool is_standalone;
+            };
+
+            typedef std::vector<Entry> Entries;
+
+            Entries _entries;
+    };
+
+    // Keep leading jets (by corrected pT) for the resonance reconstruction:
+    // number of hypotheses grows as 3^N with the number of jets. B-tagged
+    // jets beyond the leading ones may be kept too
+    //
+    class JetTruncation: public core::Object
+    {
+        public:
+            typedef SynchSelector::GoodJets GoodJets;
+
+            JetTruncation();
+
+            // 0 - keep all jets
+            //
+            void setMaxJets(const uint32_t &);
+            uint32_t maxJets() const;
+
+            void setKeepBtags(const bool &);
+            bool keepBtags() const;
+
+            // Copy kept jets in the input order: jets should be sorted by
+            // corrected pT. False is returned and output is not touched if
+            // no jet is dropped
+            //
+            bool apply(const GoodJets &jets, GoodJets &kept) const;
+
+            // Object interface
+            //
+            virtual uint32_t id() const;
+            virtual ObjectPtr clone() const;
+
+            virtual void print(std::ostream &) const;
+
+        private:
+            // Working point of the selector without scale factors: tagging
+            // should not depend on random numbers
+            //
+            bool isBtagJet(const CorrectedJet &) const;
+
+            uint32_t _max_jets;
+            bool _keep_btags;
     };
 }
 
@@ -19,6 +19,8 @@
 #include "bsm_input/interface/bsm_input_fwd.h"
 #include "bsm_input/interface/Reader.h"
 #include "interface/bsm_fwd.h"
+#include "interface/EventPool.h"
+#include "interface/Shard.h"
 
 namespace po = boost::program_options;
 
@@ -36,7 +38,10 @@ namespace bsm
             virtual DescriptionPtr description() const = 0;
     };
 
-    class AppController: public ReaderDelegate
+    class Checkpoint;
+
+    class AppController: public ReaderDelegate,
+        public SnapshotDelegate
     {
         public:
             typedef std::vector<std::string> Inputs;
@@ -72,6 +77,11 @@ namespace bsm
             virtual void fileWillClose(const Reader *);
             virtual void fileDidClose(const Reader *);
 
+            // Snapshot Delegate interface: checkpoint is saved
+            //
+            virtual void onSnapshot(const AnalyzerPtr &analyzer,
+                    const Inputs &processed);
+
         private:
             // Prevent Copying
             //
@@ -90,11 +100,46 @@ namespace bsm
 
             void setNumberOfThreads(const uint32_t &);
 
+            void setReaders(const uint32_t &);
+            void setQueueDepth(const uint32_t &);
+
+            void setStatsFile(const std::string &);
+            void setStatsPeriod(const uint32_t &);
+
+            void setCheckpointFile(const std::string &);
+            void setCheckpointFiles(const uint32_t &);
+            void setResume(const bool &);
+
+            void setShard(const std::string &);
+            void setShardEvents(const bool &);
+            void setPartialFile(const std::string &);
+
             void setInteractive(const bool &);
             void setOutput(const std::string &);
 
-            void processSingleThread();
-            void processMultiThread();
+            // Process inputs in single- or multi-thread mode
+            //
+            void process(const Inputs &);
+
+            // Process inputs and save checkpoint every number of processed
+            // files. Checkpoint is merged into analyzer on resume. False is
+            // returned if checkpoint can not be resumed: no inputs are
+            // processed
+            //
+            bool processWithCheckpoints();
+
+            // Save analyzer state and processed files of the shard
+            //
+            void savePartial();
+
+            typedef std::vector<EventRange> Ranges;
+
+            // Save checkpoint of the analyzer in single-thread mode
+            //
+            void saveSnapshot(const Inputs &processed);
+
+            void processSingleThread(const Ranges &);
+            void processMultiThread(const Ranges &);
 
             RunMode _run_mode;
 
@@ -110,6 +155,34 @@ namespace bsm
             bool _disable_multithread;
             uint32_t _number_of_threads;
 
+            // pipeline mode: reader threads and depth of the events queue
+            //
+            uint32_t _readers;
+            uint32_t _queue_depth;
+
+            // stats file is written every period (in seconds)
+            //
+            std::string _stats_file;
+            uint32_t _stats_period;
+
+            // checkpoint is saved every number of processed input files
+            //
+            std::string _checkpoint_file;
+            uint32_t _checkpoint_files;
+            bool _resume;
+
+            // checkpoint of the running job: files and state of the resumed
+            // checkpoint are added to every snapshot
+            //
+            boost::shared_ptr<Checkpoint> _checkpoint;
+            Inputs _checkpoint_inputs;
+            AnalyzerPtr _checkpoint_state;
+
+            // partial result of the shard is merged with bsm_merge
+            //
+            Shard _shard;
+            std::string _partial_file;
+
             boost::shared_ptr<core::Debug> _debug;
 
             bool _interactive;
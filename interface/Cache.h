@@ -6,6 +6,8 @@
 #ifndef CACHE_H
 #define CACHE_H
 
+#include <stdint.h>
+
 #include <stdexcept>
 
 namespace bsm
@@ -30,6 +32,54 @@ namespace bsm
             T _value;
             bool _is_valid;
     };
+
+    // Event counter: advance it once per event. Event caches are keyed by
+    // the counter value and do not need to be invalidated
+    //
+    class EventGeneration
+    {
+        public:
+            EventGeneration():
+                _value(1)
+            {
+            }
+
+            void next()
+            {
+                ++_value;
+            }
+
+            uint64_t value() const
+            {
+                return _value;
+            }
+
+        private:
+            uint64_t _value;
+    };
+
+    // Cache of a value derived from the event: the value is valid only
+    // within the event generation it was set in
+    //
+    template<typename T>
+    class EventCache
+    {
+        public:
+            EventCache();
+
+            bool is_valid(const EventGeneration &) const;
+
+            void set(const EventGeneration &, const T &);
+
+            // make sure cache is valid in the current event before extract
+            // its value otherwise runtime_error is thrown
+            //
+            const T &get(const EventGeneration &) const;
+
+        private:
+            T _value;
+            uint64_t _generation; // zero: value was never set
+    };
 }
 
 template<typename T>
@@ -66,4 +116,33 @@ const T &bsm::Cache<T>::get() const
     throw std::runtime_error("invalid cache");
 }
 
+template<typename T>
+bsm::EventCache<T>::EventCache():
+    _generation(0)
+{
+}
+
+template<typename T>
+bool bsm::EventCache<T>::is_valid(const EventGeneration &generation) const
+{
+    return generation.value() == _generation;
+}
+
+template<typename T>
+void bsm::EventCache<T>::set(const EventGeneration &generation,
+        const T &new_value)
+{
+    _value = new_value;
+    _generation = generation.value();
+}
+
+template<typename T>
+const T &bsm::EventCache<T>::get(const EventGeneration &generation) const
+{
+    if (is_valid(generation))
+        return _value;
+
+    throw std::runtime_error("invalid event cache");
+}
+
 #endif
@@ -0,0 +1,66 @@
+// Checkpoint
+//
+// Save state of the analyzer together with the list of processed input
+// files. Interrupted job can be resumed from the checkpoint: processed
+// files are skipped and saved state is merged into the analyzer.
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#ifndef BSM_CHECKPOINT
+#define BSM_CHECKPOINT
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bsm
+{
+    // Analyzers should implement delegate to support checkpoints
+    //
+    class CheckpointDelegate
+    {
+        public:
+            virtual ~CheckpointDelegate() {}
+
+            // Save state of the analyzer
+            //
+            virtual void save(std::ostream &) const = 0;
+
+            // Restore state of the analyzer that did not process any
+            // events yet. False is returned if state can not be read
+            //
+            virtual bool load(std::istream &) = 0;
+    };
+
+    // Strings are saved with their length: names may contain spaces and
+    // serialized messages any bytes
+    //
+    void saveString(std::ostream &, const std::string &);
+    bool loadString(std::istream &, std::string &);
+
+    class Checkpoint
+    {
+        public:
+            typedef std::vector<std::string> Inputs;
+
+            Checkpoint(const std::string &file_name);
+
+            bool exists() const;
+
+            // Checkpoint is written into temporary file first and then
+            // replaces the previous one: interrupted save does not
+            // corrupt the checkpoint
+            //
+            bool save(const Inputs &processed,
+                    const CheckpointDelegate &analyzer) const;
+
+            bool load(Inputs &processed, CheckpointDelegate &analyzer) const;
+
+        private:
+            const std::string _file_name;
+    };
+}
+
+#endif
@@ -9,6 +9,7 @@
 #include <iomanip>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include <boost/shared_ptr.hpp>
 
@@ -199,6 +200,98 @@ namespace bsm
 
 
 
+    // Cumulative wall, CPU time and number of calls of every cutflow stage.
+    // Timer is disabled by default: stages are not timed and scope does
+    // nothing. CPU time is measured per thread if the platform supports it.
+    //
+    // Example:
+    //
+    //      {
+    //          CutflowTimer::Scope scope(timer, JET);
+    //
+    //          // select jets
+    //      }
+    //
+    class CutflowTimer : public core::Object
+    {
+        public:
+            // RAII type stage timer: time is added to the stage on scope
+            // destruction
+            //
+            class Scope
+            {
+                public:
+                    Scope(CutflowTimer &, const uint32_t &stage);
+                    ~Scope();
+
+                private:
+                    // Prevent copying
+                    //
+                    Scope(const Scope &);
+                    Scope &operator =(const Scope &);
+
+                    CutflowTimer *_timer;
+                    const uint32_t _stage;
+
+                    double _wall_time;
+                    double _cpu_time;
+            };
+
+            CutflowTimer(const uint32_t &stages);
+
+            void enable();
+            void disable();
+
+            bool isEnabled() const;
+
+            uint32_t stages() const;
+
+            // Stage name is used in the print out
+            //
+            void setName(const uint32_t &stage, const std::string &name);
+            std::string name(const uint32_t &stage) const;
+
+            // Stage accessors: time is given in seconds
+            //
+            uint64_t calls(const uint32_t &stage) const;
+            double wallTime(const uint32_t &stage) const;
+            double cpuTime(const uint32_t &stage) const;
+
+            void add(const uint32_t &stage,
+                    const double &wall_time,
+                    const double &cpu_time);
+
+            // Object interface
+            //
+            virtual uint32_t id() const;
+
+            virtual ObjectPtr clone() const;
+
+            // Timers are merged only if number of stages is the same
+            //
+            virtual void merge(const ObjectPtr &);
+
+            virtual void print(std::ostream &) const;
+
+        private:
+            struct Stage
+            {
+                Stage();
+
+                std::string name;
+                uint64_t calls;
+                double wall_time;
+                double cpu_time;
+            };
+
+            typedef std::vector<Stage> Stages;
+
+            Stages _stages;
+            bool _is_enabled;
+    };
+
+
+
     // One side cut with comparison policy: less, greater, etc. Policy is
     // defined with std functors [http://goo.gl/bh9dl]
     //
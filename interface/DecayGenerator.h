@@ -1,70 +1,282 @@
 // costruct TTbar Hypotheses given lepton, neutrino and jets
 //
+// Every object is assigned to the leptonic, hadronic or neutral leg of the
+// decay: there are 3^N hypotheses for N objects. Hypotheses are enumerated
+// with base-3 assignment code kept in the generator, in counting or
+// reflected Gray order (one object changes side between consecutive
+// hypotheses). Legs are fixed capacity spans of iterators: no memory is
+// allocated in the loop. Legs are rebuilt for every hypothesis in counting
+// order, while in Gray order only the changed object is moved between legs.
+//
 // Created by Samvel Khalatyan, Aug 14, 2011
 // Copyright 2011, All rights reserved
 
 #ifndef BSM_TTBAR_HYPOTHESIS
 #define BSM_TTBAR_HYPOTHESIS
 
-#include <cmath>
+#include <algorithm>
 #include <vector>
 
 #include "bsm_input/interface/bsm_input_fwd.h"
 
 namespace bsm
 {
+    // Fixed capacity sequence with interface of the const vector
+    //
+    template<typename T, uint32_t Capacity>
+    class FixedSpan
+    {
+        public:
+            typedef T value_type;
+            typedef const T *const_iterator;
+            typedef uint32_t size_type;
+
+            FixedSpan():
+                _size(0)
+            {
+            }
+
+            FixedSpan(const FixedSpan &span):
+                _size(span._size)
+            {
+                std::copy(span.begin(), span.end(), _items);
+            }
+
+            FixedSpan &operator =(const FixedSpan &span)
+            {
+                _size = span._size;
+                std::copy(span.begin(), span.end(), _items);
+
+                return *this;
+            }
+
+            const_iterator begin() const
+            {
+                return _items;
+            }
+
+            const_iterator end() const
+            {
+                return _items + _size;
+            }
+
+            size_type size() const
+            {
+                return _size;
+            }
+
+            bool empty() const
+            {
+                return !_size;
+            }
+
+            const T &operator[](const size_type &index) const
+            {
+                return _items[index];
+            }
+
+            const T &front() const
+            {
+                return _items[0];
+            }
+
+            // Items above capacity are ignored
+            //
+            void push_back(const T &item)
+            {
+                if (Capacity > _size)
+                    _items[_size++] = item;
+            }
+
+            // The last item takes place of the removed one: order of items
+            // is not kept
+            //
+            void erase_unordered(const size_type &index)
+            {
+                _items[index] = _items[--_size];
+            }
+
+            void clear()
+            {
+                _size = 0;
+            }
+
+        private:
+            T _items[Capacity];
+            size_type _size;
+    };
+
     template<typename T>
     class DecayGenerator
     {
         public:
+            // 3^20 hypotheses fit into 32 bit counter. Objects above the
+            // limit are not used
+            //
+            enum { MAX_OBJECTS = 20 };
+
+            // Counting order: the first object changes side with every
+            // hypothesis. Gray order (reflected base-3 code): consecutive
+            // hypotheses differ in side of one object only, the side is
+            // changed by one step: leptonic <-> hadronic <-> neutral
+            //
+            enum Order
+            {
+                COUNTING = 0,
+                GRAY
+            };
+
+            enum Side
+            {
+                LEPTONIC = 0,
+                HADRONIC = 1,
+                NEUTRAL = 2
+            };
+
             typedef std::vector<T> Objects;
-            typedef std::vector<typename Objects::const_iterator> Iterators;
+            typedef FixedSpan<typename Objects::const_iterator, MAX_OBJECTS>
+                Iterators;
 
+            // Objects are kept in the input order within every leg in
+            // counting order only
+            //
             struct Hypothesis
             {
                 typedef typename DecayGenerator::Iterators Iterators;
 
-                virtual ~Hypothesis()
-                {
-                }
-
                 Iterators leptonic;
                 Iterators hadronic;
                 Iterators neutral;
             };
 
+            // Object that changed side with the last call to next() in
+            // Gray order
+            //
+            struct Change
+            {
+                Change():
+                    valid(false),
+                    from(LEPTONIC),
+                    to(LEPTONIC)
+                {
+                }
+
+                bool valid;
+
+                typename Objects::const_iterator object;
+                Side from;
+                Side to;
+            };
+
             DecayGenerator();
 
-            void init(const Objects &objects);
+            // Objects are not copied: they should not be changed or
+            // destroyed while hypotheses are generated
+            //
+            void init(const Objects &objects, const Order &order = COUNTING);
 
             bool next();
 
-            Hypothesis hypothesis() const;
+            // Current hypothesis is updated with every call to next()
+            //
+            const Hypothesis &hypothesis() const;
+
+            // Position of the current hypothesis in counting order
+            //
+            uint32_t index() const;
+
+            const Change &change() const;
 
         private:
             bool isValid() const;
 
-            Objects _objects;
+            void nextCounting();
+            void nextGray();
+
+            // Fill legs from the assignment code
+            //
+            void update();
+
+            // Move object from one leg to another: position of the object
+            // in the leg is kept in the slots
+            //
+            void move(const uint32_t &object, const Side &from, const Side &to);
 
+            Iterators &leg(const Side &);
+
+            const Objects *_objects;
+
+            Order _order;
+
+            uint32_t _number_of_objects;
             uint32_t _number_of_hypotheses;
             uint32_t _current_hypothesis;
+            uint32_t _index;
+
+            // Base-3 digit for every object: the first object is the
+            // least significant digit
+            //
+            unsigned char _code[MAX_OBJECTS];
+
+            // Gray order: direction of every digit change and focus
+            // pointers of the loopless generation (Knuth, Algorithm H)
+            //
+            signed char _direction[MAX_OBJECTS];
+            unsigned char _focus[MAX_OBJECTS + 1];
+            uint32_t _weight[MAX_OBJECTS];
+
+            // Position of every object in its leg
+            //
+            unsigned char _slot[MAX_OBJECTS];
+
+            Change _change;
+
+            Hypothesis _hypothesis;
     };
 }
 
 template<typename T>
 bsm::DecayGenerator<T>::DecayGenerator():
+    _objects(0),
+    _order(COUNTING),
+    _number_of_objects(0),
     _number_of_hypotheses(0),
-    _current_hypothesis(0)
+    _current_hypothesis(0),
+    _index(0)
 {
 }
 
 template<typename T>
-void bsm::DecayGenerator<T>::init(const Objects &objects)
+void bsm::DecayGenerator<T>::init(const Objects &objects, const Order &order)
 {
-    _objects = objects;
+    _objects = &objects;
+    _order = order;
+
+    _number_of_objects = std::min<uint32_t>(objects.size(), MAX_OBJECTS);
+
+    _number_of_hypotheses = 1;
+    for(uint32_t object = 0; _number_of_objects > object; ++object)
+    {
+        _weight[object] = _number_of_hypotheses;
+        _number_of_hypotheses *= 3;
+    }
 
-    _number_of_hypotheses = pow(3.0, static_cast<int>(objects.size()));
     _current_hypothesis = 0;
+    _index = 0;
+
+    std::fill(_code, _code + _number_of_objects, LEPTONIC);
+
+    for(uint32_t object = 0; _number_of_objects >= object; ++object)
+    {
+        if (_number_of_objects > object)
+            _direction[object] = 1;
+
+        _focus[object] = object;
+    }
+
+    _change = Change();
+
+    update();
 }
 
 template<typename T>
@@ -75,49 +287,153 @@ bool bsm::DecayGenerator<T>::next()
 
     ++_current_hypothesis;
 
-    return isValid();
+    if (!isValid())
+        return false;
+
+    if (GRAY == _order)
+        nextGray();
+    else
+    {
+        nextCounting();
+
+        update();
+    }
+
+    return true;
 }
 
 template<typename T>
-typename bsm::DecayGenerator<T>::Hypothesis bsm::DecayGenerator<T>::hypothesis() const
+const typename bsm::DecayGenerator<T>::Hypothesis &
+    bsm::DecayGenerator<T>::hypothesis() const
 {
-    Hypothesis hypothesis;
+    return _hypothesis;
+}
 
-    if (isValid())
+template<typename T>
+uint32_t bsm::DecayGenerator<T>::index() const
+{
+    return _index;
+}
+
+template<typename T>
+const typename bsm::DecayGenerator<T>::Change &
+    bsm::DecayGenerator<T>::change() const
+{
+    return _change;
+}
+
+// Private
+//
+template<typename T>
+bool bsm::DecayGenerator<T>::isValid() const
+{
+    return _number_of_hypotheses > _current_hypothesis;
+}
+
+template<typename T>
+void bsm::DecayGenerator<T>::nextCounting()
+{
+    // Increment assignment code with carry
+    //
+    for(uint32_t object = 0; _number_of_objects > object; ++object)
     {
-        uint32_t current_hypothesis = _current_hypothesis;
-        for(typename Objects::const_iterator object = _objects.begin();
-                _objects.end() != object;
-                ++object)
+        if (NEUTRAL > _code[object])
         {
-            switch(current_hypothesis % 3)
-            {
-                case 0: // leptonic
-                    hypothesis.leptonic.push_back(object);
-                    break;
+            ++_code[object];
 
-                case 1: // hadronic
-                    hypothesis.hadronic.push_back(object);
-                    break;
+            break;
+        }
 
-                default:    // none
-                    hypothesis.neutral.push_back(object);
-                    break;
-            }
+        _code[object] = LEPTONIC;
+    }
 
-            current_hypothesis /= 3;        
-        }
+    _index = _current_hypothesis;
+}
+
+template<typename T>
+void bsm::DecayGenerator<T>::nextGray()
+{
+    const uint32_t object = _focus[0];
+    _focus[0] = 0;
+
+    _change.valid = true;
+    _change.object = _objects->begin() + object;
+    _change.from = static_cast<Side>(_code[object]);
+
+    _code[object] += _direction[object];
+    if (0 < _direction[object])
+        _index += _weight[object];
+    else
+        _index -= _weight[object];
+
+    _change.to = static_cast<Side>(_code[object]);
+
+    move(object, _change.from, _change.to);
+
+    // Digit reached the end: reverse direction and pass focus
+    //
+    if (LEPTONIC == _code[object]
+            || NEUTRAL == _code[object])
+    {
+        _direction[object] = -_direction[object];
+        _focus[object] = _focus[object + 1];
+        _focus[object + 1] = object + 1;
+    }
+}
+
+template<typename T>
+void bsm::DecayGenerator<T>::update()
+{
+    _hypothesis.leptonic.clear();
+    _hypothesis.hadronic.clear();
+    _hypothesis.neutral.clear();
+
+    if (!_objects)
+        return;
+
+    typename Objects::const_iterator object = _objects->begin();
+    for(uint32_t index = 0; _number_of_objects > index; ++index, ++object)
+    {
+        Iterators &objects = leg(static_cast<Side>(_code[index]));
+
+        _slot[index] = objects.size();
+        objects.push_back(object);
     }
+}
+
+template<typename T>
+void bsm::DecayGenerator<T>::move(const uint32_t &object,
+        const Side &from,
+        const Side &to)
+{
+    Iterators &source = leg(from);
+    Iterators &target = leg(to);
 
-    return hypothesis;
+    // The last object of the source leg takes the freed slot
+    //
+    const uint32_t slot = _slot[object];
+    _slot[source[source.size() - 1] - _objects->begin()] = slot;
+    source.erase_unordered(slot);
+
+    _slot[object] = target.size();
+    target.push_back(_objects->begin() + object);
 }
 
-// Private
-//
 template<typename T>
-bool bsm::DecayGenerator<T>::isValid() const
+typename bsm::DecayGenerator<T>::Iterators &
+    bsm::DecayGenerator<T>::leg(const Side &side)
 {
-    return _number_of_hypotheses > _current_hypothesis;
+    switch(side)
+    {
+        case LEPTONIC:
+            return _hypothesis.leptonic;
+
+        case HADRONIC:
+            return _hypothesis.hadronic;
+
+        default:
+            return _hypothesis.neutral;
+    }
 }
 
 #endif
@@ -0,0 +1,78 @@
+// Pool of events
+//
+// Events are reused between files, threads and the events queue. Cleared
+// protobuf messages keep memory allocated by nested messages (jets,
+// particles, triggers) and therefore reused events do not churn allocator.
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#ifndef BSM_EVENT_POOL
+#define BSM_EVENT_POOL
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "bsm_core/interface/Thread.h"
+#include "bsm_input/interface/bsm_input_fwd.h"
+
+namespace bsm
+{
+    class EventPool
+    {
+        public:
+            typedef boost::shared_ptr<Event> EventPtr;
+            typedef std::vector<EventPtr> Events;
+
+            EventPool();
+
+            // Take event from the pool. New event is allocated if pool is
+            // empty
+            //
+            EventPtr get();
+
+            // Append number of events to the container with one lock of
+            // the pool: missing events are allocated
+            //
+            void get(Events &, const uint32_t &size);
+
+            // Clear event and return it to the pool
+            //
+            void release(const EventPtr &);
+
+            // Clear events and return all of them with one lock of the pool
+            //
+            void release(const Events &);
+
+            // Number of events kept in the pool
+            //
+            uint32_t size() const;
+
+            // Number of events allocated by the pool
+            //
+            uint32_t allocated() const;
+
+        private:
+            core::ConditionPtr _condition;
+
+            Events _events;
+            uint32_t _allocated;
+    };
+
+    // Count all heap allocations in the application. Counting is only
+    // enabled if code is compiled with BSM_COUNT_ALLOCATIONS defined, e.g.:
+    //
+    //      CPPFLAGS=-DBSM_COUNT_ALLOCATIONS make
+    //
+    // Note: counter is shared between threads and slows down allocations
+    //
+    namespace allocation
+    {
+        bool isCounted();
+
+        uint64_t count();
+    }
+}
+
+#endif
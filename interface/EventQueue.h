@@ -0,0 +1,126 @@
+// Bounded queue of decoded events
+//
+// Reader threads decode events and push them into the queue in chunks of
+// consecutive events from one file, analyzer threads pop chunks. Consumer
+// gets chunk of its current file first if there is any: analyzers see runs
+// of events from the same file even if several readers fill the queue.
+// Producers are blocked while the queue is full and consumers are blocked
+// while it is empty. Events are reused.
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#ifndef BSM_EVENT_QUEUE
+#define BSM_EVENT_QUEUE
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "bsm_core/interface/Thread.h"
+#include "bsm_input/interface/bsm_input_fwd.h"
+#include "interface/EventPool.h"
+
+namespace bsm
+{
+    class EventQueue
+    {
+        public:
+            typedef boost::shared_ptr<Event> EventPtr;
+            typedef boost::shared_ptr<Input> InputPtr;
+
+            // Input file the event was read from. Consumer should notify
+            // analyzer whenever file is changed
+            //
+            struct InputFile
+            {
+                InputFile(const std::string &file_name,
+                        const InputPtr &input);
+
+                const std::string file_name;
+                const InputPtr input;
+            };
+
+            typedef boost::shared_ptr<const InputFile> InputFilePtr;
+
+            typedef EventPool::Events Events;
+
+            // Consecutive events of one file and their share of the input
+            // file size
+            //
+            struct Item
+            {
+                Item();
+                Item(const InputFilePtr &file);
+
+                Events events;
+                InputFilePtr file;
+                uint64_t bytes;
+            };
+
+            // Depth is the maximum number of events in the queue
+            //
+            EventQueue(const uint32_t &depth);
+
+            uint32_t depth() const;
+            uint32_t size() const;
+
+            // Number of events producer should put into one item
+            //
+            uint32_t chunkSize() const;
+
+            // Queue is drained only after all producers are removed
+            //
+            void addProducer();
+            void removeProducer();
+
+            // Append number of empty events to be filled by producer: the
+            // pool is locked once for all of them
+            //
+            void events(Events &, const uint32_t &size);
+
+            // Return processed events, e.g. the whole item, for reuse with
+            // one lock of the pool
+            //
+            void recycle(const Events &);
+
+            // Number of events allocated by producers
+            //
+            uint32_t eventsAllocated() const;
+
+            // Block while queue is full. False is returned if queue is
+            // closed
+            //
+            bool push(const Item &);
+
+            // Block while queue is empty. Item of the given file is taken
+            // if available, otherwise the oldest one. False is returned if
+            // queue is closed or there are no events left and all producers
+            // are removed
+            //
+            bool pop(Item &, const InputFilePtr &file = InputFilePtr());
+
+            // Wake up and stop all producers and consumers
+            //
+            void close();
+
+        private:
+            typedef std::deque<Item> Items;
+
+            core::ConditionPtr _condition;
+
+            Items _items;
+            uint32_t _depth;
+            uint32_t _chunk_size;
+            uint32_t _size;     // number of events in all items
+
+            EventPool _events;
+
+            uint32_t _producers;
+            bool _is_closed;
+    };
+}
+
+#endif
@@ -53,6 +53,9 @@ namespace bsm
                     const std::string &filename) {}
 
             virtual void setChildCorrection() {}
+
+            virtual void setMaxCorrection(const float &) {}
+            virtual void setValidatePrefilter(const bool &) {}
     };
 
     class JetEnergyCorrectionOptions : public Options
@@ -76,6 +79,9 @@ namespace bsm
             
             void setChildCorrection();
 
+            void setMaxCorrection(const float &);
+            void setValidatePrefilter(const bool &);
+
             JetEnergyCorrectionDelegate *_delegate;
 
             DescriptionPtr _description;
@@ -101,6 +107,12 @@ namespace bsm
             const CorrectionFiles &correctionFiles() const;
             void setCorrectionFiles(const CorrectionFiles &);
 
+            // Upper bound on the jet energy correction: jets can not pass
+            // a pT threshold if uncorrected pT times the bound is below it.
+            // The prefilter is off if bound is zero (default)
+            //
+            float maxCorrection() const;
+
             // IMPORTANT: Invalid pointer will be returned if Jet Energy
             //            Corrections are not loaded. As such, always check
             //            returned value for validity, e.g.:
@@ -111,11 +123,17 @@ namespace bsm
             //            else
             //              cout << "work with jet" << endl;
             //
+            // Jets that can not have corrected pT above min_pt are not
+            // corrected if the max correction is set: corrected p4 is
+            // invalid and MET is passed unchanged. Prefilter is off if
+            // systematics is loaded since JES shift changes MET
+            //
             CorrectedJet correctJet(const Jet *,
                     const Event *,
                     const Electrons &,
                     const Muons &,
-                    const LorentzVector *met);
+                    const LorentzVector *met,
+                    const float &min_pt = 0);
 
             // Jet Energy Correction Delegate interface
             //
@@ -127,6 +145,8 @@ namespace bsm
             virtual void setSystematic(const Systematic &,
                     const std::string &filename);
 
+            virtual void setMaxCorrection(const float &);
+
             // Object interface
             //
             virtual void print(std::ostream &) const;
@@ -137,6 +157,7 @@ namespace bsm
             typedef boost::shared_ptr<JetCorrectionUncertainty> SystematicPtr;
 
             CorrectorPtr corrector();
+            bool isSoft(const LorentzVector &, const float &min_pt) const;
             void correct(CorrectedJet &, const Event *, const LorentzVector *met);
 
             virtual void cleanJet(CorrectedJet &,
@@ -151,6 +172,8 @@ namespace bsm
             SystematicPtr _systematic;
             std::string _systematic_file;
             int _systematic_direction;
+
+            float _max_correction;
     };
 
     class DeltaRJetEnergyCorrections: public JetEnergyCorrections
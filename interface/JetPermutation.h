@@ -9,23 +9,30 @@
 #include <stdint.h>
 
 #include <vector>
-#include <map>
-
-#include <boost/shared_ptr.hpp>
 
 #include "bsm_input/interface/bsm_input_fwd.h"
-#include "bsm_stat/interface/bsm_stat_fwd.h"
 
 namespace bsm
 {
+    // Loop over all pairs of non-overlapping non-empty sets of leptonic and
+    // hadronic jets. Sets are encoded as bitmasks of jet indices: every
+    // combination is kept once in a table and is used twice with sets
+    // swapped. Tables are generated once per number of jets
+    //
     class JetPermutation
     {
         public:
             typedef std::vector<const Jet *> Jets;
 
+            enum
+            {
+                MAX_JETS = 16
+            };
+
             JetPermutation();
 
-            // Initialize with array of jets
+            // Initialize with array of jets. Exception is thrown if there
+            // are more than MAX_JETS jets
             //
             void init(const Jets &jets);
 
@@ -37,54 +44,35 @@ namespace bsm
             Jets hadronicJets();
 
         private:
+            // Masks of jet indices
+            //
             struct Combination
             {
-                Combination(): left(1), right(1)
+                Combination(const uint16_t &left, const uint16_t &right):
+                    left(left),
+                    right(right)
                 {
                 }
 
-                bool operator ==(const Combination &object)
-                {
-                    return (object.left == left
-                            && object.right == right)
-
-                        || (object.left == right
-                            && object.right == left);
-                }
-
-                uint64_t left;  // leptonic
-                uint64_t right; // hadronic
+                uint16_t left;  // leptonic
+                uint16_t right; // hadronic
             };
 
-            // map<PrimeNumber, vector ID>
-            //
-            typedef std::map<uint32_t, uint32_t> PrimeIDs;
-
-            // collection of all permutations: prime number products
+            // collection of all permutations
             //
             typedef std::vector<Combination> Permutations;
 
-            // all possible permutations for different multiplicities
-            //
-            typedef std::map<uint32_t, Permutations> PermutationTables;
-
-
-
-            // Convert product of prime numbers to jets
+            // Convert mask of jet indices to jets
             //
-            Jets jets(uint64_t product);
+            Jets jets(uint32_t mask) const;
 
             void generatePermutations(const uint32_t &size);
-            void expandPrimeIDs(const uint32_t &size);
-
-
 
-            boost::shared_ptr<stat::PrimeNumber> _prime_generator;
-            
             const Jets *_jets;
 
-            PrimeIDs _prime_id;
-            PermutationTables _permutation_tables;
+            // all possible permutations for different multiplicities
+            //
+            Permutations _permutation_tables[MAX_JETS + 1];
 
             Permutations::const_iterator _current_permutation;
             Permutations::const_iterator _end_permutation;
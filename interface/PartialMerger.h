@@ -0,0 +1,96 @@
+// Partial Merger
+//
+// Reduce partial results of the shards into one analyzer. Partial results
+// are loaded in parallel threads: every thread merges its share of files
+// into the own clone of the analyzer. Clones are merged at the end.
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#ifndef BSM_PARTIAL_MERGER
+#define BSM_PARTIAL_MERGER
+
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "bsm_core/interface/Thread.h"
+#include "interface/bsm_fwd.h"
+
+namespace bsm
+{
+    class PartialLoadOperation : public core::Operation
+    {
+        public:
+            typedef boost::shared_ptr<Analyzer> AnalyzerPtr;
+            typedef std::vector<std::string> Inputs;
+
+            // Analyzer should implement CheckpointDelegate
+            //
+            PartialLoadOperation(const AnalyzerPtr &prototype,
+                    const Inputs &partials);
+
+            // Should only be used after thread is joined
+            //
+            AnalyzerPtr analyzer() const;
+            const Inputs &processed() const;
+
+            uint32_t failed() const;
+
+            // Operation interface
+            //
+            virtual void run();
+            virtual void stop();
+
+            virtual void onThreadInit(core::Thread *);
+
+        private:
+            bool isContinue() const;
+
+            core::Thread *_thread;
+
+            const AnalyzerPtr _prototype;
+            const Inputs _partials;
+
+            AnalyzerPtr _analyzer;
+            Inputs _processed;
+            uint32_t _failed;
+
+            boost::atomic<bool> _continue;
+    };
+
+    class PartialMerger
+    {
+        public:
+            typedef boost::shared_ptr<Analyzer> AnalyzerPtr;
+            typedef std::vector<std::string> Inputs;
+
+            PartialMerger(const AnalyzerPtr &prototype,
+                    const uint32_t &max_threads = 0);
+
+            // Load and merge partial results. False is returned if any
+            // partial result can not be loaded
+            //
+            bool merge(const Inputs &partials);
+
+            AnalyzerPtr analyzer() const;
+
+            // Input files processed by all the shards
+            //
+            const Inputs &processed() const;
+
+        private:
+            typedef boost::shared_ptr<PartialLoadOperation>
+                PartialLoadOperationPtr;
+
+            const AnalyzerPtr _prototype;
+            const uint32_t _max_threads;
+
+            AnalyzerPtr _analyzer;
+            Inputs _processed;
+    };
+}
+
+#endif
@@ -100,6 +100,11 @@ namespace bsm
             //
             virtual bool apply(const Jet &);
 
+            // Test jet with given p4, e.g. corrected: jet is not copied to
+            // change its p4
+            //
+            virtual bool apply(const Jet &, const LorentzVector &);
+
             // Object interface
             //
             virtual uint32_t id() const;
@@ -228,6 +233,11 @@ namespace bsm
             //
             virtual bool apply(const Jet &);
 
+            // Test jet with given p4, e.g. corrected: jet is not copied to
+            // change its p4
+            //
+            virtual bool apply(const Jet &, const LorentzVector &);
+
             // Object interface
             //
             virtual uint32_t id() const;
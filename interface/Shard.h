@@ -0,0 +1,69 @@
+// Shard
+//
+// Select part of the inputs to be processed by one of N jobs. Shards are
+// deterministic: the same inputs always give the same selection. Input
+// files are distributed between shards, or every file is split into N
+// event ranges if events are split.
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#ifndef BSM_SHARD
+#define BSM_SHARD
+
+#include <string>
+#include <vector>
+
+#include "interface/Thread.h"
+
+namespace bsm
+{
+    class Shard
+    {
+        public:
+            typedef std::vector<std::string> Inputs;
+
+            // Default shard processes all inputs
+            //
+            Shard();
+
+            // Shard is given in format: i/N, where i = 0 .. N - 1. False is
+            // returned if shard can not be parsed
+            //
+            bool parse(const std::string &);
+
+            uint32_t index() const;
+            uint32_t shards() const;
+
+            bool isSharded() const;
+
+            // Split every input file into event ranges instead of
+            // distributing files between shards
+            //
+            void setSplitEvents(const bool &);
+            bool isSplitEvents() const;
+
+            // Input files of the shard. Files are sorted by name to make
+            // selection independent of the inputs order
+            //
+            Inputs select(const Inputs &) const;
+
+            // Range of the file events to be processed by the shard. The
+            // number of events is read from the file header: file without
+            // events in header is processed by the first shard only
+            //
+            EventRange range(const std::string &file_name) const;
+
+            // Shard in format: i/N
+            //
+            std::string name() const;
+
+        private:
+            uint32_t _index;
+            uint32_t _shards;
+
+            bool _split_events;
+    };
+}
+
+#endif
@@ -21,6 +21,7 @@
 #include "interface/CorrectedJet.h"
 #include "interface/TriggerAnalyzer.h"
 #include "interface/Cache.h"
+#include "interface/ToptagWeight.h"
 
 #include "interface/RandomGenerator.h"
 
@@ -58,6 +59,8 @@ namespace bsm
 
             virtual void setLtopPt(const float &) {}
             virtual void setChi2Discriminator(const float &) {}
+
+            virtual void setCutflowTiming(const bool &) {}
     };
 
     class SynchSelectorOptions:
@@ -87,6 +90,8 @@ namespace bsm
 
             void setChi2Discriminator(const float &);
 
+            void setCutflowTiming(const bool &);
+
             DescriptionPtr _description;
     };
 
@@ -99,6 +104,7 @@ namespace bsm
             typedef boost::shared_ptr<Cut> CutPtr;
             typedef boost::shared_ptr<LorentzVector> LorentzVectorPtr;
             typedef boost::shared_ptr<MultiplicityCutflow> CutflowPtr;
+            typedef boost::shared_ptr<CutflowTimer> CutflowTimerPtr;
             typedef boost::shared_ptr<RandomGenerator<> > RandomGeneratorPtr;
 
             typedef std::vector<const PrimaryVertex *> GoodPrimaryVertices;
@@ -133,6 +139,15 @@ namespace bsm
                 SELECTIONS // this item should always be the last one
             };
 
+            // Timed stages that are not part of the cutflow
+            //
+            enum TimingStage
+            {
+                LEPTON_ID = SELECTIONS,
+
+                TIMING_STAGES // this item should always be the last one
+            };
+
             SynchSelector();
             SynchSelector(const SynchSelector &);
 
@@ -156,8 +171,21 @@ namespace bsm
             //
             virtual bool apply(const Event *);
 
+            // Apply selector as a tail of the prefix selector that was just
+            // applied to the same event: selections before HTLEP are taken
+            // from the prefix and only HTLEP, TRICUT and MET are tested.
+            // Both selectors should share configuration of the prefix
+            // selections, e.g. tail is a clone with inverted htlep cut
+            //
+            bool apply(const Event *, const SynchSelector &prefix);
+
             CutflowPtr cutflow() const;
 
+            // Time and calls of every selection stage. Analyzers should
+            // time reconstruction with RECONSTRUCTION stage
+            //
+            CutflowTimerPtr timer() const;
+
             const GoodPrimaryVertices &goodPrimaryVertices() const;
             const GoodElectrons &goodElectrons() const;
             const GoodMuons &goodMuons() const;
@@ -199,6 +227,8 @@ namespace bsm
 
             virtual void setChi2Discriminator(const float &);
 
+            virtual void setCutflowTiming(const bool &);
+
             // Jet Energy Correction Delegate interface
             //
             virtual void setCorrection(const Level &,
@@ -209,19 +239,32 @@ namespace bsm
 
             virtual void setChildCorrection();
 
+            virtual void setMaxCorrection(const float &);
+            virtual void setValidatePrefilter(const bool &);
+
             // Trigger Delegater interface
             //
             virtual void setTrigger(const Trigger &trigger);
 
+            // Take positions of the triggers in the event HLT list from
+            // the file trigger menu. Positions are verified in every event
+            // and triggers are searched for only if they moved
+            //
+            void setTriggerMenu(const Input *);
+
             // Set the use of toptag by weight
             void useToptagWeight();
 
             // Return true if toptag by weight is used
             bool isToptagWeight() const;
 
-            // Compute toptag weight and update jet mass
+            // Compute toptag weight: probability of at least one tagged
+            // CA jet
             float toptagWeight();
 
+            // Probability of exactly given number of tagged CA jets
+            float toptagWeight(const uint32_t &tags);
+
             // Selector interface
             //
             // Note: empty at the moment
@@ -244,9 +287,27 @@ namespace bsm
             bool missingEnergy(const Event *);
             
         private:
+            // Count event in the cutflow and remember the selection for
+            // the tail selectors
+            //
+            void passSelection(const Selection &);
+
+            bool tail(const Event *);
+
             bool triggers(const Event *);
+            const Trigger *findTrigger(const Event *, const uint32_t &index);
             bool primaryVertices(const Event *);
             bool jets(const Event *);
+
+            // pT threshold of jets that skip energy corrections and check
+            // of the skipped jet with full corrections
+            //
+            float jecPrefilterPt() const;
+            void validateJecPrefilter(const Jet *,
+                    const Event *,
+                    const LorentzVector *met,
+                    const float &min_pt);
+
             bool lepton();
             bool secondElectronVeto();
             bool secondMuonVeto();
@@ -257,6 +318,8 @@ namespace bsm
             bool toptagCut();
             bool htlepCut(const Event *);
 
+            const ToptagWeight &toptagWeights();
+
             void selectGoodPrimaryVertices(const Event *);
             void selectGoodElectrons(const Event *);
             void selectGoodMuons(const Event *);
@@ -264,12 +327,11 @@ namespace bsm
             bool cut2D(const LorentzVector *);
             bool isolation(const LorentzVector *, const PFIsolation *);
 
-            void invalidate_cache();
-
             LeptonMode _lepton_mode;
             CutMode _cut_mode;
 
             CutflowPtr _cutflow;
+            CutflowTimerPtr _timer;
 
             boost::shared_ptr<PrimaryVertexSelector> _primary_vertex_selector;
             boost::shared_ptr<ElectronSelector> _electron_selector;
@@ -306,19 +368,30 @@ namespace bsm
 
             bool _qcd_template;
             bool _wjets_template;
+            bool _validate_jec_prefilter;
 
             typedef std::vector<uint64_t> Triggers;
             Triggers _triggers; // hashes of triggers to be passed
+
+            typedef std::vector<int> TriggerPositions;
+            TriggerPositions _trigger_positions; // -1 if position is unknown
             
             bool _weighted_toptag;
 
+            // Selections passed in the current event: bit per Selection
+            //
+            uint32_t _passed_selections;
+            bool _prefix_passed;
+
             RandomGeneratorPtr _random_generator; 
 
             boost::shared_ptr<Btag> _btag;
 
             // cache
             //
-            Cache<uint32_t> _btagged_jets;
+            EventGeneration _event_generation;
+            EventCache<uint32_t> _btagged_jets;
+            EventCache<ToptagWeight> _toptag_weight;
     };
 
     // Helpers
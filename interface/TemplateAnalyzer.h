@@ -22,8 +22,10 @@
 #include "interface/Algorithm.h"
 #include "interface/Analyzer.h"
 #include "interface/AppController.h"
+#include "interface/Cache.h"
 #include "interface/Cut.h"
 #include "interface/DecayGenerator.h"
+#include "interface/HistogramBookkeeper.h"
 #include "interface/Pileup.h"
 #include "interface/SynchSelector.h"
 #include "interface/bsm_fwd.h"
@@ -129,6 +131,34 @@ namespace bsm
             {
             }
 
+            virtual void setPrunedReconstruction()
+            {
+            }
+
+            virtual void setIncrementalReconstruction()
+            {
+            }
+
+            virtual void setBatchChi2Reconstruction()
+            {
+            }
+
+            virtual void setShootoutReconstruction()
+            {
+            }
+
+            virtual void setReconstructionMaxJets(const uint32_t &)
+            {
+            }
+
+            virtual void setReconstructionKeepBtags()
+            {
+            }
+
+            virtual void setTruncationReport()
+            {
+            }
+
             typedef Chi2ResonanceReconstructor::Chi2Discriminators
                 Chi2Discriminators;
 
@@ -163,6 +193,13 @@ namespace bsm
             void setCollimatedSimpleReconstructionWithMass();
             void setCollimatedSimpleReconstructionWithTopMass();
             void setReconstructionWithCollimatedTops();
+            void setPrunedReconstruction();
+            void setIncrementalReconstruction();
+            void setBatchChi2Reconstruction();
+            void setShootoutReconstruction();
+            void setReconstructionMaxJets(const uint32_t &);
+            void setReconstructionKeepBtags();
+            void setTruncationReport();
             void setChi2Reconstruction(const std::string &);
 
             TemplatesDelegate *_delegate;
@@ -205,6 +242,13 @@ namespace bsm
             virtual void setCollimatedSimpleReconstructionWithMass();
             virtual void setCollimatedSimpleReconstructionWithTopMass();
             virtual void setReconstructionWithCollimatedTops();
+            virtual void setPrunedReconstruction();
+            virtual void setIncrementalReconstruction();
+            virtual void setBatchChi2Reconstruction();
+            virtual void setShootoutReconstruction();
+            virtual void setReconstructionMaxJets(const uint32_t &);
+            virtual void setReconstructionKeepBtags();
+            virtual void setTruncationReport();
             virtual void setChi2Reconstruction(const Chi2Discriminators &ltop,
                                                const Chi2Discriminators &htop);
 
@@ -277,6 +321,20 @@ namespace bsm
 
             const P4MonitorPtr ltopJet1() const;
 
+            // Mttbar templates of every shootout reconstructor:
+            // mttbar_before_htlep_<name>, mttbar_after_htlep_<name>
+            //
+            const boost::shared_ptr<HistogramBookkeeper>
+                shootoutTemplates() const;
+
+            // Jets truncation report: truncated_njets (events with dropped
+            // jets), truncation_changed_njets (events with different best
+            // hypothesis than reconstructed with all jets) and
+            // truncation_mttbar_shift (truncated - all jets mttbar, TeV)
+            //
+            const boost::shared_ptr<HistogramBookkeeper>
+                truncationReport() const;
+
             JetEnergyCorrectionDelegate *getJetEnergyCorrectionDelegate() const;
             SynchSelectorDelegate *getSynchSelectorDelegate() const;
             Cut2DSelectorDelegate *getCut2DSelectorDelegate() const;
@@ -311,11 +369,32 @@ namespace bsm
             void fillDrVsPtrel();
             void fillHtlep();
 
-            Mttbar mttbar() const;
+            // Reconstruction is run at most once per event
+            //
+            const Mttbar &mttbar();
+            Mttbar reconstruct() const;
+
+            // Reconstruct mttbar with all jets and compare with the result
+            // of truncated jets
+            //
+            void reportTruncation(const Mttbar &);
+            bool isSameHypothesis(const Mttbar &, const Mttbar &) const;
+
             void monitorJets();
 
-            float htlepValue() const;
-            float htallValue() const;
+            // Reconstruct mttbar with all shootout reconstructors and fill
+            // templates of those that pass selector reconstruction cuts
+            //
+            void fillShootout(const SynchSelector &,
+                              const std::string &prefix,
+                              const bool &apply_chi2);
+
+            // Replace reconstructor and keep the hypotheses search
+            //
+            void setReconstructor(ResonanceReconstructor *);
+
+            float htlepValue();
+            float htallValue();
 
             bool isGoodLepton() const;
 
@@ -376,6 +455,13 @@ namespace bsm
 
             const Event *_event;
 
+            // Event-scoped caches: no need to invalidate between events
+            //
+            EventGeneration _event_generation;
+            EventCache<Mttbar> _mttbar;
+            EventCache<float> _htlep_value;
+            EventCache<float> _htall_value;
+
             Counter *_secondary_lepton_counter;
             Counter *_leading_jet_counter;
             Counter *_htlep_counter;
@@ -416,6 +502,22 @@ namespace bsm
             H1ProxyPtr _njet2_dr_lepton_jet2_after_reconstruction;
 
             boost::shared_ptr<ResonanceReconstructor> _reconstructor;
+            ResonanceReconstructor::Search _reconstruction_search;
+            bool _batch_chi2_reconstruction;
+
+            boost::shared_ptr<ResonanceShootout> _shootout;
+            boost::shared_ptr<HistogramBookkeeper> _shootout_templates;
+
+            // Shootout is cut with copies of the selector cuts: the cutflow
+            // is not affected
+            //
+            CutPtr _shootout_reconstruction;
+            CutPtr _shootout_ltop;
+            CutPtr _shootout_chi2;
+
+            boost::shared_ptr<JetTruncation> _jet_truncation;
+            boost::shared_ptr<HistogramBookkeeper> _truncation_report;
+            bool _report_truncation;
     };
 }
 
@@ -8,13 +8,21 @@
 #ifndef BSM_THREAD
 #define BSM_THREAD
 
+#include <climits>
+#include <deque>
+#include <map>
 #include <queue>
 #include <stack>
 #include <string>
+#include <vector>
 
+#include <boost/atomic.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include "interface/bsm_fwd.h"
+#include "interface/EventPool.h"
+#include "interface/EventQueue.h"
 #include "bsm_core/interface/bsm_core_fwd.h"
 #include "bsm_core/interface/Thread.h"
 #include "bsm_input/interface/Reader.h"
@@ -25,6 +33,44 @@ namespace bsm
     class ThreadController;
 
     typedef boost::shared_ptr<Analyzer> AnalyzerPtr;
+    typedef boost::shared_ptr<EventQueue> EventQueuePtr;
+
+    // Range of events in the input file: [first, last). The last event
+    // stays unbounded until the number of events in the file is known.
+    // Bytes is the estimated size of the range on disk and is used to
+    // predict the processing time
+    //
+    struct EventRange
+    {
+        EventRange(const std::string &file_name = "",
+                const uint32_t &first = 0,
+                const uint32_t &last = UINT_MAX);
+
+        bool empty() const;
+        bool isBounded() const;
+
+        uint32_t size() const;
+
+        std::string file_name;
+        uint32_t first;
+        uint32_t last;
+
+        uint64_t bytes;
+    };
+
+    // Controller gives the state of analyzers merged over completely
+    // processed input files to the delegate, e.g. to save checkpoint
+    //
+    class SnapshotDelegate
+    {
+        public:
+            typedef std::vector<std::string> Inputs;
+
+            virtual ~SnapshotDelegate() {}
+
+            virtual void onSnapshot(const AnalyzerPtr &analyzer,
+                    const Inputs &processed) = 0;
+    };
 
     // Keyaboard Thread: watch for keyboard input and report to the controller
     //
@@ -60,6 +106,35 @@ namespace bsm
             boost::shared_ptr<core::Keyboard> _keyboard_controller;
     };
 
+    // Stats Thread: periodically ask the controller to write the job
+    // throughput into the stats file
+    //
+    class StatsOperation : public core::Operation
+    {
+        public:
+            // Period is given in seconds
+            //
+            StatsOperation(ThreadController *controller,
+                    const uint32_t &period);
+
+            // Operation interface
+            //
+            virtual void run();
+            virtual void stop();
+
+            virtual void onThreadInit(core::Thread *);
+
+        private:
+            bool isContinue() const;
+
+            core::Thread *_thread;
+            ThreadController *_controller;
+
+            const uint32_t _period;
+
+            boost::atomic<bool> _continue;
+    };
+
     // Analyzer Thread: perform the analysis
     //
     class AnalyzerOperation : public core::Operation,
@@ -76,15 +151,57 @@ namespace bsm
             void use(ThreadController *controller);
             void use(const AnalyzerPtr &analyzer);
 
+            // Analyzer will process events from the queue instead of
+            // reading input files
+            //
+            void use(const EventQueuePtr &queue);
+
             void setReaderDelegate(ReaderDelegate *);
             ReaderDelegate *readerDelegate() const;
 
             AnalyzerPtr analyzer() const;
 
-            // Scheule file for processing. Method does nothing is file
-            // is already set but processing didn't start
+            // Replace analyzer while thread is waiting for instructions. The
+            // previous analyzer is returned
+            //
+            AnalyzerPtr swap(const AnalyzerPtr &analyzer);
+
+            // Scheule file (or range of events in the file) for processing.
+            // Method does nothing is file is already set but processing
+            // didn't start
             //
             bool init(const std::string &file_name);
+            bool init(const EventRange &range);
+
+            // Number of events left in the range that is being processed.
+            // Zero is returned if the range is unbounded
+            //
+            uint32_t eventsLeft() const;
+
+            // Split the range that is being processed in halves: the
+            // operation keeps the first half and the second one is
+            // returned. Empty range is returned if there are less than
+            // min_events left
+            //
+            EventRange steal(const uint32_t &min_events);
+
+            // The last range that was completely processed
+            //
+            EventRange processedRange() const;
+
+            // Load predicted by the Controller and the actual load of the
+            // thread. Predicted load and busy time should only be accessed
+            // when thread is not running
+            //
+            void setPredictedLoad(const uint64_t &bytes);
+            uint64_t predictedLoad() const;
+
+            double busyTime() const;
+
+            // Estimated size of processed events in the input files. The
+            // value is updated with every event
+            //
+            uint64_t bytesProcessed() const;
 
             // Operation interface
             //
@@ -104,8 +221,16 @@ namespace bsm
             //
             virtual void onRunLoopCommand(const uint32_t &);
 
+            // Processed events and their total size are updated with every
+            // event. Size is the share of the input file size: events are
+            // not measured
+            //
             uint32_t eventsProcessed() const;
-            uint32_t totalEventsSize() const;
+            uint64_t totalEventsSize() const;
+
+            // Number of events allocated by the thread events pool
+            //
+            uint32_t eventsAllocated() const;
 
         private:
             typedef boost::shared_ptr<Reader> ReaderPtr;
@@ -113,10 +238,15 @@ namespace bsm
             core::Thread *thread() const;
 
             bool isRunning() const;
-            // isContinue is called only when thread is running and therefore
-            // uses lock
+
+            // isContinue is called for every event and does not lock
             //
             bool isContinue() const;
+
+            // Move cursor to the next event in the range. False is
+            // returned if the end of range is reached
+            //
+            bool nextEvent(uint32_t &event);
             bool isFileEmpty() const;
 
             // hasAnalyzer/Controller are only called when thread is running.
@@ -133,6 +263,10 @@ namespace bsm
             //
             void processFile();
 
+            // Apply analyzer to events from the queue until it is drained
+            //
+            void processQueue();
+
             // Wait for new instructions from Controller
             //
             void waitForInstructions();
@@ -140,17 +274,100 @@ namespace bsm
             core::Thread *_thread;
             ThreadController *_controller;
 
-            bool _continue;
+            boost::atomic<bool> _continue;
 
             AnalyzerPtr _analyzer;
-            std::string _file_name;
+            EventQueuePtr _queue;
+
+            EventRange _range;      // scheduled range
+            EventRange _current;    // range that is being processed
+            EventRange _processed;  // the last processed range
+
+            // next event index and end of the current range
+            //
+            boost::atomic<uint64_t> _cursor;
 
-            uint32_t _events_processed;
-            uint32_t _total_events_size;
+            boost::atomic<uint32_t> _events_processed;
+
+            EventPool _events;  // reused between input files
+            boost::atomic<uint64_t> _total_events_size;
+
+            uint64_t _predicted_load;   // bytes
+            boost::atomic<uint64_t> _bytes_processed;
+            double _busy_time;          // seconds
 
             ReaderDelegate *_reader_delegate;
     };
 
+    // Reader Thread: decode events from input files and push these into the
+    // queue for analyzer threads
+    //
+    class ReaderOperation : public core::Operation
+    {
+        public:
+            ReaderOperation(ThreadController *controller,
+                    const EventQueuePtr &queue);
+
+            // Should only be used after thread is joined
+            //
+            uint32_t filesRead() const;
+
+            // Size of read input files is updated with every file
+            //
+            uint64_t bytesRead() const;
+
+            // Operation interface
+            //
+            virtual void run();
+            virtual void stop();
+
+            virtual void onThreadInit(core::Thread *);
+
+        private:
+            bool isContinue() const;
+
+            void readFile(const EventRange &range);
+
+            core::Thread *_thread;
+            ThreadController *_controller;
+
+            EventQueuePtr _queue;
+
+            boost::atomic<bool> _continue;
+
+            uint32_t _files_read;
+            boost::atomic<uint64_t> _bytes_read;
+    };
+
+    // Merge Thread: merge two analyzers of finished threads and report
+    // result to the controller
+    //
+    class MergeOperation : public core::Operation
+    {
+        public:
+            MergeOperation(ThreadController *controller,
+                    const AnalyzerPtr &analyzer,
+                    const AnalyzerPtr &other_analyzer);
+
+            // Merged analyzer. Should only be used after thread is joined
+            //
+            AnalyzerPtr analyzer() const;
+
+            // Operation interface
+            //
+            virtual void run();
+            virtual void stop();
+
+            virtual void onThreadInit(core::Thread *);
+
+        private:
+            core::Thread *_thread;
+            ThreadController *_controller;
+
+            AnalyzerPtr _analyzer;
+            AnalyzerPtr _other_analyzer;
+    };
+
     class ThreadController
     {
         public:
@@ -164,19 +381,62 @@ namespace bsm
 
             bool isAnalyzerReaderDelegate() const;
 
+            // Decode events in separate reader threads. Analyzer threads
+            // process events from the queue of given depth
+            //
+            void usePipeline(const uint32_t &readers,
+                    const uint32_t &queue_depth);
+
+            bool isPipeline() const;
+
+            // Give the merged state to the delegate every given number of
+            // completely processed input files. Snapshot starts from the
+            // state, e.g. of the resumed checkpoint, which is merged into
+            // the analyzer at the end. Threads take a new analyzer after
+            // every range and the pipeline is not used
+            //
+            void useSnapshots(SnapshotDelegate *delegate,
+                    const uint32_t &files,
+                    const AnalyzerPtr &state = AnalyzerPtr());
+
+            bool isSnapshots() const;
+
             // Schedule file for processing
             //
             void push(const std::string &file_name);
 
+            // Schedule range of file events for processing
+            //
+            void push(const EventRange &range);
+
+            // Reader threads take input files with this method. Empty
+            // range is returned if no input files are left
+            //
+            EventRange nextInput();
+
             // Start processing scheduled files
             //
             void start();
 
             void threadIsWaiting(core::Thread *);
 
+            // Merge thread calls this method with controller locked
+            //
+            void mergeIsDone(core::Thread *);
+
             void quit();
             void info();
 
+            // Write throughput of the running job into the file every
+            // period (in seconds)
+            //
+            void useStats(const std::string &file_name,
+                    const uint32_t &period);
+
+            // Stats thread calls this method
+            //
+            void writeStats();
+
         private:
             // Test if any input files left for processing
             //
@@ -184,14 +444,37 @@ namespace bsm
             bool hasAnalyzer() const;
 
             // Return maximum number of threads to be created:
-            //  min(CORES, Input FILES)
+            //  min(CORES, Input RANGES)
             //
             uint32_t countMaxThreads();
 
+            // Schedule input files longest-first using the file size
+            //
+            void sortInputs();
+
+            // Split input files into event ranges if there are fewer files
+            // than threads. Number of events is read from the file header
+            //
+            void splitInputs();
+
+            // Assign ranges to threads with longest-processing-time-first
+            // rule: the plan is used to report the predicted thread load
+            //
+            void planLoad();
+
+            // Take half of the remaining events from the busiest thread
+            //
+            EventRange steal(core::Thread *thief);
+
             // Create new thread, instruct and start
             //
             void addThread();
 
+            // Reader threads are only used in pipeline mode
+            //
+            void addReaderThread();
+            void joinReaderThreads();
+
             void instruct(AnalyzerOperation *operation);
 
             void run();
@@ -199,15 +482,33 @@ namespace bsm
 
             bool isRunning() const;
 
+            bool hasWaitingThreads() const;
+
             void onThreadWait();
             core::Thread *waitingThread();
 
+            // Analyzers of finished threads are merged pairwise in separate
+            // threads while the rest of the threads are still running
+            //
+            void reduce(const AnalyzerPtr &analyzer);
+            void onMergeDone();
+
+            // Analyzer of the processed range is kept until all ranges of
+            // the file are done and then merged into the snapshot
+            //
+            void onRangeDone(AnalyzerOperation *operation);
+            void snapshot();
+
             void startKeyboardThread();
             void stopKeyboardThread();
 
+            void startStatsThread();
+            void stopStatsThread();
+
             // Typedefs
             //
-            typedef std::queue<std::string> InputFiles; // FIFO
+            typedef std::deque<EventRange> InputFiles; // FIFO
+            typedef std::vector<uint64_t> Loads;
 
             typedef boost::shared_ptr<core::Thread> ThreadPtr;
 
@@ -216,22 +517,79 @@ namespace bsm
 
             typedef boost::shared_ptr<ThreadsFIFO> ThreadsFIFOPtr;
 
+            // Thread counters at the time of the last stats sample
+            //
+            struct Sample
+            {
+                Sample();
+
+                uint32_t id;
+                uint64_t events;
+                uint64_t events_size;
+            };
+
+            typedef std::map<core::Thread *, Sample> Samples;
+
             // Properties
             //
             const uint32_t _max_threads;
 
+            // Ranges with fewer events are not split any further
+            //
+            const uint32_t _min_range_size;
+
             core::ConditionPtr _condition;
             boost::shared_ptr<InputFiles> _input_files;
 
             Threads _threads;
             ThreadsFIFOPtr _threads_waiting;
+
+            Loads _predicted_load;  // bytes per thread
+
+            uint32_t _readers;
+            uint32_t _queue_depth;
+
+            EventQueuePtr _queue;
+            Threads _reader_threads;
+
+            typedef std::stack<AnalyzerPtr> Analyzers;
+
+            Analyzers _analyzers_to_merge;
+            Threads _merge_threads;
+            ThreadsFIFOPtr _merges_done;
             ThreadPtr _keyboard_thread;
 
             AnalyzerPtr _analyzer;
 
             boost::shared_ptr<Summary> _summary;
 
+            uint64_t _input_bytes;
+
+            std::string _stats_file;
+            uint32_t _stats_period;
+            ThreadPtr _stats_thread;
+
+            Samples _stats_samples;
+            uint32_t _stats_threads;
+            boost::posix_time::ptime _start_time;
+            boost::posix_time::ptime _stats_time;
+
             bool _analyzer_is_reader_delegate;
+
+            // Ranges left and analyzers of processed ranges per input file
+            //
+            typedef std::map<std::string, uint32_t> RangesLeft;
+            typedef std::multimap<std::string, AnalyzerPtr> RangeAnalyzers;
+
+            SnapshotDelegate *_snapshot_delegate;
+            uint32_t _snapshot_files;
+            AnalyzerPtr _snapshot;
+
+            RangesLeft _ranges_left;
+            RangeAnalyzers _range_analyzers;
+
+            SnapshotDelegate::Inputs _snapshot_inputs;
+            uint32_t _snapshot_pending;
     };
 }
 
@@ -0,0 +1,65 @@
+// Top-tag by weight: every CA jet is top-tagged with pT dependent
+// probability. Event weight is the probability of the tagged jets
+// multiplicity: at least one tag or exactly k tags
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#ifndef BSM_TOPTAG_WEIGHT
+#define BSM_TOPTAG_WEIGHT
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "interface/CorrectedJet.h"
+
+namespace bsm
+{
+    class ToptagWeight
+    {
+        public:
+            typedef std::vector<CorrectedJet> Jets;
+
+            ToptagWeight();
+
+            // Tag probability of the CA jet with given pT
+            //
+            static float probability(const float &pt);
+
+            void clear();
+
+            // Add jet with given tag probability
+            //
+            void add(const float &probability);
+
+            // Add jets with pT dependent tag probabilities
+            //
+            void add(const Jets &);
+
+            uint32_t size() const;
+
+            // Probability of at least one tagged jet. It is updated with
+            // every added jet
+            //
+            float atLeastOne() const;
+
+            // Probability of exactly given number of tagged jets. The
+            // distribution is calculated on first use
+            //
+            float exactly(const uint32_t &tags) const;
+
+        private:
+            typedef std::vector<double> Probabilities;
+
+            Probabilities _probabilities;
+
+            double _at_least_one;
+
+            // Probability of k tagged jets is kept at index k
+            //
+            mutable Probabilities _multiplicity;
+    };
+}
+
+#endif
@@ -20,6 +20,7 @@
 #include "interface/bsm_fwd.h"
 #include "interface/Analyzer.h"
 #include "interface/AppController.h"
+#include "interface/Checkpoint.h"
 
 namespace bsm
 {
@@ -59,16 +60,23 @@ namespace bsm
             DescriptionPtr _description;
     };
 
-    class TriggerAnalyzer : public Analyzer
+    class TriggerAnalyzer : public Analyzer,
+        public CheckpointDelegate
     {
         public:
             TriggerAnalyzer();
+            TriggerAnalyzer(const TriggerAnalyzer &);
 
             // Analyzer interface
             //
             virtual void onFileOpen(const std::string &filename, const Input *);
             virtual void process(const Event *);
 
+            // Checkpoint Delegate interface
+            //
+            virtual void save(std::ostream &) const;
+            virtual bool load(std::istream &);
+
             // Object interface
             //
             virtual uint32_t id() const;
@@ -87,8 +95,15 @@ namespace bsm
 
             typedef std::map<Trigger, uint32_t> HLTCutflow;
 
+            // Cutflow counter of trigger at every position in the event HLT
+            // list. Counter is looked up only if trigger at the position
+            // changed
+            //
+            typedef std::vector<HLTCutflow::iterator> HLTCounters;
+
             HLTMap _hlt_map;
             HLTCutflow _hlt_cutflow;
+            HLTCounters _hlt_counters;
     };
 
     // Helpers
@@ -26,6 +26,20 @@ namespace bsm
     class Summary
     {
         public:
+            // Predicted and actual load of the analyzer thread
+            //
+            struct ThreadLoad
+            {
+                ThreadLoad();
+
+                uint64_t predicted_bytes;
+                uint64_t processed_bytes;
+                uint32_t events;
+                double busy_time;   // seconds
+            };
+
+            typedef std::vector<ThreadLoad> ThreadLoads;
+
             Summary(const uint32_t &files_total);
 
             uint64_t eventsProcessed() const
@@ -57,17 +71,52 @@ namespace bsm
 
             void addFilesProcessed();
 
-            void addEventsSize(const uint32_t &size)
+            uint64_t totalEventsSize() const
+            {
+                return _total_events_size;
+            }
+
+            void addEventsSize(const uint64_t &size)
             {
                 _total_events_size += size;
             }
 
+            uint32_t eventsAllocated() const
+            {
+                return _events_allocated;
+            }
+
+            void addEventsAllocated(const uint32_t &events)
+            {
+                _events_allocated += events;
+            }
+
+            // Heap allocations per processed event since the summary is
+            // created. Only available if allocations are counted
+            //
+            double allocationsPerEvent() const;
+
+            const ThreadLoads &threadLoads() const
+            {
+                return _thread_loads;
+            }
+
+            void addThreadLoad(const ThreadLoad &load)
+            {
+                _thread_loads.push_back(load);
+            }
+
         private:
             uint64_t _events_processed;
             const uint32_t _files_total;
             uint32_t _files_processed;
             uint64_t _total_events_size;
             uint32_t _percent_done;
+
+            uint32_t _events_allocated;
+            uint64_t _allocations;
+
+            ThreadLoads _thread_loads;
     };
 
     std::ostream &operator <<(std::ostream &, const Summary &);
@@ -27,6 +27,7 @@ namespace bsm
     class Counter;
     class CounterDelegate;
     class Cut;
+    class CutflowTimer;
     template<class Compare> class Comparator;
     template<class LowerCompare, class UpperCompare, class Logic>
         class RangeComparator;
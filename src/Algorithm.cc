@@ -6,8 +6,13 @@
 // Copyright 2011, All rights reserved
 
 #include <cfloat>
+#include <cmath>
 #include <iostream>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include <boost/pointer_cast.hpp>
 
 #include "bsm_core/interface/ID.h"
@@ -15,6 +20,7 @@
 #include "bsm_input/interface/Jet.pb.h"
 #include "bsm_input/interface/Physics.pb.h"
 #include "interface/Algorithm.h"
+#include "interface/Btag.h"
 #include "interface/Utility.h"
 
 using namespace std;
@@ -23,6 +29,18 @@ using namespace bsm;
 
 // Neutrino Recontstruct: neglect products masses
 //
+void NeutrinoReconstruct::Solutions::push_back(const LorentzVector &met,
+        const double &pz)
+{
+    if (CAPACITY == _size)
+        return;
+
+    LorentzVector &solution = _solutions[_size++];
+    solution = met;
+    solution.set_pz(pz);
+    solution.set_e(sqrt(met.px() * met.px() + met.py() * met.py() + pz * pz));
+}
+
 NeutrinoReconstruct::NeutrinoReconstruct()
 {
 }
@@ -34,6 +52,16 @@ NeutrinoReconstruct::NeutrinoReconstruct(const NeutrinoReconstruct &)
 NeutrinoReconstruct::Solutions
     NeutrinoReconstruct::operator()(const LorentzVector &lepton,
         const LorentzVector &neutrino)
+{
+    Solutions solutions;
+    operator()(lepton, neutrino, solutions);
+
+    return solutions;
+}
+
+void NeutrinoReconstruct::operator()(const LorentzVector &lepton,
+        const LorentzVector &neutrino,
+        Solutions &solutions)
 {
     // The final equation is:
     //
@@ -44,33 +72,26 @@ NeutrinoReconstruct::Solutions
     //      mu = mW^2 / 2 + pTlep * pTnu * cos(phi)
     //      phi is angle between p_lepton and p_neutrino in transverse plane
     //
-    Vector lepton_pT = toVector(lepton);
-    lepton_pT.set_z(0);
-
-    Vector neutrino_pT = toVector(neutrino);
-    neutrino_pT.set_z(0);
-
-    const float mass_w = 80.399;
-    float mu = mass_w * mass_w / 2 + lepton_pT * neutrino_pT;
+    // Equation is solved in double precision
+    //
+    const double mass_w = 80.399;
+    const double mu = mass_w * mass_w / 2
+        + lepton.px() * neutrino.px() + lepton.py() * neutrino.py();
 
-    float A = - (lepton_pT * lepton_pT);
-    float B = mu * lepton.pz();
-    float C = mu * mu - lepton.e() * lepton.e() * (neutrino_pT * neutrino_pT);
+    const double A = - (lepton.px() * lepton.px() + lepton.py() * lepton.py());
+    const double B = mu * lepton.pz();
+    const double C = mu * mu - lepton.e() * lepton.e()
+        * (neutrino.px() * neutrino.px() + neutrino.py() * neutrino.py());
 
-    float discriminant = B * B - A * C;
+    double discriminant = B * B - A * C;
 
-    Solutions solutions;
+    solutions.clear();
 
     if (0 >= discriminant)
     {
         // Take only real part of the solution
         //
-        LorentzVectorPtr solution(new LorentzVector());
-        *solution = neutrino;
-        solution->set_pz(-B / A);
-        solution->set_e(magnitude(toVector(*solution)));
-
-        solutions.push_back(solution);
+        solutions.push_back(neutrino, -B / A);
 
         _solutions = 0 > discriminant ? 0 : 1;
     }
@@ -78,24 +99,11 @@ NeutrinoReconstruct::Solutions
     {
         discriminant = sqrt(discriminant);
 
-        LorentzVectorPtr solution(new LorentzVector());
-        *solution = neutrino;
-        solution->set_pz((-B - discriminant) / A);
-        solution->set_e(magnitude(toVector(*solution)));
-
-        solutions.push_back(solution);
-
-        solution.reset(new LorentzVector());
-        *solution = neutrino;
-        solution->set_pz((-B + discriminant) / A);
-        solution->set_e(magnitude(toVector(*solution)));
-
-        solutions.push_back(solution);
+        solutions.push_back(neutrino, (-B - discriminant) / A);
+        solutions.push_back(neutrino, (-B + discriminant) / A);
 
         _solutions = 2;
     }
-
-    return solutions;
 }
 
 int NeutrinoReconstruct::solutions() const
@@ -399,167 +407,77 @@ void JetIterator::operator++()
 
 // -- Resonance Reconstructor -------------------------------------------------
 //
-ResonanceReconstructor::Mttbar ResonanceReconstructor::run(
-        const LorentzVector &lepton,
-        const LorentzVector &met,
-        const SynchSelector::GoodJets &jets) const
+// Jets assignment of the pruned search: the last unassigned jet is
+// assigned first. Solutions are compared with strict inequalities and
+// equal solutions by position in counting order: the same solution is kept
+// in any order of search
+//
+struct ResonanceReconstructor::Branch
 {
-    Mttbar result;
-
-    // Reconstruct the neutrino pZ and keep solutions in vector for later
-    // use
-    //
-    NeutrinoReconstruct neutrinoReconstruct;
-    NeutrinoReconstruct::Solutions neutrinos =
-        neutrinoReconstruct(lepton, met);
+    typedef Generator::Hypothesis Hypothesis;
 
-    result.solutions = neutrinoReconstruct.solutions();
-
-    for(NeutrinoReconstruct::Solutions::const_iterator neutrino =
-                neutrinos.begin();
-            neutrinos.end() != neutrino;
-            ++neutrino)
-    {
-        result.neutrinos.push_back(**neutrino);
-    }
+    const LorentzVector *lepton;
+    const Neutrinos *neutrinos;
+    const CorrectedJets *jets;
+    uint32_t number_of_jets;
 
-    // Prepare generator and loop over all hypotheses of the decay
-    // (different jets assignment to leptonic/hadronic legs)
+    // Jets in the order of assignment: from the last one
     //
-    Generator generator;
-    generator.init(jets);
+    unsigned char order[Generator::MAX_OBJECTS];
 
-    // Best Solution should have minimun value of the DeltaRmin:
-    //
-    //  DeltaRmin = DeltaR(ltop, b) + DeltaR(ltop, l) + DeltaR(ltop, nu)
-    //
-    // and maximum value of the DeltaR between leptonic and hadronic
-    // tops in case the same DeltaRmin is found:
+    // Lowest leptonic discriminator of every jet and of last N jets in the
+    // order of assignment
     //
-    //  DeltaRlh = DeltaR(ltop, htop)
-    //
-    struct Solution
-    {
-        Solution():
-            htop_discriminator(0),
-            ltop_discriminator(FLT_MAX),
-            htop_njets(0),
-            valid(false)
-        {
-        }
-
-        LorentzVector ltop; // Reconstructed leptonic leg
-        LorentzVector htop; // Reconstructed hadronic leg
-        LorentzVector missing_energy;
-
-        CorrectedJets htop_jets;
-        CorrectedJets ltop_jets;
-
-        LorentzVector ltop_jet; // Used jet in the ltop reconstruction
+    float jet_bound[Generator::MAX_OBJECTS];
+    float unassigned_bound[Generator::MAX_OBJECTS + 1];
 
-        float htop_discriminator;
-        float ltop_discriminator;
-        int htop_njets;
-
-        bool valid;
-    } best_solution;
-
-    // Loop over all possible hypotheses and pick the best one
-    // Note: take into account all reconstructed neutrino solutions
+    // Side of every jet: leptonic, hadronic or neutral
     //
-    do
-    {
-        Generator::Hypothesis hypothesis = generator.hypothesis();
-
-        if (!isValidHadronicSide(lepton, hypothesis.hadronic)
-                || !isValidLeptonicSide(lepton, hypothesis.leptonic)
-                || !isValidNeutralSide(lepton, hypothesis.neutral))
+    unsigned char side[Generator::MAX_OBJECTS];
 
-                continue;
-
-        // Leptonic Top p4 = leptonP4 + nuP4 + bP4
-        // where bP4 is:
-        //  - b-tagged jet
-        //  - otherwise, the hardest jet (highest pT)
-        //
-        LorentzVector ltop = lepton;
-        LorentzVector ltop_jet = getLeptonicJet(hypothesis.leptonic);
-        ltop += ltop_jet;
-
-        // the neutrino will be taken into account later
-        //
-
-        // htop is a sum of all jet p4s assigned to the hadronic leg
-        //
-        LorentzVector htop;
-        for(Generator::Iterators::const_iterator jet =
-                    hypothesis.hadronic.begin();
-                hypothesis.hadronic.end() != jet;
-                ++jet)
-        {
-            htop += *(*jet)->corrected_p4;
-        }
-
-        // Take into account all neutrino solutions. Solutions are kept in
-        // a vector of pointer
-        //
-        for(NeutrinoReconstruct::Solutions::const_iterator neutrino =
-                    neutrinos.begin();
-                neutrinos.end() != neutrino;
-                ++neutrino)
-        {
-            const LorentzVector &neutrino_p4 = *(*neutrino);
+    // Leptonic jets with positive pT can be the leptonic jet
+    //
+    float jet_pt[Generator::MAX_OBJECTS];
+    uint32_t leptonic_jets;
 
-            LorentzVector ltop_tmp = ltop;
-            ltop_tmp += neutrino_p4;
+    Hypothesis hypothesis;
+};
 
-            const float ltop_discriminator =
-                getLeptonicDiscriminator(ltop_tmp,
-                                         lepton,
-                                         neutrino_p4,
-                                         ltop_jet);
+ResonanceReconstructor::Solution::Solution():
+    htop_discriminator(0),
+    ltop_discriminator(FLT_MAX),
+    htop_njets(0),
+    index(0),
+    valid(false)
+{
+}
 
-            const float htop_discriminator =
-                getHadronicDiscriminator(ltop_tmp, htop, hypothesis.hadronic);
+ResonanceReconstructor::ResonanceReconstructor():
+    _search(EXHAUSTIVE)
+{
+}
 
-            if (ltop_discriminator < best_solution.ltop_discriminator
-                    || (ltop_discriminator == best_solution.ltop_discriminator
-                        && htop_discriminator > best_solution.htop_discriminator))
-            {
-                best_solution.htop_discriminator = htop_discriminator;
-                best_solution.ltop_discriminator = ltop_discriminator;
-                best_solution.ltop = ltop_tmp;
-                best_solution.ltop_jet = ltop_jet;
-                best_solution.htop = htop;
-                best_solution.missing_energy = neutrino_p4;
-                best_solution.htop_njets = hypothesis.hadronic.size();
-
-                best_solution.htop_jets.clear();
-                for(Generator::Iterators::const_iterator jet =
-                            hypothesis.hadronic.begin();
-                        hypothesis.hadronic.end() != jet;
-                        ++jet)
-                {
-                    best_solution.htop_jets.push_back(*(*jet));
-                }
+void ResonanceReconstructor::setSearch(const Search &search)
+{
+    _search = search;
+}
 
-                best_solution.ltop_jets.clear();
-                for(Generator::Iterators::const_iterator jet =
-                            hypothesis.leptonic.begin();
-                        hypothesis.leptonic.end() != jet;
-                        ++jet)
-                {
-                    best_solution.ltop_jets.push_back(*(*jet));
-                }
+ResonanceReconstructor::Search ResonanceReconstructor::search() const
+{
+    return _search;
+}
 
-                best_solution.valid = true;
-            }
-        }
-    }
-    while(generator.next());
+void ResonanceReconstructor::print(std::ostream &out) const
+{
+    out << "ResonanceReconstructor" << endl;
+}
 
-    // Best Solution is found
-    //
+// Protected
+//
+void ResonanceReconstructor::fillResult(const LorentzVector &lepton,
+        const Solution &best_solution,
+        Mttbar &result) const
+{
     if (best_solution.valid)
     {
         result.mttbar = best_solution.ltop + best_solution.htop;
@@ -591,161 +509,113 @@ ResonanceReconstructor::Mttbar ResonanceReconstructor::run(
 
         result.valid = true;
     }
-
-    return result;
-}
-
-void ResonanceReconstructor::print(std::ostream &out) const
-{
-    out << "ResonanceReconstructor" << endl;
 }
 
 
 
-// -- Simple Resonance Reconstructor ------------------------------------------ 
+// -- Simple Validity ---------------------------------------------------------
 //
-uint32_t SimpleResonanceReconstructor::id() const
-{
-    return core::ID<SimpleResonanceReconstructor>::get();
-}
-
-SimpleResonanceReconstructor::ObjectPtr SimpleResonanceReconstructor::clone() const
+bool SimpleValidity::isValidHadronicSide(const LorentzVector &,
+        const Iterators &jets) const
 {
-    return ObjectPtr(new SimpleResonanceReconstructor(*this));
+    return !jets.empty();
 }
 
-void SimpleResonanceReconstructor::print(std::ostream &out) const
+bool SimpleValidity::isValidLeptonicSide(const LorentzVector &,
+        const Iterators &jets) const
 {
-    out << "SimpleResonanceReconstructor" << endl;
+    return !jets.empty();
 }
 
-// Private
-//
-bool SimpleResonanceReconstructor::isValidHadronicSide(const LorentzVector &,
+bool SimpleValidity::isValidNeutralSide(const LorentzVector &,
         const Iterators &jets) const
 {
-    return !jets.empty();
+    return true;
 }
 
-bool SimpleResonanceReconstructor::isValidLeptonicSide(const LorentzVector &,
-        const Iterators &jets) const
+bsm::LorentzVector SimpleValidity::getLeptonicJet(const Iterators &jets) const
 {
-    return !jets.empty();
+    return *lastJet(jets).corrected_p4;
 }
 
-bool SimpleResonanceReconstructor::isValidNeutralSide(const LorentzVector &,
-        const Iterators &jets) const
+bool SimpleValidity::isLastLeptonicJet() const
 {
     return true;
 }
 
-bsm::LorentzVector SimpleResonanceReconstructor::getLeptonicJet(
-        const Iterators &jets) const
+// Protected
+//
+const CorrectedJet &SimpleValidity::lastJet(const Iterators &jets) const
 {
-    const CorrectedJet *hardest_jet = 0;
-    float highest_pt = 0;
-
-    // Select the hardest jet (highest pT)
     // Note: hypothesis keeps vector of iterators to Correcte Jets.
     //       Corrected jet has a pointer to the original jet and
     //       corrected P4
     //
-    for(Iterators::const_iterator jet = jets.begin(); jets.end() != jet; ++jet)
+    Iterators::const_iterator last_jet = jets.begin();
+    bool is_positive_pt = 0 < pt(*(*last_jet)->corrected_p4);
+    for(Iterators::const_iterator jet = last_jet + 1;
+            jets.end() != jet;
+            ++jet)
     {
-        const float jet_pt = pt(*(*jet)->corrected_p4);
-        if (jet_pt > highest_pt)
-            hardest_jet = &*(*jet);
+        const bool is_jet_positive_pt = 0 < pt(*(*jet)->corrected_p4);
+        if (is_jet_positive_pt > is_positive_pt
+                || (is_jet_positive_pt == is_positive_pt
+                    && *jet > *last_jet))
+        {
+            last_jet = jet;
+            is_positive_pt = is_jet_positive_pt;
+        }
     }
 
-    return *hardest_jet->corrected_p4;
-}
-
-float SimpleResonanceReconstructor::getLeptonicDiscriminator(
-        const LorentzVector &ltop,
-        const LorentzVector &lepton,
-        const LorentzVector &neutrino,
-        const LorentzVector &jet) const
-{
-    return dr(ltop, lepton) + dr(ltop, neutrino) + dr(ltop, jet);
-}
-
-float SimpleResonanceReconstructor::getHadronicDiscriminator(
-        const LorentzVector &ltop, 
-        const LorentzVector &htop,
-        const Iterators &htop_jets) const
-{
-    return dr(ltop, htop);
-}
-
-
-
-// -- Btag Resonance Reconstructor -------------------------------------------- 
-//
-uint32_t BtagResonanceReconstructor::id() const
-{
-    return core::ID<BtagResonanceReconstructor>::get();
+    return *(*last_jet);
 }
 
-BtagResonanceReconstructor::ObjectPtr BtagResonanceReconstructor::clone() const
-{
-    return ObjectPtr(new BtagResonanceReconstructor(*this));
-}
 
-void BtagResonanceReconstructor::print(std::ostream &out) const
-{
-    out << "BtagResonanceReconstructor" << endl;
-}
 
-// Private
+// -- Btag Validity -----------------------------------------------------------
 //
-bool BtagResonanceReconstructor::isValidHadronicSide(const LorentzVector &lepton,
+bool BtagValidity::isValidHadronicSide(const LorentzVector &lepton,
         const Iterators &jets) const
 {
-    return SimpleResonanceReconstructor::isValidHadronicSide(lepton, jets)
+    return SimpleValidity::isValidHadronicSide(lepton, jets)
         && 1 >= countBtags(jets);
 }
 
-bool BtagResonanceReconstructor::isValidLeptonicSide(const LorentzVector &lepton,
+bool BtagValidity::isValidLeptonicSide(const LorentzVector &lepton,
         const Iterators &jets) const
 {
-    return SimpleResonanceReconstructor::isValidLeptonicSide(lepton, jets)
+    return SimpleValidity::isValidLeptonicSide(lepton, jets)
         && 1 >= countBtags(jets);
 }
 
-bool BtagResonanceReconstructor::isValidNeutralSide(const LorentzVector &,
+bool BtagValidity::isValidNeutralSide(const LorentzVector &,
         const Iterators &jets) const
 {
     return 1 > countBtags(jets);
 }
 
-bsm::LorentzVector BtagResonanceReconstructor::getLeptonicJet(
-        const Iterators &jets) const
+bsm::LorentzVector BtagValidity::getLeptonicJet(const Iterators &jets) const
 {
-    const CorrectedJet *hardest_jet = 0;
-    float highest_pt = 0;
-
-    // Select the hardest jet (highest pT)
-    // Note: hypothesis keeps vector of iterators to Correcte Jets.
-    //       Corrected jet has a pointer to the original jet and
-    //       corrected P4
+    // b-tagged jet is preferred: there is at most one in the valid leptonic
+    // leg
     //
     for(Iterators::const_iterator jet = jets.begin(); jets.end() != jet; ++jet)
     {
         if (isBtagJet((*jet)->jet))
-        {
-            hardest_jet = &*(*jet);
-            break;
-        }
-
-        const float jet_pt = pt(*(*jet)->corrected_p4);
-        if (jet_pt > highest_pt)
-            hardest_jet = &*(*jet);
+            return *(*jet)->corrected_p4;
     }
 
-    return *hardest_jet->corrected_p4;
+    return *lastJet(jets).corrected_p4;
+}
+
+bool BtagValidity::isLastLeptonicJet() const
+{
+    return false;
 }
 
-uint32_t BtagResonanceReconstructor::countBtags(const Iterators &jets) const
+// Private
+//
+uint32_t BtagValidity::countBtags(const Iterators &jets) const
 {
     uint32_t btagged_jets = 0;
     for(Iterators::const_iterator jet = jets.begin(); jets.end() != jet; ++jet)
@@ -757,7 +627,7 @@ uint32_t BtagResonanceReconstructor::countBtags(const Iterators &jets) const
     return btagged_jets;
 }
 
-bool BtagResonanceReconstructor::isBtagJet(const Jet *jet) const
+bool BtagValidity::isBtagJet(const Jet *jet) const
 {
     typedef ::google::protobuf::RepeatedPtrField<Jet::BTag> BTags;
 
@@ -776,29 +646,12 @@ bool BtagResonanceReconstructor::isBtagJet(const Jet *jet) const
 
 
 
-// -- DeltaR Resonance Reconstructor ------------------------------------------
-//
-uint32_t SimpleDrResonanceReconstructor::id() const
-{
-    return core::ID<SimpleDrResonanceReconstructor>::get();
-}
-
-SimpleDrResonanceReconstructor::ObjectPtr SimpleDrResonanceReconstructor::clone() const
-{
-    return ObjectPtr(new SimpleDrResonanceReconstructor(*this));
-}
-
-void SimpleDrResonanceReconstructor::print(std::ostream &out) const
-{
-    out << "SimpleDrResonanceReconstructor" << endl;
-}
-
-// Private
+// -- DeltaR Validity ---------------------------------------------------------
 //
-bool SimpleDrResonanceReconstructor::isValidHadronicSide(const LorentzVector &lepton,
+bool SimpleDrValidity::isValidHadronicSide(const LorentzVector &lepton,
         const Iterators &jets) const
 {
-    bool result = SimpleResonanceReconstructor::isValidHadronicSide(lepton, jets);
+    bool result = SimpleValidity::isValidHadronicSide(lepton, jets);
     for(Iterators::const_iterator jet = jets.begin();
             result && jets.end() != jet;
             ++jet)
@@ -810,10 +663,10 @@ bool SimpleDrResonanceReconstructor::isValidHadronicSide(const LorentzVector &le
     return result;
 }
 
-bool SimpleDrResonanceReconstructor::isValidLeptonicSide(const LorentzVector &lepton,
+bool SimpleDrValidity::isValidLeptonicSide(const LorentzVector &lepton,
         const Iterators &jets) const
 {
-    bool result = SimpleResonanceReconstructor::isValidLeptonicSide(lepton, jets);
+    bool result = SimpleValidity::isValidLeptonicSide(lepton, jets);
     for(Iterators::const_iterator jet = jets.begin();
             result && jets.end() != jet;
             ++jet)
@@ -825,10 +678,10 @@ bool SimpleDrResonanceReconstructor::isValidLeptonicSide(const LorentzVector &le
     return result;
 }
 
-bool SimpleDrResonanceReconstructor::isValidNeutralSide(const LorentzVector &lepton,
+bool SimpleDrValidity::isValidNeutralSide(const LorentzVector &lepton,
         const Iterators &jets) const
 {
-    bool result = SimpleResonanceReconstructor::isValidNeutralSide(lepton, jets);
+    bool result = SimpleValidity::isValidNeutralSide(lepton, jets);
     for(Iterators::const_iterator jet = jets.begin();
             result && jets.end() != jet;
             ++jet)
@@ -843,29 +696,12 @@ bool SimpleDrResonanceReconstructor::isValidNeutralSide(const LorentzVector &lep
 
 
 
-// -- Hemisphere Resonance Reconstructor ------------------------------------------
-//
-uint32_t HemisphereResonanceReconstructor::id() const
-{
-    return core::ID<HemisphereResonanceReconstructor>::get();
-}
-
-HemisphereResonanceReconstructor::ObjectPtr HemisphereResonanceReconstructor::clone() const
-{
-    return ObjectPtr(new HemisphereResonanceReconstructor(*this));
-}
-
-void HemisphereResonanceReconstructor::print(std::ostream &out) const
-{
-    out << "HemisphereResonanceReconstructor" << endl;
-}
-
-// Private
+// -- Hemisphere Validity -----------------------------------------------------
 //
-bool HemisphereResonanceReconstructor::isValidHadronicSide(const LorentzVector &lepton,
+bool HemisphereValidity::isValidHadronicSide(const LorentzVector &lepton,
         const Iterators &jets) const
 {
-    bool result = SimpleResonanceReconstructor::isValidHadronicSide(lepton, jets);
+    bool result = SimpleValidity::isValidHadronicSide(lepton, jets);
     for(Iterators::const_iterator jet = jets.begin();
             result && jets.end() != jet;
             ++jet)
@@ -877,10 +713,10 @@ bool HemisphereResonanceReconstructor::isValidHadronicSide(const LorentzVector &
     return result;
 }
 
-bool HemisphereResonanceReconstructor::isValidLeptonicSide(const LorentzVector &lepton,
+bool HemisphereValidity::isValidLeptonicSide(const LorentzVector &lepton,
         const Iterators &jets) const
 {
-    bool result = SimpleResonanceReconstructor::isValidLeptonicSide(lepton, jets);
+    bool result = SimpleValidity::isValidLeptonicSide(lepton, jets);
     for(Iterators::const_iterator jet = jets.begin();
             result && jets.end() != jet;
             ++jet)
@@ -892,7 +728,7 @@ bool HemisphereResonanceReconstructor::isValidLeptonicSide(const LorentzVector &
     return result;
 }
 
-bool HemisphereResonanceReconstructor::isValidNeutralSide(const LorentzVector &lepton,
+bool HemisphereValidity::isValidNeutralSide(const LorentzVector &lepton,
         const Iterators &jets) const
 {
     return jets.empty();
@@ -900,275 +736,773 @@ bool HemisphereResonanceReconstructor::isValidNeutralSide(const LorentzVector &l
 
 
 
-// --  Resonance Reconstructor with Htop Mass ----------------------------------
+// -- Leptonic Discriminators -------------------------------------------------
 //
-uint32_t ResonanceReconstructorWithMass::id() const
+float DeltaRSumDiscriminator::discriminator(const LorentzVector &ltop,
+        const LorentzVector &lepton,
+        const LorentzVector &neutrino,
+        const LorentzVector &jet) const
 {
-    return core::ID<ResonanceReconstructorWithMass>::get();
+    return dr(ltop, lepton) + dr(ltop, neutrino) + dr(ltop, jet);
 }
 
-ResonanceReconstructorWithMass::ObjectPtr
-    ResonanceReconstructorWithMass::clone() const
+float LtopMassConstrain::discriminator(const LorentzVector &ltop,
+        const LorentzVector &lepton,
+        const LorentzVector &neutrino,
+        const LorentzVector &jet) const
 {
-    return ObjectPtr(new ResonanceReconstructorWithMass(*this));
+    return pow((173.0 - mass(ltop)) / 2.0, 2);
 }
 
-void ResonanceReconstructorWithMass::print(std::ostream &out) const
+
+
+// -- Hadronic Discriminators -------------------------------------------------
+//
+float DeltaRDiscriminator::discriminator(const LorentzVector &ltop,
+        const LorentzVector &htop,
+        const Iterators &htop_jets) const
 {
-    out << "ResonanceReconstructorWithMass" << endl;
+    return dr(ltop, htop);
 }
 
-// Private
-//
-float ResonanceReconstructorWithMass::getHadronicDiscriminator(
-        const LorentzVector &ltop,
+float HtopMassConstrain::discriminator(const LorentzVector &ltop,
         const LorentzVector &htop,
         const Iterators &htop_jets) const
 {
     return pow(2.0 / (173 - mass(htop)), 2);
 }
 
+float DeltaPhiConstrain::discriminator(const LorentzVector &ltop,
+        const LorentzVector &htop,
+        const Iterators &htop_jets) const
+{
+    return pow(.22 / (fabs(dphi(htop, ltop)) - 3.14159265), 2);
+}
+
 
 
-// --  Resonance Reconstructor with Delta Phi (htop, ltop) --------------------
+// -- Discriminator Product ---------------------------------------------------
 //
-uint32_t ResonanceReconstructorWithPhi::id() const
+template<class Left, class Right>
+float DiscriminatorProduct<Left, Right>::discriminator(
+        const LorentzVector &ltop,
+        const LorentzVector &lepton,
+        const LorentzVector &neutrino,
+        const LorentzVector &jet) const
 {
-    return core::ID<ResonanceReconstructorWithPhi>::get();
+    return _left.discriminator(ltop, lepton, neutrino, jet)
+        * _right.discriminator(ltop, lepton, neutrino, jet);
 }
 
-ResonanceReconstructorWithPhi::ObjectPtr
-    ResonanceReconstructorWithPhi::clone() const
+template<class Left, class Right>
+float DiscriminatorProduct<Left, Right>::discriminator(
+        const LorentzVector &ltop,
+        const LorentzVector &htop,
+        const Iterators &htop_jets) const
 {
-    return ObjectPtr(new ResonanceReconstructorWithPhi(*this));
+    return _left.discriminator(ltop, htop, htop_jets)
+        * _right.discriminator(ltop, htop, htop_jets);
 }
 
-void ResonanceReconstructorWithPhi::print(std::ostream &out) const
-{
-    out << "ResonanceReconstructorWithPhi" << endl;
-}
 
-// Private
+
+// -- Collimated Discriminator ------------------------------------------------
 //
-float ResonanceReconstructorWithPhi::getHadronicDiscriminator(
+template<class Hadronic>
+float CollimatedDiscriminator<Hadronic>::discriminator(
         const LorentzVector &ltop,
         const LorentzVector &htop,
         const Iterators &htop_jets) const
 {
-    return pow(.22 / (fabs(dphi(htop, ltop)) - 3.14159265), 2);
-}
+    float discriminator = _hadronic.discriminator(ltop, htop, htop_jets);
 
+    if (1 < htop_jets.size())
+    {
+        float hadronic_dr = 0;
+        for(Iterators::const_iterator jet = htop_jets.begin();
+                htop_jets.end() != jet;
+                ++jet)
+        {
+            hadronic_dr += dr(htop, *(*jet)->corrected_p4);
+        }
 
+        discriminator *= 1. / hadronic_dr;
+    }
 
-// --  Resonance Reconstructor with Mass and Delta Phi (htop, ltop) ------------
-//
-uint32_t ResonanceReconstructorWithMassAndPhi::id() const
-{
-    return core::ID<ResonanceReconstructorWithMassAndPhi>::get();
+    return discriminator;
 }
 
-ResonanceReconstructorWithMassAndPhi::ObjectPtr
-    ResonanceReconstructorWithMassAndPhi::clone() const
-{
-    return ObjectPtr(new ResonanceReconstructorWithMassAndPhi(*this));
-}
 
-void ResonanceReconstructorWithMassAndPhi::print(std::ostream &out) const
-{
-    out << "ResonanceReconstructorWithMassAndPhi" << endl;
-}
 
-// Private
+// -- Policy Resonance Reconstructor ------------------------------------------
 //
-float ResonanceReconstructorWithMassAndPhi::getHadronicDiscriminator(
-        const LorentzVector &ltop,
-        const LorentzVector &htop,
-        const Iterators &htop_jets) const
+template<class Validity, class Leptonic, class Hadronic>
+typename PolicyResonanceReconstructor<Validity, Leptonic, Hadronic>::Mttbar
+    PolicyResonanceReconstructor<Validity, Leptonic, Hadronic>::run(
+        const LorentzVector &lepton,
+        const LorentzVector &met,
+        const SynchSelector::GoodJets &jets) const
 {
-    return ResonanceReconstructorWithMass::getHadronicDiscriminator(ltop, htop, htop_jets)
-        * ResonanceReconstructorWithPhi::getHadronicDiscriminator(ltop, htop, htop_jets);
-}
+    Mttbar result;
 
+    // Reconstruct the neutrino pZ and keep solutions in vector for later
+    // use
+    //
+    NeutrinoReconstruct neutrinoReconstruct;
+    neutrinoReconstruct(lepton, met, result.neutrinos);
 
+    result.solutions = neutrinoReconstruct.solutions();
 
-// -- Simple Resonance Reconstructor with Mass and Delta Phi (htop, ltop) -----
-//
-uint32_t SimpleResonanceReconstructorWithMassAndPhi::id() const
-{
-    return core::ID<SimpleResonanceReconstructorWithMassAndPhi>::get();
-}
+    const NeutrinoReconstruct::Solutions &neutrinos = result.neutrinos;
 
-SimpleResonanceReconstructorWithMassAndPhi::ObjectPtr
-    SimpleResonanceReconstructorWithMassAndPhi::clone() const
-{
-    return ObjectPtr(new SimpleResonanceReconstructorWithMassAndPhi(*this));
+    // Best Solution should have minimun value of the DeltaRmin:
+    //
+    //  DeltaRmin = DeltaR(ltop, b) + DeltaR(ltop, l) + DeltaR(ltop, nu)
+    //
+    // and maximum value of the DeltaR between leptonic and hadronic
+    // tops in case the same DeltaRmin is found:
+    //
+    //  DeltaRlh = DeltaR(ltop, htop)
+    //
+    Solution best_solution;
+    searchHypotheses(lepton, neutrinos, jets, best_solution);
+
+    fillResult(lepton, best_solution, result);
+
+    return result;
 }
 
-void SimpleResonanceReconstructorWithMassAndPhi::print(std::ostream &out) const
+// Protected
+//
+template<class Validity, class Leptonic, class Hadronic>
+void PolicyResonanceReconstructor<Validity, Leptonic, Hadronic>::evaluate(
+        const LorentzVector &lepton,
+        const Neutrinos &neutrinos,
+        const Generator::Hypothesis &hypothesis,
+        const uint32_t &index,
+        const LorentzVector *htop,
+        Solution &best_solution) const
 {
-    out << "SimpleResonanceReconstructorWithMassAndPhi" << endl;
+    check(lepton, neutrinos, hypothesis, index, htop, best_solution);
 }
 
 // Private
 //
-float SimpleResonanceReconstructorWithMassAndPhi::getHadronicDiscriminator(
-        const LorentzVector &ltop,
-        const LorentzVector &htop,
-        const Iterators &htop_jets) const
+template<class Validity, class Leptonic, class Hadronic>
+void PolicyResonanceReconstructor<Validity, Leptonic, Hadronic>::searchHypotheses(
+        const LorentzVector &lepton,
+        const Neutrinos &neutrinos,
+        const CorrectedJets &jets,
+        Solution &best_solution) const
 {
-    return SimpleResonanceReconstructor::getHadronicDiscriminator(ltop, htop, htop_jets)
-        * ResonanceReconstructorWithMassAndPhi::getHadronicDiscriminator(ltop, htop, htop_jets);
-}
+    if (PRUNED == search())
+    {
+        Branch branch;
+        branch.lepton = &lepton;
+        branch.neutrinos = &neutrinos;
+        branch.jets = &jets;
+        branch.leptonic_jets = 0;
+
+        // Leptonic discriminator of any hypothesis is bounded by the lowest
+        // discriminator of its leptonic jet
+        //
+        branch.number_of_jets =
+            min<uint32_t>(jets.size(), Generator::MAX_OBJECTS);
 
+        for(uint32_t index = 0; branch.number_of_jets > index; ++index)
+        {
+            branch.jet_bound[index] = leptonicBound(lepton, neutrinos,
+                    *jets[index].corrected_p4);
+            branch.jet_pt[index] = pt(*jets[index].corrected_p4);
+            branch.order[index] = branch.number_of_jets - 1 - index;
+        }
 
+        branch.unassigned_bound[0] = FLT_MAX;
+        for(uint32_t unassigned = 1;
+                branch.number_of_jets >= unassigned;
+                ++unassigned)
+        {
+            branch.unassigned_bound[unassigned] =
+                min(branch.unassigned_bound[unassigned - 1],
+                    branch.jet_bound[
+                        branch.order[branch.number_of_jets - unassigned]]);
+        }
 
-// -- Simple Resonance Reconstructor with Mass ---------------------------------
-//
-uint32_t SimpleResonanceReconstructorWithMass::id() const
-{
-    return core::ID<SimpleResonanceReconstructorWithMass>::get();
-}
+        this->branch(branch, branch.number_of_jets, FLT_MAX, best_solution);
+    }
+    else
+    {
+        // Prepare generator and loop over all hypotheses of the decay
+        // (different jets assignment to leptonic/hadronic legs)
+        //
+        Generator generator;
+        generator.init(jets,
+                INCREMENTAL == search()
+                    ? Generator::GRAY
+                    : Generator::COUNTING);
+
+        // Loop over all possible hypotheses and pick the best one
+        // Note: take into account all reconstructed neutrino solutions
+        //
+        if (INCREMENTAL == search())
+        {
+            // All jets are assigned to the leptonic leg in the first
+            // hypothesis: hadronic leg is empty
+            //
+            LorentzVector htop;
+            do
+            {
+                const Generator::Change &change = generator.change();
+                if (change.valid)
+                {
+                    const LorentzVector &jet = *change.object->corrected_p4;
 
-SimpleResonanceReconstructorWithMass::ObjectPtr
-    SimpleResonanceReconstructorWithMass::clone() const
-{
-    return ObjectPtr(new SimpleResonanceReconstructorWithMass(*this));
-}
+                    if (Generator::HADRONIC == change.from)
+                        htop -= jet;
+                    else if (Generator::HADRONIC == change.to)
+                        htop += jet;
+                }
 
-void SimpleResonanceReconstructorWithMass::print(std::ostream &out) const
-{
-    out << "SimpleResonanceReconstructorWithMass" << endl;
-}
+                // Drop accumulated rounding errors whenever hadronic leg
+                // becomes empty
+                //
+                const Generator::Hypothesis &hypothesis =
+                    generator.hypothesis();
 
-// Private
-//
-float SimpleResonanceReconstructorWithMass::getHadronicDiscriminator(
-        const LorentzVector &ltop,
-        const LorentzVector &htop,
-        const Iterators &htop_jets) const
-{
-    return SimpleResonanceReconstructor::getHadronicDiscriminator(ltop, htop, htop_jets)
-        * ResonanceReconstructorWithMass::getHadronicDiscriminator(ltop, htop, htop_jets);
+                if (hypothesis.hadronic.empty())
+                    htop = LorentzVector();
+
+                check(lepton, neutrinos, hypothesis, generator.index(),
+                        &htop, best_solution);
+            }
+            while(generator.next());
+        }
+        else
+        {
+            do
+            {
+                check(lepton, neutrinos, generator.hypothesis(),
+                        generator.index(), 0, best_solution);
+            }
+            while(generator.next());
+        }
+    }
 }
 
+template<class Validity, class Leptonic, class Hadronic>
+void PolicyResonanceReconstructor<Validity, Leptonic, Hadronic>::check(
+        const LorentzVector &lepton,
+        const Neutrinos &neutrinos,
+        const Generator::Hypothesis &hypothesis,
+        const uint32_t &index,
+        const LorentzVector *htop_sum,
+        Solution &best_solution) const
+{
+    if (!_validity.isValidHadronicSide(lepton, hypothesis.hadronic)
+            || !_validity.isValidLeptonicSide(lepton, hypothesis.leptonic)
+            || !_validity.isValidNeutralSide(lepton, hypothesis.neutral))
+
+            return;
+
+    // Leptonic Top p4 = leptonP4 + nuP4 + bP4
+    // where bP4 is:
+    //  - b-tagged jet
+    //  - otherwise, the hardest jet (highest pT)
+    //
+    LorentzVector ltop = lepton;
+    LorentzVector ltop_jet = _validity.getLeptonicJet(hypothesis.leptonic);
+    ltop += ltop_jet;
 
+    // the neutrino will be taken into account later
+    //
 
-// -- Collimated Simple Resonance Reconstructor with Mass ----------------------
-//
-uint32_t CollimatedSimpleResonanceReconstructorWithMass::id() const
-{
-    return core::ID<CollimatedSimpleResonanceReconstructorWithMass>::get();
-}
+    // htop is a sum of all jet p4s assigned to the hadronic leg
+    //
+    LorentzVector htop;
+    if (htop_sum)
+        htop = *htop_sum;
+    else
+    {
+        for(Generator::Iterators::const_iterator jet =
+                    hypothesis.hadronic.begin();
+                hypothesis.hadronic.end() != jet;
+                ++jet)
+        {
+            htop += *(*jet)->corrected_p4;
+        }
+    }
 
-CollimatedSimpleResonanceReconstructorWithMass::ObjectPtr
-    CollimatedSimpleResonanceReconstructorWithMass::clone() const
-{
-    return ObjectPtr(new CollimatedSimpleResonanceReconstructorWithMass(*this));
+    // Take into account all neutrino solutions. Solutions are kept in
+    // a vector of pointer
+    //
+    for(NeutrinoReconstruct::Solutions::const_iterator neutrino =
+                neutrinos.begin();
+            neutrinos.end() != neutrino;
+            ++neutrino)
+    {
+        const LorentzVector &neutrino_p4 = *neutrino;
+
+        LorentzVector ltop_tmp = ltop;
+        ltop_tmp += neutrino_p4;
+
+        const float ltop_discriminator =
+            _leptonic.discriminator(ltop_tmp,
+                                    lepton,
+                                    neutrino_p4,
+                                    ltop_jet);
+
+        const float htop_discriminator =
+            _hadronic.discriminator(ltop_tmp, htop, hypothesis.hadronic);
+
+        if (ltop_discriminator < best_solution.ltop_discriminator
+                || (ltop_discriminator == best_solution.ltop_discriminator
+                    && (htop_discriminator > best_solution.htop_discriminator
+                        || (htop_discriminator
+                                == best_solution.htop_discriminator
+                            && index < best_solution.index))))
+        {
+            best_solution.htop_discriminator = htop_discriminator;
+            best_solution.ltop_discriminator = ltop_discriminator;
+            best_solution.ltop = ltop_tmp;
+            best_solution.ltop_jet = ltop_jet;
+            best_solution.htop = htop;
+            best_solution.missing_energy = neutrino_p4;
+            best_solution.htop_njets = hypothesis.hadronic.size();
+            best_solution.index = index;
+
+            best_solution.htop_jets.clear();
+            for(Generator::Iterators::const_iterator jet =
+                        hypothesis.hadronic.begin();
+                    hypothesis.hadronic.end() != jet;
+                    ++jet)
+            {
+                best_solution.htop_jets.push_back(*(*jet));
+            }
+
+            best_solution.ltop_jets.clear();
+            for(Generator::Iterators::const_iterator jet =
+                        hypothesis.leptonic.begin();
+                    hypothesis.leptonic.end() != jet;
+                    ++jet)
+            {
+                best_solution.ltop_jets.push_back(*(*jet));
+            }
+
+            best_solution.valid = true;
+        }
+    }
 }
 
-void CollimatedSimpleResonanceReconstructorWithMass::print(std::ostream &out) const
+template<class Validity, class Leptonic, class Hadronic>
+float PolicyResonanceReconstructor<Validity, Leptonic, Hadronic>::leptonicBound(
+        const LorentzVector &lepton,
+        const Neutrinos &neutrinos,
+        const LorentzVector &jet) const
 {
-    out << "CollimatedSimpleResonanceReconstructorWithMass" << endl;
+    LorentzVector ltop = lepton;
+    ltop += jet;
+
+    float bound = FLT_MAX;
+    for(NeutrinoReconstruct::Solutions::const_iterator neutrino =
+                neutrinos.begin();
+            neutrinos.end() != neutrino;
+            ++neutrino)
+    {
+        const LorentzVector &neutrino_p4 = *neutrino;
+
+        LorentzVector ltop_tmp = ltop;
+        ltop_tmp += neutrino_p4;
+
+        const float ltop_discriminator =
+            _leptonic.discriminator(ltop_tmp, lepton, neutrino_p4, jet);
+
+        if (ltop_discriminator < bound)
+            bound = ltop_discriminator;
+    }
+
+    return bound;
 }
 
-// Private
-//
-float CollimatedSimpleResonanceReconstructorWithMass::getHadronicDiscriminator(
-        const LorentzVector &ltop,
-        const LorentzVector &htop,
-        const Iterators &htop_jets) const
+template<class Validity, class Leptonic, class Hadronic>
+void PolicyResonanceReconstructor<Validity, Leptonic, Hadronic>::branch(Branch &branch,
+        const uint32_t &unassigned_jets,
+        const float &leptonic_bound,
+        Solution &best_solution) const
 {
-    float discriminator =
-        SimpleResonanceReconstructorWithMass::getHadronicDiscriminator(
-                ltop,
-                htop,
-                htop_jets);
+    // Jets are assigned from the last one: the first leptonic jet with
+    // positive pT is the leptonic jet of the hypothesis if validity picks
+    // the last jet, and unassigned jets do not change the bound
+    //
+    const bool is_leptonic_jet_fixed = branch.leptonic_jets
+        && _validity.isLastLeptonicJet();
 
-    if (1 < htop_jets.size())
+    const float bound = is_leptonic_jet_fixed
+        ? leptonic_bound
+        : min(leptonic_bound, branch.unassigned_bound[unassigned_jets]);
+
+    // Equal discriminator may still win with larger hadronic
+    // discriminator: only strictly worse assignments are dropped
+    //
+    if (bound > best_solution.ltop_discriminator)
+        return;
+
+    if (!unassigned_jets)
     {
-        float hadronic_dr = 0;
-        for(Generator::Iterators::const_iterator jet = htop_jets.begin();
-                htop_jets.end() != jet;
-                ++jet)
+        Branch::Hypothesis &hypothesis = branch.hypothesis;
+        hypothesis.leptonic.clear();
+        hypothesis.hadronic.clear();
+        hypothesis.neutral.clear();
+
+        // Position of the hypothesis in counting order
+        //
+        uint32_t position = 0;
+        uint32_t weight = 1;
+
+        CorrectedJets::const_iterator jet = branch.jets->begin();
+        for(uint32_t index = 0;
+                branch.number_of_jets > index;
+                ++index, ++jet, weight *= 3)
         {
-            hadronic_dr += dr(htop, *(*jet)->corrected_p4);
+            position += branch.side[index] * weight;
+
+            switch(branch.side[index])
+            {
+                case Generator::LEPTONIC:
+                    hypothesis.leptonic.push_back(jet);
+                    break;
+
+                case Generator::HADRONIC:
+                    hypothesis.hadronic.push_back(jet);
+                    break;
+
+                default:
+                    hypothesis.neutral.push_back(jet);
+                    break;
+            }
         }
 
-        discriminator *= 1. / hadronic_dr;
+        check(*branch.lepton, *branch.neutrinos, hypothesis, position, 0,
+              best_solution);
+
+        return;
     }
 
-    return discriminator;
+    // Leptonic side is tried last: good solutions with the leptonic jet
+    // among the rest of jets are found first and prune more branches
+    //
+    const uint32_t jet =
+        branch.order[branch.number_of_jets - unassigned_jets];
+    for(unsigned char step = 1; 3 >= step; ++step)
+    {
+        const unsigned char side = step % 3;
+        branch.side[jet] = side;
+
+        const bool is_leptonic_jet = Generator::LEPTONIC == side
+            && 0 < branch.jet_pt[jet];
+
+        if (is_leptonic_jet)
+            ++branch.leptonic_jets;
+
+        this->branch(branch,
+                unassigned_jets - 1,
+                side || is_leptonic_jet_fixed
+                    ? leptonic_bound
+                    : min(leptonic_bound, branch.jet_bound[jet]),
+                best_solution);
+
+        if (is_leptonic_jet)
+            --branch.leptonic_jets;
+    }
 }
 
+// Combinations in use
+//
+template class bsm::PolicyResonanceReconstructor<SimpleValidity,
+                                                 DeltaRSumDiscriminator,
+                                                 DeltaRDiscriminator>;
+
+template class bsm::PolicyResonanceReconstructor<BtagValidity,
+                                                 DeltaRSumDiscriminator,
+                                                 DeltaRDiscriminator>;
+
+template class bsm::PolicyResonanceReconstructor<SimpleDrValidity,
+                                                 DeltaRSumDiscriminator,
+                                                 DeltaRDiscriminator>;
+
+template class bsm::PolicyResonanceReconstructor<HemisphereValidity,
+                                                 DeltaRSumDiscriminator,
+                                                 DeltaRDiscriminator>;
+
+template class bsm::PolicyResonanceReconstructor<SimpleValidity,
+                                                 DeltaRSumDiscriminator,
+                                                 HtopMassConstrain>;
+
+template class bsm::PolicyResonanceReconstructor<SimpleValidity,
+                                                 DeltaRSumDiscriminator,
+                                                 DeltaPhiConstrain>;
+
+template class bsm::PolicyResonanceReconstructor<SimpleValidity,
+                                                 DeltaRSumDiscriminator,
+                                                 HtopMassAndDeltaPhiConstrain>;
 
+template class bsm::PolicyResonanceReconstructor<SimpleValidity,
+                                                 DeltaRSumDiscriminator,
+                                                 DeltaRWithHtopMassAndDeltaPhiConstrain>;
 
-// -- Collimated Simple Resonance Reconstructor with Top Mass ----------------------
+template class bsm::PolicyResonanceReconstructor<SimpleValidity,
+                                                 DeltaRSumDiscriminator,
+                                                 DeltaRWithHtopMassConstrain>;
+
+template class bsm::PolicyResonanceReconstructor<SimpleValidity,
+                                                 DeltaRSumDiscriminator,
+                                                 CollimatedDeltaRWithHtopMassConstrain>;
+
+template class bsm::PolicyResonanceReconstructor<SimpleValidity,
+                                                 LtopMassConstrain,
+                                                 CollimatedDeltaRWithHtopMassConstrain>;
+
+template class bsm::PolicyResonanceReconstructor<SimpleValidity,
+                                                 DeltaRSumWithLtopMassConstrain,
+                                                 CollimatedDeltaRWithHtopMassConstrain>;
+
+
+
+// -- Simple Resonance Reconstructor -----------------------------------------
 //
-uint32_t CollimatedSimpleResonanceReconstructorWithTopMass::id() const
+uint32_t SimpleResonanceReconstructor::id() const
 {
-    return core::ID<CollimatedSimpleResonanceReconstructorWithTopMass>::get();
+    return core::ID<SimpleResonanceReconstructor>::get();
 }
 
-CollimatedSimpleResonanceReconstructorWithTopMass::ObjectPtr
-    CollimatedSimpleResonanceReconstructorWithTopMass::clone() const
+SimpleResonanceReconstructor::ObjectPtr
+    SimpleResonanceReconstructor::clone() const
 {
-    return ObjectPtr(new CollimatedSimpleResonanceReconstructorWithTopMass(*this));
+    return ObjectPtr(new SimpleResonanceReconstructor(*this));
 }
 
-void CollimatedSimpleResonanceReconstructorWithTopMass::print(std::ostream &out) const
+void SimpleResonanceReconstructor::print(std::ostream &out) const
 {
-    out << "CollimatedSimpleResonanceReconstructorWithTopMass" << endl;
+    out << "SimpleResonanceReconstructor" << endl;
 }
 
-// Private
+
+
+// -- Btag Resonance Reconstructor -------------------------------------------
 //
-bool CollimatedSimpleResonanceReconstructorWithTopMass::isValidLeptonicSide(
-        const LorentzVector &,
-        const Iterators &jets)
+uint32_t BtagResonanceReconstructor::id() const
 {
-    return 1 == jets.size();
+    return core::ID<BtagResonanceReconstructor>::get();
 }
 
-float CollimatedSimpleResonanceReconstructorWithTopMass::getLeptonicDiscriminator(
-        const LorentzVector &ltop,
-        const LorentzVector &lepton,
-        const LorentzVector &neutrino,
-        const LorentzVector &jet) const
+BtagResonanceReconstructor::ObjectPtr
+    BtagResonanceReconstructor::clone() const
 {
-    return pow((173.0 - mass(ltop)) / 2.0, 2);
+    return ObjectPtr(new BtagResonanceReconstructor(*this));
+}
+
+void BtagResonanceReconstructor::print(std::ostream &out) const
+{
+    out << "BtagResonanceReconstructor" << endl;
 }
 
 
 
-// -- Collimated Tops with Mass Constrain --------------------------------------
+// -- DeltaR Resonance Reconstructor -----------------------------------------
 //
-uint32_t ResonanceReconstructorWithCollimatedTops::id() const
+uint32_t SimpleDrResonanceReconstructor::id() const
 {
-    return core::ID<ResonanceReconstructorWithCollimatedTops>::get();
+    return core::ID<SimpleDrResonanceReconstructor>::get();
 }
 
-ResonanceReconstructorWithCollimatedTops::ObjectPtr
-    ResonanceReconstructorWithCollimatedTops::clone() const
+SimpleDrResonanceReconstructor::ObjectPtr
+    SimpleDrResonanceReconstructor::clone() const
 {
-    return ObjectPtr(new ResonanceReconstructorWithCollimatedTops(*this));
+    return ObjectPtr(new SimpleDrResonanceReconstructor(*this));
 }
 
-void ResonanceReconstructorWithCollimatedTops::print(std::ostream &out) const
+void SimpleDrResonanceReconstructor::print(std::ostream &out) const
 {
-    out << "ResonanceReconstructorWithCollimatedTops" << endl;
+    out << "SimpleDrResonanceReconstructor" << endl;
 }
 
-// Private
+
+
+// -- Hemisphere Resonance Reconstructor -------------------------------------
 //
-float ResonanceReconstructorWithCollimatedTops::getLeptonicDiscriminator(
-        const LorentzVector &ltop,
-        const LorentzVector &lepton,
-        const LorentzVector &neutrino,
-        const LorentzVector &jet) const
+uint32_t HemisphereResonanceReconstructor::id() const
+{
+    return core::ID<HemisphereResonanceReconstructor>::get();
+}
+
+HemisphereResonanceReconstructor::ObjectPtr
+    HemisphereResonanceReconstructor::clone() const
+{
+    return ObjectPtr(new HemisphereResonanceReconstructor(*this));
+}
+
+void HemisphereResonanceReconstructor::print(std::ostream &out) const
+{
+    out << "HemisphereResonanceReconstructor" << endl;
+}
+
+
+
+// -- Resonance Reconstructor with Htop Mass ---------------------------------
+//
+uint32_t ResonanceReconstructorWithMass::id() const
+{
+    return core::ID<ResonanceReconstructorWithMass>::get();
+}
+
+ResonanceReconstructorWithMass::ObjectPtr
+    ResonanceReconstructorWithMass::clone() const
+{
+    return ObjectPtr(new ResonanceReconstructorWithMass(*this));
+}
+
+void ResonanceReconstructorWithMass::print(std::ostream &out) const
+{
+    out << "ResonanceReconstructorWithMass" << endl;
+}
+
+
+
+// -- Resonance Reconstructor with Delta Phi (htop, ltop) --------------------
+//
+uint32_t ResonanceReconstructorWithPhi::id() const
+{
+    return core::ID<ResonanceReconstructorWithPhi>::get();
+}
+
+ResonanceReconstructorWithPhi::ObjectPtr
+    ResonanceReconstructorWithPhi::clone() const
+{
+    return ObjectPtr(new ResonanceReconstructorWithPhi(*this));
+}
+
+void ResonanceReconstructorWithPhi::print(std::ostream &out) const
+{
+    out << "ResonanceReconstructorWithPhi" << endl;
+}
+
+
+
+// -- Resonance Reconstructor with Mass and Delta Phi (htop, ltop) -----------
+//
+uint32_t ResonanceReconstructorWithMassAndPhi::id() const
+{
+    return core::ID<ResonanceReconstructorWithMassAndPhi>::get();
+}
+
+ResonanceReconstructorWithMassAndPhi::ObjectPtr
+    ResonanceReconstructorWithMassAndPhi::clone() const
+{
+    return ObjectPtr(new ResonanceReconstructorWithMassAndPhi(*this));
+}
+
+void ResonanceReconstructorWithMassAndPhi::print(std::ostream &out) const
+{
+    out << "ResonanceReconstructorWithMassAndPhi" << endl;
+}
+
+
+
+// -- Simple Resonance Reconstructor with Mass and Delta Phi (htop, ltop) ----
+//
+uint32_t SimpleResonanceReconstructorWithMassAndPhi::id() const
+{
+    return core::ID<SimpleResonanceReconstructorWithMassAndPhi>::get();
+}
+
+SimpleResonanceReconstructorWithMassAndPhi::ObjectPtr
+    SimpleResonanceReconstructorWithMassAndPhi::clone() const
+{
+    return ObjectPtr(new SimpleResonanceReconstructorWithMassAndPhi(*this));
+}
+
+void SimpleResonanceReconstructorWithMassAndPhi::print(std::ostream &out) const
+{
+    out << "SimpleResonanceReconstructorWithMassAndPhi" << endl;
+}
+
+
+
+// -- Simple Resonance Reconstructor with Mass -------------------------------
+//
+uint32_t SimpleResonanceReconstructorWithMass::id() const
+{
+    return core::ID<SimpleResonanceReconstructorWithMass>::get();
+}
+
+SimpleResonanceReconstructorWithMass::ObjectPtr
+    SimpleResonanceReconstructorWithMass::clone() const
+{
+    return ObjectPtr(new SimpleResonanceReconstructorWithMass(*this));
+}
+
+void SimpleResonanceReconstructorWithMass::print(std::ostream &out) const
+{
+    out << "SimpleResonanceReconstructorWithMass" << endl;
+}
+
+
+
+// -- Collimated Simple Resonance Reconstructor with Mass --------------------
+//
+uint32_t CollimatedSimpleResonanceReconstructorWithMass::id() const
+{
+    return core::ID<CollimatedSimpleResonanceReconstructorWithMass>::get();
+}
+
+CollimatedSimpleResonanceReconstructorWithMass::ObjectPtr
+    CollimatedSimpleResonanceReconstructorWithMass::clone() const
+{
+    return ObjectPtr(new CollimatedSimpleResonanceReconstructorWithMass(*this));
+}
+
+void CollimatedSimpleResonanceReconstructorWithMass::print(std::ostream &out) const
+{
+    out << "CollimatedSimpleResonanceReconstructorWithMass" << endl;
+}
+
+
+
+// -- Collimated Simple Resonance Reconstructor with Top Mass ----------------
+//
+uint32_t CollimatedSimpleResonanceReconstructorWithTopMass::id() const
+{
+    return core::ID<CollimatedSimpleResonanceReconstructorWithTopMass>::get();
+}
+
+CollimatedSimpleResonanceReconstructorWithTopMass::ObjectPtr
+    CollimatedSimpleResonanceReconstructorWithTopMass::clone() const
+{
+    return ObjectPtr(new CollimatedSimpleResonanceReconstructorWithTopMass(*this));
+}
+
+void CollimatedSimpleResonanceReconstructorWithTopMass::print(std::ostream &out) const
+{
+    out << "CollimatedSimpleResonanceReconstructorWithTopMass" << endl;
+}
+
+
+
+// -- Collimated Tops with Mass Constrain ------------------------------------
+//
+uint32_t ResonanceReconstructorWithCollimatedTops::id() const
+{
+    return core::ID<ResonanceReconstructorWithCollimatedTops>::get();
+}
+
+ResonanceReconstructorWithCollimatedTops::ObjectPtr
+    ResonanceReconstructorWithCollimatedTops::clone() const
+{
+    return ObjectPtr(new ResonanceReconstructorWithCollimatedTops(*this));
+}
+
+void ResonanceReconstructorWithCollimatedTops::print(std::ostream &out) const
 {
-    return SimpleResonanceReconstructor::getLeptonicDiscriminator(ltop, lepton, neutrino, jet) *
-        CollimatedSimpleResonanceReconstructorWithTopMass::getLeptonicDiscriminator(
-            ltop, lepton, neutrino, jet);
+    out << "ResonanceReconstructorWithCollimatedTops" << endl;
 }
 
 
@@ -1180,352 +1514,1277 @@ Chi2Hypothesis::Chi2Hypothesis(const DecayHypothesis *hypothesis):
 {
     if (hypothesis)
     {
-        ltop_jets = hypothesis->leptonic;
-        htop_jets = hypothesis->hadronic;
+        ltop_jets = hypothesis->leptonic;
+        htop_jets = hypothesis->hadronic;
+    }
+}
+
+
+
+// -- Chi2 Batch ---------------------------------------------------------------
+//
+// Batch kernels follow TLorentzVector definitions of mass, direction and
+// distance. Kernels and Algebra may round intermediate values differently:
+// chi2 of the same hypothesis agrees within 1e-5 relative (or 1e-5
+// absolute for chi2 below 1). SSE2 and scalar kernels give identical values:
+// SSE2 kernels process two hypotheses per instruction, log and atan2 of
+// the direction are computed with libm for every hypothesis
+//
+static void batchMass(const Chi2Batch::P4s &p4,
+        const uint32_t &size,
+        double *mass)
+{
+    uint32_t index = 0;
+
+#ifdef __SSE2__
+    const __m128d sign = _mm_set1_pd(-0.0);
+    for(; size >= index + 2; index += 2)
+    {
+        const __m128d e = _mm_loadu_pd(p4.e + index);
+        const __m128d px = _mm_loadu_pd(p4.px + index);
+        const __m128d py = _mm_loadu_pd(p4.py + index);
+        const __m128d pz = _mm_loadu_pd(p4.pz + index);
+
+        const __m128d p2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(px, px),
+                                                 _mm_mul_pd(py, py)),
+                                      _mm_mul_pd(pz, pz));
+        const __m128d m2 = _mm_sub_pd(_mm_mul_pd(e, e), p2);
+
+        // Negative mass square gives negative mass
+        //
+        const __m128d m = _mm_sqrt_pd(_mm_andnot_pd(sign, m2));
+        _mm_storeu_pd(mass + index, _mm_or_pd(m, _mm_and_pd(sign, m2)));
+    }
+#endif
+
+    for(; size > index; ++index)
+    {
+        const double m2 = p4.e[index] * p4.e[index]
+            - (p4.px[index] * p4.px[index]
+                + p4.py[index] * p4.py[index]
+                + p4.pz[index] * p4.pz[index]);
+
+        mass[index] = 0 > m2 ? -sqrt(-m2) : sqrt(m2);
+    }
+}
+
+static double batchEta(const double &cos_theta, const double &pz)
+{
+    if (1 > cos_theta * cos_theta)
+        return -0.5 * log((1 - cos_theta) / (1 + cos_theta));
+
+    if (!pz)
+        return 0;
+
+    return 0 < pz ? 10e10 : -10e10;
+}
+
+static double batchEta(const double &px, const double &py, const double &pz)
+{
+    const double p = sqrt(px * px + py * py + pz * pz);
+
+    return batchEta(p ? pz / p : 1, pz);
+}
+
+static double batchPhi(const double &px, const double &py)
+{
+    return px || py ? atan2(py, px) : 0;
+}
+
+static double batchDeltaPhi(const double &phi, const double &other_phi)
+{
+    double delta = phi - other_phi;
+    while(M_PI <= delta)
+        delta -= 2 * M_PI;
+
+    while(-M_PI > delta)
+        delta += 2 * M_PI;
+
+    return delta;
+}
+
+static double batchDeltaR(const double &eta, const double &phi,
+        const double &other_eta, const double &other_phi)
+{
+    const double delta_eta = eta - other_eta;
+    const double delta_phi = batchDeltaPhi(phi, other_phi);
+
+    return sqrt(delta_eta * delta_eta + delta_phi * delta_phi);
+}
+
+#ifdef __SSE2__
+// Phi is in the atan2 range: one period is enough to bring the difference
+// into [-pi, pi)
+//
+static inline __m128d batchDeltaPhi(const __m128d &phi,
+        const __m128d &other_phi)
+{
+    const __m128d pi = _mm_set1_pd(M_PI);
+    const __m128d two_pi = _mm_set1_pd(2 * M_PI);
+
+    __m128d delta = _mm_sub_pd(phi, other_phi);
+    delta = _mm_sub_pd(delta, _mm_and_pd(_mm_cmpge_pd(delta, pi), two_pi));
+    delta = _mm_add_pd(delta,
+            _mm_and_pd(_mm_cmplt_pd(delta, _mm_set1_pd(-M_PI)), two_pi));
+
+    return delta;
+}
+
+static inline __m128d batchDeltaR(const __m128d &eta, const __m128d &phi,
+        const __m128d &other_eta, const __m128d &other_phi)
+{
+    const __m128d delta_eta = _mm_sub_pd(eta, other_eta);
+    const __m128d delta_phi = batchDeltaPhi(phi, other_phi);
+
+    return _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(delta_eta, delta_eta),
+                                  _mm_mul_pd(delta_phi, delta_phi)));
+}
+#endif
+
+// Distance between directions of every hypothesis: other direction is the
+// same for all hypotheses if step is 0
+//
+static void batchDeltaR(const double *eta, const double *phi,
+        const double *other_eta, const double *other_phi,
+        const uint32_t &other_step,
+        const uint32_t &size,
+        double *delta_r)
+{
+    uint32_t index = 0;
+
+#ifdef __SSE2__
+    for(; size >= index + 2; index += 2)
+    {
+        const __m128d other_eta_pair = _mm_set_pd(
+                other_eta[(index + 1) * other_step],
+                other_eta[index * other_step]);
+        const __m128d other_phi_pair = _mm_set_pd(
+                other_phi[(index + 1) * other_step],
+                other_phi[index * other_step]);
+
+        _mm_storeu_pd(delta_r + index,
+                batchDeltaR(_mm_loadu_pd(eta + index),
+                            _mm_loadu_pd(phi + index),
+                            other_eta_pair,
+                            other_phi_pair));
+    }
+#endif
+
+    for(; size > index; ++index)
+    {
+        delta_r[index] = batchDeltaR(eta[index], phi[index],
+                                     other_eta[index * other_step],
+                                     other_phi[index * other_step]);
+    }
+}
+
+// Momentum and cos(theta) are computed in SSE2: log and atan2 are called
+// for every hypothesis
+//
+static void batchDirection(const Chi2Batch::P4s &p4,
+        const uint32_t &size,
+        double *eta,
+        double *phi)
+{
+    uint32_t index = 0;
+
+#ifdef __SSE2__
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1);
+    for(; size >= index + 2; index += 2)
+    {
+        const __m128d px = _mm_loadu_pd(p4.px + index);
+        const __m128d py = _mm_loadu_pd(p4.py + index);
+        const __m128d pz = _mm_loadu_pd(p4.pz + index);
+
+        const __m128d p = _mm_sqrt_pd(
+                _mm_add_pd(_mm_add_pd(_mm_mul_pd(px, px),
+                                      _mm_mul_pd(py, py)),
+                           _mm_mul_pd(pz, pz)));
+
+        // cos(theta) is 1 for zero momentum
+        //
+        const __m128d is_zero = _mm_cmpeq_pd(p, zero);
+        const __m128d cos_theta = _mm_or_pd(
+                _mm_andnot_pd(is_zero, _mm_div_pd(pz, p)),
+                _mm_and_pd(is_zero, one));
+
+        double cos_thetas[2];
+        _mm_storeu_pd(cos_thetas, cos_theta);
+
+        for(uint32_t lane = 0; 2 > lane; ++lane)
+        {
+            eta[index + lane] = batchEta(cos_thetas[lane],
+                                         p4.pz[index + lane]);
+            phi[index + lane] = batchPhi(p4.px[index + lane],
+                                         p4.py[index + lane]);
+        }
+    }
+#endif
+
+    for(; size > index; ++index)
+    {
+        eta[index] = batchEta(p4.px[index], p4.py[index], p4.pz[index]);
+        phi[index] = batchPhi(p4.px[index], p4.py[index]);
+    }
+}
+
+static void batchGet(LorentzVector &p4, const Chi2Batch::P4s &p4s,
+        const uint32_t &index)
+{
+    p4.set_e(p4s.e[index]);
+    p4.set_px(p4s.px[index]);
+    p4.set_py(p4s.py[index]);
+    p4.set_pz(p4s.pz[index]);
+}
+
+static void batchSet(Chi2Batch::P4s &p4s, const uint32_t &index,
+        const LorentzVector &p4)
+{
+    p4s.e[index] = p4.e();
+    p4s.px[index] = p4.px();
+    p4s.py[index] = p4.py();
+    p4s.pz[index] = p4.pz();
+}
+
+Chi2Batch::Best::Best():
+    valid(false),
+    ltop_chi2(FLT_MAX),
+    htop_chi2(FLT_MAX),
+    ltop_jets(0),
+    htop_jets(0),
+    neutrino_index(0)
+{
+}
+
+Chi2Batch::Chi2Batch():
+    size(0),
+    objects(0),
+    lepton_eta(0),
+    lepton_phi(0)
+{
+}
+
+void Chi2Batch::clear()
+{
+    size = 0;
+}
+
+bool Chi2Batch::full() const
+{
+    return SIZE == size;
+}
+
+void Chi2Batch::decay(const uint32_t &ltop_jets,
+        const uint32_t &htop_jets,
+        Generator::Hypothesis &hypothesis) const
+{
+    hypothesis.leptonic.clear();
+    hypothesis.hadronic.clear();
+    hypothesis.neutral.clear();
+
+    const uint32_t number_of_objects =
+        min<uint32_t>(objects->size(), Generator::MAX_OBJECTS);
+
+    Generator::Objects::const_iterator object = objects->begin();
+    for(uint32_t index = 0; number_of_objects > index; ++index, ++object)
+    {
+        if (ltop_jets & (1u << index))
+            hypothesis.leptonic.push_back(object);
+        else if (htop_jets & (1u << index))
+            hypothesis.hadronic.push_back(object);
+        else
+            hypothesis.neutral.push_back(object);
+    }
+}
+
+Chi2Hypothesis Chi2Batch::hypothesis(const uint32_t &index) const
+{
+    Generator::Hypothesis decay_hypothesis;
+    decay(ltop_jets[index], htop_jets[index], decay_hypothesis);
+
+    Chi2Hypothesis result(&decay_hypothesis);
+    result.lepton = lepton;
+
+    batchGet(result.ltop, ltop, index);
+    batchGet(result.neutrino, neutrino, index);
+    batchGet(result.ltop_jet, ltop_jet, index);
+    batchGet(result.htop, htop, index);
+
+    return result;
+}
+
+void Chi2Batch::push_back(const LorentzVector &neutrino_p4,
+        const LorentzVector &ltop_jet_p4,
+        const LorentzVector &htop_p4,
+        const uint32_t &ltop_jets_mask,
+        const uint32_t &htop_jets_mask,
+        const uint32_t &neutrino_solution)
+{
+    if (full())
+        return;
+
+    batchSet(neutrino, size, neutrino_p4);
+    batchSet(ltop_jet, size, ltop_jet_p4);
+    batchSet(htop, size, htop_p4);
+
+    ltop.e[size] = lepton.e() + ltop_jet_p4.e() + neutrino_p4.e();
+    ltop.px[size] = lepton.px() + ltop_jet_p4.px() + neutrino_p4.px();
+    ltop.py[size] = lepton.py() + ltop_jet_p4.py() + neutrino_p4.py();
+    ltop.pz[size] = lepton.pz() + ltop_jet_p4.pz() + neutrino_p4.pz();
+
+    ltop_jets[size] = ltop_jets_mask;
+    htop_jets[size] = htop_jets_mask;
+    neutrino_index[size] = neutrino_solution;
+
+    ++size;
+}
+
+
+
+// -- Chi2 Discriminator -------------------------------------------------------
+//
+void Chi2Discriminator::calculateBatch(const Chi2Batch &batch,
+        float *chi2) const
+{
+    for(uint32_t index = 0; batch.size > index; ++index)
+        chi2[index] += calculate(batch.hypothesis(index));
+}
+
+uint32_t Chi2Discriminator::id() const
+{
+    return core::ID<Chi2Discriminator>::get();
+}
+
+void Chi2Discriminator::print(std::ostream &out) const
+{
+}
+
+
+
+// -- Ltop mass Discriminator --------------------------------------------------
+//
+float LtopMassDiscriminator::calculate(const Chi2Hypothesis &hypothesis) const
+{
+    // Somehow g++ 4.3.4 can not find function in the base class
+    return Chi2Discriminator::calculate(mass(hypothesis.ltop));
+}
+
+void LtopMassDiscriminator::calculateBatch(const Chi2Batch &batch,
+        float *chi2) const
+{
+    double mass[Chi2Batch::SIZE];
+    batchMass(batch.ltop, batch.size, mass);
+
+    for(uint32_t index = 0; batch.size > index; ++index)
+        chi2[index] += Chi2Discriminator::calculate(mass[index]);
+}
+
+uint32_t LtopMassDiscriminator::id() const
+{
+    return core::ID<LtopMassDiscriminator>::get();
+}
+
+LtopMassDiscriminator::ObjectPtr LtopMassDiscriminator::clone() const
+{
+    return ObjectPtr(new LtopMassDiscriminator(*this));
+}
+
+
+
+// -- Htop mass Discriminator --------------------------------------------------
+//
+float HtopMassDiscriminator::calculate(const Chi2Hypothesis &hypothesis) const
+{
+    // Somehow g++ 4.3.4 can not find function in the base class
+    return Chi2Discriminator::calculate(mass(hypothesis.htop));
+}
+
+void HtopMassDiscriminator::calculateBatch(const Chi2Batch &batch,
+        float *chi2) const
+{
+    double mass[Chi2Batch::SIZE];
+    batchMass(batch.htop, batch.size, mass);
+
+    for(uint32_t index = 0; batch.size > index; ++index)
+        chi2[index] += Chi2Discriminator::calculate(mass[index]);
+}
+
+uint32_t HtopMassDiscriminator::id() const
+{
+    return core::ID<HtopMassDiscriminator>::get();
+}
+
+HtopMassDiscriminator::ObjectPtr HtopMassDiscriminator::clone() const
+{
+    return ObjectPtr(new HtopMassDiscriminator(*this));
+}
+
+
+
+// -- Delta Phi Discriminator --------------------------------------------------
+//
+float DeltaPhiDiscriminator::calculate(const Chi2Hypothesis &hypothesis) const
+{
+    // Somehow g++ 4.3.4 can not find function in the base class
+    return Chi2Discriminator::calculate(fabs(dphi(hypothesis.ltop, hypothesis.htop)));
+}
+
+void DeltaPhiDiscriminator::calculateBatch(const Chi2Batch &batch,
+        float *chi2) const
+{
+    double ltop_phi[Chi2Batch::SIZE];
+    double htop_phi[Chi2Batch::SIZE];
+    for(uint32_t index = 0; batch.size > index; ++index)
+    {
+        ltop_phi[index] = batchPhi(batch.ltop.px[index], batch.ltop.py[index]);
+        htop_phi[index] = batchPhi(batch.htop.px[index], batch.htop.py[index]);
+    }
+
+    uint32_t index = 0;
+
+#ifdef __SSE2__
+    const __m128d sign = _mm_set1_pd(-0.0);
+    for(; batch.size >= index + 2; index += 2)
+    {
+        double delta_phi[2];
+        _mm_storeu_pd(delta_phi,
+                _mm_andnot_pd(sign,
+                    batchDeltaPhi(_mm_loadu_pd(ltop_phi + index),
+                                  _mm_loadu_pd(htop_phi + index))));
+
+        chi2[index] += Chi2Discriminator::calculate(delta_phi[0]);
+        chi2[index + 1] += Chi2Discriminator::calculate(delta_phi[1]);
+    }
+#endif
+
+    for(; batch.size > index; ++index)
+    {
+        const double delta_phi = batchDeltaPhi(ltop_phi[index],
+                                               htop_phi[index]);
+
+        chi2[index] += Chi2Discriminator::calculate(fabs(delta_phi));
+    }
+}
+
+uint32_t DeltaPhiDiscriminator::id() const
+{
+    return core::ID<DeltaPhiDiscriminator>::get();
+}
+
+DeltaPhiDiscriminator::ObjectPtr DeltaPhiDiscriminator::clone() const
+{
+    return ObjectPtr(new DeltaPhiDiscriminator(*this));
+}
+
+
+
+// -- Ltop Delta R sum discriminator -------------------------------------------
+//
+float LtopDeltaRSumDiscriminator::calculate(const Chi2Hypothesis &hypothesis)
+    const
+{
+    const LorentzVector &top = hypothesis.ltop;
+
+    // Somehow g++ 4.3.4 can not find function in the base class
+    return Chi2Discriminator::calculate(dr(top, hypothesis.lepton) +
+                                        dr(top, hypothesis.neutrino) +
+                                        dr(top, hypothesis.ltop_jet));
+}
+
+void LtopDeltaRSumDiscriminator::calculateBatch(const Chi2Batch &batch,
+        float *chi2) const
+{
+    double top_eta[Chi2Batch::SIZE];
+    double top_phi[Chi2Batch::SIZE];
+    batchDirection(batch.ltop, batch.size, top_eta, top_phi);
+
+    double neutrino_eta[Chi2Batch::SIZE];
+    double neutrino_phi[Chi2Batch::SIZE];
+    batchDirection(batch.neutrino, batch.size, neutrino_eta, neutrino_phi);
+
+    double jet_eta[Chi2Batch::SIZE];
+    double jet_phi[Chi2Batch::SIZE];
+    batchDirection(batch.ltop_jet, batch.size, jet_eta, jet_phi);
+
+    double lepton_dr[Chi2Batch::SIZE];
+    batchDeltaR(top_eta, top_phi, &batch.lepton_eta, &batch.lepton_phi, 0,
+            batch.size, lepton_dr);
+
+    double neutrino_dr[Chi2Batch::SIZE];
+    batchDeltaR(top_eta, top_phi, neutrino_eta, neutrino_phi, 1,
+            batch.size, neutrino_dr);
+
+    double jet_dr[Chi2Batch::SIZE];
+    batchDeltaR(top_eta, top_phi, jet_eta, jet_phi, 1,
+            batch.size, jet_dr);
+
+    for(uint32_t index = 0; batch.size > index; ++index)
+    {
+        chi2[index] += Chi2Discriminator::calculate(
+                lepton_dr[index] + neutrino_dr[index] + jet_dr[index]);
+    }
+}
+
+uint32_t LtopDeltaRSumDiscriminator::id() const
+{
+    return core::ID<LtopDeltaRSumDiscriminator>::get();
+}
+
+LtopDeltaRSumDiscriminator::ObjectPtr LtopDeltaRSumDiscriminator::clone() const
+{
+    return ObjectPtr(new LtopDeltaRSumDiscriminator(*this));
+}
+
+
+
+
+// -- Htop Delta R sum discriminator -------------------------------------------
+//
+float HtopDeltaRSumDiscriminator::calculate(const Chi2Hypothesis &hypothesis)
+    const
+{
+    const LorentzVector &top = hypothesis.htop;
+     
+    float discriminator = 0;
+    for(Chi2Hypothesis::DecayHypothesis::Iterators::const_iterator jet =
+                hypothesis.htop_jets.begin();
+            hypothesis.htop_jets.end() != jet;
+            ++jet)
+    {
+        discriminator += dr(top, *(*jet)->corrected_p4);
+    }
+
+    // Somehow g++ 4.3.4 can not find function in the base class
+    return Chi2Discriminator::calculate(discriminator);
+}
+
+void HtopDeltaRSumDiscriminator::calculateBatch(const Chi2Batch &batch,
+        float *chi2) const
+{
+    double top_eta[Chi2Batch::SIZE];
+    double top_phi[Chi2Batch::SIZE];
+    batchDirection(batch.htop, batch.size, top_eta, top_phi);
+
+    uint32_t index = 0;
+
+#ifdef __SSE2__
+    // Every jet is added to both hypotheses of the pair with weight 1 if
+    // jet belongs to the hypothesis and 0 otherwise. Sum is rounded to float
+    // after every jet as in the scalar loop
+    //
+    for(; batch.size >= index + 2; index += 2)
+    {
+        const __m128d eta = _mm_loadu_pd(top_eta + index);
+        const __m128d phi = _mm_loadu_pd(top_phi + index);
+
+        const uint32_t &jets = batch.htop_jets[index];
+        const uint32_t &next_jets = batch.htop_jets[index + 1];
+
+        __m128d discriminator = _mm_setzero_pd();
+        for(uint32_t jet = 0; (jets | next_jets) >> jet; ++jet)
+        {
+            if (!((jets | next_jets) & (1u << jet)))
+                continue;
+
+            const __m128d weight = _mm_set_pd((next_jets >> jet) & 1,
+                                              (jets >> jet) & 1);
+
+            const __m128d delta_r = batchDeltaR(eta, phi,
+                    _mm_set1_pd(batch.jets.eta[jet]),
+                    _mm_set1_pd(batch.jets.phi[jet]));
+
+            discriminator = _mm_cvtps_pd(_mm_cvtpd_ps(
+                        _mm_add_pd(discriminator,
+                                   _mm_mul_pd(weight, delta_r))));
+        }
+
+        double discriminators[2];
+        _mm_storeu_pd(discriminators, discriminator);
+
+        chi2[index] += Chi2Discriminator::calculate(discriminators[0]);
+        chi2[index + 1] += Chi2Discriminator::calculate(discriminators[1]);
+    }
+#endif
+
+    for(; batch.size > index; ++index)
+    {
+        // Jets are summed in the order of the hypothesis
+        //
+        float discriminator = 0;
+        for(uint32_t jets = batch.htop_jets[index], jet = 0;
+                jets;
+                jets >>= 1, ++jet)
+        {
+            if (jets & 1)
+                discriminator += batchDeltaR(top_eta[index], top_phi[index],
+                                             batch.jets.eta[jet],
+                                             batch.jets.phi[jet]);
+        }
+
+        chi2[index] += Chi2Discriminator::calculate(discriminator);
+    }
+}
+
+uint32_t HtopDeltaRSumDiscriminator::id() const
+{
+    return core::ID<HtopDeltaRSumDiscriminator>::get();
+}
+
+HtopDeltaRSumDiscriminator::ObjectPtr HtopDeltaRSumDiscriminator::clone() const
+{
+    return ObjectPtr(new HtopDeltaRSumDiscriminator(*this));
+}
+
+
+
+// -- Reconstruction with ltop/htop chi2 ---------------------------------------
+//
+Chi2ResonanceReconstructor::Chi2ResonanceReconstructor(
+        const Chi2ResonanceReconstructor &object):
+    SimpleResonanceReconstructor(object),
+    _batch(object._batch)
+{
+    for(Chi2Discriminators::const_iterator ltop =
+            object._ltop_discriminators.begin();
+        object._ltop_discriminators.end() != ltop;
+        ++ltop)
+    {
+        _ltop_discriminators.push_back(
+                dynamic_pointer_cast<Chi2Discriminator>((*ltop)->clone()));
+    }
+
+    for(Chi2Discriminators::const_iterator htop =
+            object._htop_discriminators.begin();
+        object._htop_discriminators.end() != htop;
+        ++htop)
+    {
+        _htop_discriminators.push_back(
+                dynamic_pointer_cast<Chi2Discriminator>((*htop)->clone()));
+    }
+}
+
+uint32_t Chi2ResonanceReconstructor::id() const
+{
+    return core::ID<Chi2ResonanceReconstructor>::get();
+}
+
+Chi2ResonanceReconstructor::ObjectPtr
+    Chi2ResonanceReconstructor::clone() const
+{
+    return ObjectPtr(new Chi2ResonanceReconstructor(*this));
+}
+
+void Chi2ResonanceReconstructor::print(std::ostream &out) const
+{
+    out << "Chi2ResonanceReconstructor" << endl;
+}
+
+void Chi2ResonanceReconstructor::setLtopDiscriminators(
+        const Chi2Discriminators &discriminators)
+{
+    _ltop_discriminators = discriminators;
+}
+
+void Chi2ResonanceReconstructor::setHtopDiscriminators(
+        const Chi2Discriminators &discriminators)
+{
+    _htop_discriminators = discriminators;
+}
+
+void Chi2ResonanceReconstructor::setBatch(const bool &batch)
+{
+    _batch = batch;
+}
+
+bool Chi2ResonanceReconstructor::batch() const
+{
+    return _batch;
+}
+
+Chi2ResonanceReconstructor::Mttbar Chi2ResonanceReconstructor::run(
+        const LorentzVector &lepton,
+        const LorentzVector &met,
+        const SynchSelector::GoodJets &jets) const
+{
+    Mttbar result;
+
+    // Reconstruct the neutrino pZ and keep solutions in vector for later
+    // use
+    //
+    NeutrinoReconstruct neutrinoReconstruct;
+    neutrinoReconstruct(lepton, met, result.neutrinos);
+
+    result.solutions = neutrinoReconstruct.solutions();
+
+    const NeutrinoReconstruct::Solutions &neutrinos = result.neutrinos;
+
+    Chi2Hypothesis best_chi2_hypothesis;
+
+    if (_batch)
+        best_chi2_hypothesis = runBatch(lepton, neutrinos, jets);
+    else
+    {
+        // Prepare generator and loop over all hypotheses of the decay
+        // (different jets assignment to leptonic/hadronic legs)
+        //
+        Generator generator;
+        generator.init(jets);
+
+        // Loop over all possible hypotheses and pick the best one
+        // Note: take into account all reconstructed neutrino solutions
+        //
+        do
+        {
+            const Generator::Hypothesis &hypothesis = generator.hypothesis();
+
+            if (!isValidHadronicSide(lepton, hypothesis.hadronic)
+                    || !isValidLeptonicSide(lepton, hypothesis.leptonic)
+                    || !isValidNeutralSide(lepton, hypothesis.neutral))
+
+                    continue;
+
+            Chi2Hypothesis chi2_hypothesis(&hypothesis);
+            prepare(lepton, chi2_hypothesis);
+
+            // Take into account all neutrino solutions. Solutions are kept
+            // in a vector of pointer
+            //
+            for(NeutrinoReconstruct::Solutions::const_iterator neutrino =
+                        neutrinos.begin();
+                    neutrinos.end() != neutrino;
+                    ++neutrino)
+            {
+                Chi2Hypothesis chi2_hypothesis_tmp = chi2_hypothesis;
+                chi2_hypothesis_tmp.neutrino = *neutrino;
+                chi2_hypothesis_tmp.ltop += chi2_hypothesis_tmp.neutrino;
+
+                chi2_hypothesis_tmp.ltop_chi2 = ltopChi2(chi2_hypothesis_tmp);
+                if (chi2_hypothesis_tmp.ltop_chi2
+                        > best_chi2_hypothesis.ltop_chi2)
+
+                    continue;
+
+                chi2_hypothesis_tmp.htop_chi2 = htopChi2(chi2_hypothesis_tmp);
+                if (chi2_hypothesis_tmp.ltop_chi2
+                            == best_chi2_hypothesis.ltop_chi2
+                        && chi2_hypothesis_tmp.htop_chi2
+                            > best_chi2_hypothesis.htop_chi2)
+
+                    continue;
+
+                best_chi2_hypothesis = chi2_hypothesis_tmp;
+                best_chi2_hypothesis.valid = true;
+            }
+        }
+        while(generator.next());
+    }
+
+    // Best Solution is found
+    //
+    if (best_chi2_hypothesis.valid)
+    {
+        result.mttbar = best_chi2_hypothesis.ltop + best_chi2_hypothesis.htop;
+        result.wlep = best_chi2_hypothesis.neutrino + best_chi2_hypothesis.lepton;
+        result.neutrino = best_chi2_hypothesis.neutrino;
+        result.ltop = best_chi2_hypothesis.ltop;
+        result.ltop_jet = best_chi2_hypothesis.ltop_jet;
+        result.htop = best_chi2_hypothesis.htop;
+        result.htop_njets = best_chi2_hypothesis.htop_jets.size();
+
+        result.ltop_discriminator = best_chi2_hypothesis.ltop_chi2;
+        result.htop_discriminator = best_chi2_hypothesis.htop_chi2;
+
+        result.htop_jets.clear();
+        for(Chi2Hypothesis::Iterators::const_iterator jet =
+                    best_chi2_hypothesis.htop_jets.begin();
+                best_chi2_hypothesis.htop_jets.end() != jet;
+                ++jet)
+        {
+            result.htop_jets.push_back(* *jet);
+        }
+
+        result.ltop_jets.clear();
+        for(Chi2Hypothesis::Iterators::const_iterator jet =
+                    best_chi2_hypothesis.ltop_jets.begin();
+                best_chi2_hypothesis.ltop_jets.end() != jet;
+                ++jet)
+        {
+            result.ltop_jets.push_back(* *jet);
+        }
+
+        sort(result.htop_jets.begin(), result.htop_jets.end(), CorrectedPtGreater()); 
+        sort(result.ltop_jets.begin(), result.ltop_jets.end(), CorrectedPtGreater()); 
+
+        result.valid = true;
+    }
+
+    return result;
+}
+
+// Private
+//
+void Chi2ResonanceReconstructor::prepare(const LorentzVector &lepton,
+        Chi2Hypothesis &hypothesis) const
+{
+    // Leptonic Top p4 = leptonP4 + nuP4 + bP4
+    // where bP4 is:
+    //  - b-tagged jet
+    //  - otherwise, the hardest jet (highest pT)
+    //
+    hypothesis.lepton = lepton;
+    hypothesis.ltop_jet = getLeptonicJet(hypothesis.ltop_jets);
+
+    hypothesis.ltop = lepton + hypothesis.ltop_jet;
+
+    // the neutrino will be taken into account later
+    //
+
+    // htop is a sum of all jet p4s assigned to the hadronic leg
+    //
+    for(Generator::Iterators::const_iterator jet =
+                hypothesis.htop_jets.begin();
+            hypothesis.htop_jets.end() != jet;
+            ++jet)
+    {
+        hypothesis.htop += *(*jet)->corrected_p4;
+    }
+}
+
+float Chi2ResonanceReconstructor::ltopChi2(
+        const Chi2Hypothesis &hypothesis) const
+{
+    float chi2 = 0;
+    for(Chi2Discriminators::const_iterator discriminator =
+                _ltop_discriminators.begin();
+            _ltop_discriminators.end() != discriminator;
+            ++discriminator)
+    {
+        chi2 += (*discriminator)->calculate(hypothesis);
+    }
+
+    return chi2;
+}
+
+float Chi2ResonanceReconstructor::htopChi2(
+        const Chi2Hypothesis &hypothesis) const
+{
+    float chi2 = 0;
+    for(Chi2Discriminators::const_iterator discriminator =
+                _htop_discriminators.begin();
+            _htop_discriminators.end() != discriminator;
+            ++discriminator)
+    {
+        chi2 += (*discriminator)->calculate(hypothesis);
+    }
+
+    return chi2;
+}
+
+Chi2Hypothesis Chi2ResonanceReconstructor::runBatch(
+        const LorentzVector &lepton,
+        const NeutrinoReconstruct::Solutions &neutrinos,
+        const SynchSelector::GoodJets &jets) const
+{
+    Chi2Batch batch;
+    batch.objects = &jets;
+    batch.lepton = lepton;
+    batch.lepton_eta = batchEta(lepton.px(), lepton.py(), lepton.pz());
+    batch.lepton_phi = batchPhi(lepton.px(), lepton.py());
+
+    // Jets are copied into arrays once per event
+    //
+    const uint32_t number_of_jets =
+        min<uint32_t>(jets.size(), Generator::MAX_OBJECTS);
+
+    for(uint32_t index = 0; number_of_jets > index; ++index)
+    {
+        const LorentzVector &p4 = *jets[index].corrected_p4;
+
+        batch.jets.e[index] = p4.e();
+        batch.jets.px[index] = p4.px();
+        batch.jets.py[index] = p4.py();
+        batch.jets.pz[index] = p4.pz();
+        batch.jets.eta[index] = batchEta(p4.px(), p4.py(), p4.pz());
+        batch.jets.phi[index] = batchPhi(p4.px(), p4.py());
+    }
+
+    Generator generator;
+    generator.init(jets);
+
+    Chi2Batch::Best best;
+    LorentzVector htop;
+    do
+    {
+        const Generator::Hypothesis &hypothesis = generator.hypothesis();
+
+        if (!isValidHadronicSide(lepton, hypothesis.hadronic)
+                || !isValidLeptonicSide(lepton, hypothesis.leptonic)
+                || !isValidNeutralSide(lepton, hypothesis.neutral))
+
+                continue;
+
+        const LorentzVector ltop_jet = getLeptonicJet(hypothesis.leptonic);
+
+        uint32_t ltop_jets = 0;
+        for(Generator::Iterators::const_iterator jet =
+                    hypothesis.leptonic.begin();
+                hypothesis.leptonic.end() != jet;
+                ++jet)
+        {
+            ltop_jets |= 1u << (*jet - jets.begin());
+        }
+
+        // htop is a sum of all jet p4s assigned to the hadronic leg
+        //
+        uint32_t htop_jets = 0;
+        double htop_e = 0;
+        double htop_px = 0;
+        double htop_py = 0;
+        double htop_pz = 0;
+        for(Generator::Iterators::const_iterator jet =
+                    hypothesis.hadronic.begin();
+                hypothesis.hadronic.end() != jet;
+                ++jet)
+        {
+            const uint32_t index = *jet - jets.begin();
+
+            htop_jets |= 1u << index;
+
+            htop_e += batch.jets.e[index];
+            htop_px += batch.jets.px[index];
+            htop_py += batch.jets.py[index];
+            htop_pz += batch.jets.pz[index];
+        }
+
+        htop.set_e(htop_e);
+        htop.set_px(htop_px);
+        htop.set_py(htop_py);
+        htop.set_pz(htop_pz);
+
+        for(uint32_t neutrino = 0; neutrinos.size() > neutrino; ++neutrino)
+        {
+            batch.push_back(neutrinos[neutrino], ltop_jet, htop,
+                            ltop_jets, htop_jets, neutrino);
+
+            if (batch.full())
+                score(batch, best);
+        }
+    }
+    while(generator.next());
+
+    score(batch, best);
+
+    if (!best.valid)
+        return Chi2Hypothesis();
+
+    // Chi2 of the best hypothesis is calculated one by one to report
+    // the same values as regular search
+    //
+    Generator::Hypothesis hypothesis;
+    batch.decay(best.ltop_jets, best.htop_jets, hypothesis);
+
+    Chi2Hypothesis result(&hypothesis);
+    prepare(lepton, result);
+
+    result.neutrino = neutrinos[best.neutrino_index];
+    result.ltop += result.neutrino;
+
+    result.ltop_chi2 = ltopChi2(result);
+    result.htop_chi2 = htopChi2(result);
+    result.valid = true;
+
+    return result;
+}
+
+void Chi2ResonanceReconstructor::score(Chi2Batch &batch,
+        Chi2Batch::Best &best) const
+{
+    fill(batch.ltop_chi2, batch.ltop_chi2 + batch.size, 0);
+    fill(batch.htop_chi2, batch.htop_chi2 + batch.size, 0);
+
+    for(Chi2Discriminators::const_iterator discriminator =
+                _ltop_discriminators.begin();
+            _ltop_discriminators.end() != discriminator;
+            ++discriminator)
+    {
+        (*discriminator)->calculateBatch(batch, batch.ltop_chi2);
+    }
+
+    for(Chi2Discriminators::const_iterator discriminator =
+                _htop_discriminators.begin();
+            _htop_discriminators.end() != discriminator;
+            ++discriminator)
+    {
+        (*discriminator)->calculateBatch(batch, batch.htop_chi2);
     }
-}
 
+    // Hypotheses are compared in the order of the regular search
+    //
+    for(uint32_t index = 0; batch.size > index; ++index)
+    {
+        const float &ltop_chi2 = batch.ltop_chi2[index];
+        const float &htop_chi2 = batch.htop_chi2[index];
 
+        if (ltop_chi2 > best.ltop_chi2
+                || (ltop_chi2 == best.ltop_chi2
+                    && htop_chi2 > best.htop_chi2))
 
-// -- Chi2 Discriminator -------------------------------------------------------
-//
-uint32_t Chi2Discriminator::id() const
-{
-    return core::ID<Chi2Discriminator>::get();
-}
+            continue;
 
-void Chi2Discriminator::print(std::ostream &out) const
-{
+        best.ltop_chi2 = ltop_chi2;
+        best.htop_chi2 = htop_chi2;
+        best.ltop_jets = batch.ltop_jets[index];
+        best.htop_jets = batch.htop_jets[index];
+        best.neutrino_index = batch.neutrino_index[index];
+        best.valid = true;
+    }
+
+    batch.clear();
 }
 
 
 
-// -- Ltop mass Discriminator --------------------------------------------------
+// -- Resonance Shootout -------------------------------------------------------
 //
-float LtopMassDiscriminator::calculate(const Chi2Hypothesis &hypothesis) const
-{
-    // Somehow g++ 4.3.4 can not find function in the base class
-    return Chi2Discriminator::calculate(mass(hypothesis.ltop));
-}
-
-uint32_t LtopMassDiscriminator::id() const
+ResonanceShootout::Entry::Entry(const std::string &name,
+        const ReconstructorPtr &reconstructor):
+    name(name),
+    reconstructor(reconstructor),
+    is_standalone(dynamic_pointer_cast<Chi2ResonanceReconstructor>(
+                reconstructor))
 {
-    return core::ID<LtopMassDiscriminator>::get();
 }
 
-LtopMassDiscriminator::ObjectPtr LtopMassDiscriminator::clone() const
+ResonanceShootout::ResonanceShootout()
 {
-    return ObjectPtr(new LtopMassDiscriminator(*this));
 }
 
-
-
-// -- Htop mass Discriminator --------------------------------------------------
-//
-float HtopMassDiscriminator::calculate(const Chi2Hypothesis &hypothesis) const
+ResonanceShootout::ResonanceShootout(const ResonanceShootout &object)
 {
-    // Somehow g++ 4.3.4 can not find function in the base class
-    return Chi2Discriminator::calculate(mass(hypothesis.htop));
+    for(Entries::const_iterator entry = object._entries.begin();
+            object._entries.end() != entry;
+            ++entry)
+    {
+        add(entry->name,
+            dynamic_pointer_cast<ResonanceReconstructor>(
+                entry->reconstructor->clone()));
+    }
 }
 
-uint32_t HtopMassDiscriminator::id() const
+void ResonanceShootout::add(const std::string &name,
+        const ReconstructorPtr &reconstructor)
 {
-    return core::ID<HtopMassDiscriminator>::get();
+    _entries.push_back(Entry(name, reconstructor));
 }
 
-HtopMassDiscriminator::ObjectPtr HtopMassDiscriminator::clone() const
+uint32_t ResonanceShootout::size() const
 {
-    return ObjectPtr(new HtopMassDiscriminator(*this));
+    return _entries.size();
 }
 
-
-
-// -- Delta Phi Discriminator --------------------------------------------------
-//
-float DeltaPhiDiscriminator::calculate(const Chi2Hypothesis &hypothesis) const
+const std::string &ResonanceShootout::name(const uint32_t &index) const
 {
-    // Somehow g++ 4.3.4 can not find function in the base class
-    return Chi2Discriminator::calculate(fabs(dphi(hypothesis.ltop, hypothesis.htop)));
+    return _entries.at(index).name;
 }
 
-uint32_t DeltaPhiDiscriminator::id() const
+const ResonanceShootout::ReconstructorPtr
+    ResonanceShootout::reconstructor(const uint32_t &index) const
 {
-    return core::ID<DeltaPhiDiscriminator>::get();
+    return _entries.at(index).reconstructor;
 }
 
-DeltaPhiDiscriminator::ObjectPtr DeltaPhiDiscriminator::clone() const
+void ResonanceShootout::run(const LorentzVector &lepton,
+        const LorentzVector &met,
+        const SynchSelector::GoodJets &jets,
+        Results &results) const
 {
-    return ObjectPtr(new DeltaPhiDiscriminator(*this));
-}
+    // Neutrino solutions are shared by all reconstructors
+    //
+    Mttbar prototype;
 
+    NeutrinoReconstruct neutrinoReconstruct;
+    neutrinoReconstruct(lepton, met, prototype.neutrinos);
 
+    prototype.solutions = neutrinoReconstruct.solutions();
 
-// -- Ltop Delta R sum discriminator -------------------------------------------
-//
-float LtopDeltaRSumDiscriminator::calculate(const Chi2Hypothesis &hypothesis)
-    const
-{
-    const LorentzVector &top = hypothesis.ltop;
+    const NeutrinoReconstruct::Solutions &neutrinos = prototype.neutrinos;
 
-    // Somehow g++ 4.3.4 can not find function in the base class
-    return Chi2Discriminator::calculate(dr(top, hypothesis.lepton) +
-                                        dr(top, hypothesis.neutrino) +
-                                        dr(top, hypothesis.ltop_jet));
-}
+    Solutions best_solutions(_entries.size());
 
-uint32_t LtopDeltaRSumDiscriminator::id() const
-{
-    return core::ID<LtopDeltaRSumDiscriminator>::get();
-}
+    Generator generator;
+    generator.init(jets);
 
-LtopDeltaRSumDiscriminator::ObjectPtr LtopDeltaRSumDiscriminator::clone() const
-{
-    return ObjectPtr(new LtopDeltaRSumDiscriminator(*this));
-}
+    do
+    {
+        const Generator::Hypothesis &hypothesis = generator.hypothesis();
 
+        // htop is a sum of all jet p4s assigned to the hadronic leg
+        //
+        LorentzVector htop;
+        for(Generator::Iterators::const_iterator jet =
+                    hypothesis.hadronic.begin();
+                hypothesis.hadronic.end() != jet;
+                ++jet)
+        {
+            htop += *(*jet)->corrected_p4;
+        }
 
+        for(uint32_t index = 0; _entries.size() > index; ++index)
+        {
+            const Entry &entry = _entries[index];
+            if (entry.is_standalone)
+                continue;
 
+            entry.reconstructor->evaluate(lepton, neutrinos, hypothesis,
+                    generator.index(), &htop, best_solutions[index]);
+        }
+    }
+    while(generator.next());
 
-// -- Htop Delta R sum discriminator -------------------------------------------
-//
-float HtopDeltaRSumDiscriminator::calculate(const Chi2Hypothesis &hypothesis)
-    const
-{
-    const LorentzVector &top = hypothesis.htop;
-     
-    float discriminator = 0;
-    for(Chi2Hypothesis::DecayHypothesis::Iterators::const_iterator jet =
-                hypothesis.htop_jets.begin();
-            hypothesis.htop_jets.end() != jet;
-            ++jet)
+    results.assign(_entries.size(), prototype);
+    for(uint32_t index = 0; _entries.size() > index; ++index)
     {
-        discriminator += dr(top, *(*jet)->corrected_p4);
+        const Entry &entry = _entries[index];
+        if (entry.is_standalone)
+            results[index] = entry.reconstructor->run(lepton, met, jets);
+        else
+            entry.reconstructor->fillResult(lepton, best_solutions[index],
+                    results[index]);
     }
-
-    // Somehow g++ 4.3.4 can not find function in the base class
-    return Chi2Discriminator::calculate(discriminator);
 }
 
-uint32_t HtopDeltaRSumDiscriminator::id() const
+uint32_t ResonanceShootout::id() const
 {
-    return core::ID<HtopDeltaRSumDiscriminator>::get();
+    return core::ID<ResonanceShootout>::get();
 }
 
-HtopDeltaRSumDiscriminator::ObjectPtr HtopDeltaRSumDiscriminator::clone() const
+ResonanceShootout::ObjectPtr ResonanceShootout::clone() const
 {
-    return ObjectPtr(new HtopDeltaRSumDiscriminator(*this));
+    return ObjectPtr(new ResonanceShootout(*this));
 }
 
-
-
-// -- Reconstruction with ltop/htop chi2 ---------------------------------------
-//
-Chi2ResonanceReconstructor::Chi2ResonanceReconstructor(
-        const Chi2ResonanceReconstructor &object)
+void ResonanceShootout::print(std::ostream &out) const
 {
-    for(Chi2Discriminators::const_iterator ltop =
-            object._ltop_discriminators.begin();
-        object._ltop_discriminators.end() != ltop;
-        ++ltop)
-    {
-        _ltop_discriminators.push_back(
-                dynamic_pointer_cast<Chi2Discriminator>((*ltop)->clone()));
-    }
-
-    for(Chi2Discriminators::const_iterator htop =
-            object._htop_discriminators.begin();
-        object._htop_discriminators.end() != htop;
-        ++htop)
+    out << "ResonanceShootout:" << endl;
+    for(Entries::const_iterator entry = _entries.begin();
+            _entries.end() != entry;
+            ++entry)
     {
-        _htop_discriminators.push_back(
-                dynamic_pointer_cast<Chi2Discriminator>((*htop)->clone()));
+        out << "  " << entry->name << ": " << *entry->reconstructor;
     }
 }
 
-uint32_t Chi2ResonanceReconstructor::id() const
+
+
+// -- Jet Truncation -----------------------------------------------------------
+//
+JetTruncation::JetTruncation():
+    _max_jets(0),
+    _keep_btags(false)
 {
-    return core::ID<Chi2ResonanceReconstructor>::get();
 }
 
-Chi2ResonanceReconstructor::ObjectPtr
-    Chi2ResonanceReconstructor::clone() const
+void JetTruncation::setMaxJets(const uint32_t &max_jets)
 {
-    return ObjectPtr(new Chi2ResonanceReconstructor(*this));
+    _max_jets = max_jets;
 }
 
-void Chi2ResonanceReconstructor::print(std::ostream &out) const
+uint32_t JetTruncation::maxJets() const
 {
-    out << "Chi2ResonanceReconstructor" << endl;
+    return _max_jets;
 }
 
-void Chi2ResonanceReconstructor::setLtopDiscriminators(
-        const Chi2Discriminators &discriminators)
+void JetTruncation::setKeepBtags(const bool &keep_btags)
 {
-    _ltop_discriminators = discriminators;
+    _keep_btags = keep_btags;
 }
 
-void Chi2ResonanceReconstructor::setHtopDiscriminators(
-        const Chi2Discriminators &discriminators)
+bool JetTruncation::keepBtags() const
 {
-    _htop_discriminators = discriminators;
+    return _keep_btags;
 }
 
-Chi2ResonanceReconstructor::Mttbar Chi2ResonanceReconstructor::run(
-        const LorentzVector &lepton,
-        const LorentzVector &met,
-        const SynchSelector::GoodJets &jets) const
+bool JetTruncation::apply(const GoodJets &jets, GoodJets &kept) const
 {
-    Mttbar result;
-
-    // Reconstruct the neutrino pZ and keep solutions in vector for later
-    // use
-    //
-    NeutrinoReconstruct neutrinoReconstruct;
-    NeutrinoReconstruct::Solutions neutrinos =
-        neutrinoReconstruct(lepton, met);
-
-    result.solutions = neutrinoReconstruct.solutions();
+    if (!_max_jets
+            || _max_jets >= jets.size())
+        return false;
 
-    for(NeutrinoReconstruct::Solutions::const_iterator neutrino =
-                neutrinos.begin();
-            neutrinos.end() != neutrino;
-            ++neutrino)
-    {
-        result.neutrinos.push_back(**neutrino);
-    }
-
-    // Prepare generator and loop over all hypotheses of the decay
-    // (different jets assignment to leptonic/hadronic legs)
-    //
-    Generator generator;
-    generator.init(jets);
-
-    Chi2Hypothesis best_chi2_hypothesis;
-
-    // Loop over all possible hypotheses and pick the best one
-    // Note: take into account all reconstructed neutrino solutions
-    //
-    do
+    GoodJets::const_iterator jet = jets.begin();
+    uint32_t leading_jets = 0;
+    if (_keep_btags)
     {
-        Generator::Hypothesis hypothesis = generator.hypothesis();
-
-        if (!isValidHadronicSide(lepton, hypothesis.hadronic)
-                || !isValidLeptonicSide(lepton, hypothesis.leptonic)
-                || !isValidNeutralSide(lepton, hypothesis.neutral))
-
-                continue;
-
-        Chi2Hypothesis chi2_hypothesis(&hypothesis);
-
-        // Leptonic Top p4 = leptonP4 + nuP4 + bP4
-        // where bP4 is:
-        //  - b-tagged jet
-        //  - otherwise, the hardest jet (highest pT)
-        //
-        chi2_hypothesis.lepton = lepton;
-        chi2_hypothesis.ltop_jet =
-            getLeptonicJet(chi2_hypothesis.ltop_jets);
-
-        chi2_hypothesis.ltop = lepton + chi2_hypothesis.ltop_jet;
-
-        // the neutrino will be taken into account later
-        //
-
-        // htop is a sum of all jet p4s assigned to the hadronic leg
+        // Count kept jets first: nothing is dropped if all jets beyond the
+        // leading ones are b-tagged
         //
-        for(Generator::Iterators::const_iterator jet =
-                    chi2_hypothesis.htop_jets.begin();
-                chi2_hypothesis.htop_jets.end() != jet;
-                ++jet)
+        leading_jets = _max_jets;
+        for(jet += _max_jets; jets.end() != jet; ++jet)
         {
-            chi2_hypothesis.htop += *(*jet)->corrected_p4;
+            if (isBtagJet(*jet))
+                ++leading_jets;
         }
 
-        // Take into account all neutrino solutions. Solutions are kept in
-        // a vector of pointer
-        //
-        for(NeutrinoReconstruct::Solutions::const_iterator neutrino =
-                    neutrinos.begin();
-                neutrinos.end() != neutrino;
-                ++neutrino)
-        {
-            Chi2Hypothesis chi2_hypothesis_tmp = chi2_hypothesis;
-            chi2_hypothesis_tmp.neutrino = *(*neutrino);
-            chi2_hypothesis_tmp.ltop += chi2_hypothesis_tmp.neutrino;
-
-            // Apply ltop discriminators
-            chi2_hypothesis_tmp.ltop_chi2 = 0;
-            for(Chi2Discriminators::const_iterator discriminator =
-                        _ltop_discriminators.begin();
-                    _ltop_discriminators.end() != discriminator;
-                    ++discriminator)
-            {
-                chi2_hypothesis_tmp.ltop_chi2 +=
-                    (*discriminator)->calculate(chi2_hypothesis_tmp);
-            }
-
-            if (chi2_hypothesis_tmp.ltop_chi2 > best_chi2_hypothesis.ltop_chi2)
-                continue;
+        if (jets.size() == leading_jets)
+            return false;
 
-            // Apply htop discriminators
-            chi2_hypothesis_tmp.htop_chi2 = 0;
-            for(Chi2Discriminators::const_iterator discriminator =
-                        _htop_discriminators.begin();
-                    _htop_discriminators.end() != discriminator;
-                    ++discriminator)
-            {
-                chi2_hypothesis_tmp.htop_chi2 +=
-                    (*discriminator)->calculate(chi2_hypothesis_tmp);
-            }
+        jet = jets.begin();
+    }
 
-            if (chi2_hypothesis_tmp.ltop_chi2 == best_chi2_hypothesis.ltop_chi2
-                    && chi2_hypothesis_tmp.htop_chi2 > best_chi2_hypothesis.htop_chi2)
-                continue;
+    kept.clear();
+    kept.reserve(_keep_btags ? leading_jets : _max_jets);
+    kept.insert(kept.end(), jet, jet + _max_jets);
 
-            best_chi2_hypothesis = chi2_hypothesis_tmp;
-            best_chi2_hypothesis.valid = true;
+    if (_keep_btags)
+    {
+        for(jet += _max_jets; jets.end() != jet; ++jet)
+        {
+            if (isBtagJet(*jet))
+                kept.push_back(*jet);
         }
     }
-    while(generator.next());
 
-    // Best Solution is found
-    //
-    if (best_chi2_hypothesis.valid)
-    {
-        result.mttbar = best_chi2_hypothesis.ltop + best_chi2_hypothesis.htop;
-        result.wlep = best_chi2_hypothesis.neutrino + best_chi2_hypothesis.lepton;
-        result.neutrino = best_chi2_hypothesis.neutrino;
-        result.ltop = best_chi2_hypothesis.ltop;
-        result.ltop_jet = best_chi2_hypothesis.ltop_jet;
-        result.htop = best_chi2_hypothesis.htop;
-        result.htop_njets = best_chi2_hypothesis.htop_jets.size();
+    return true;
+}
 
-        result.ltop_discriminator = best_chi2_hypothesis.ltop_chi2;
-        result.htop_discriminator = best_chi2_hypothesis.htop_chi2;
+uint32_t JetTruncation::id() const
+{
+    return core::ID<JetTruncation>::get();
+}
 
-        result.htop_jets.clear();
-        for(Chi2Hypothesis::Iterators::const_iterator jet =
-                    best_chi2_hypothesis.htop_jets.begin();
-                best_chi2_hypothesis.htop_jets.end() != jet;
-                ++jet)
-        {
-            result.htop_jets.push_back(* *jet);
-        }
+JetTruncation::ObjectPtr JetTruncation::clone() const
+{
+    return ObjectPtr(new JetTruncation(*this));
+}
 
-        result.ltop_jets.clear();
-        for(Chi2Hypothesis::Iterators::const_iterator jet =
-                    best_chi2_hypothesis.ltop_jets.begin();
-                best_chi2_hypothesis.ltop_jets.end() != jet;
-                ++jet)
-        {
-            result.ltop_jets.push_back(* *jet);
-        }
+void JetTruncation::print(std::ostream &out) const
+{
+    out << "Jet Truncation: ";
+    if (_max_jets)
+    {
+        out << _max_jets << " leading jets";
+        if (_keep_btags)
+            out << " and all b-tagged jets";
+    }
+    else
+        out << "keep all jets";
 
-        sort(result.htop_jets.begin(), result.htop_jets.end(), CorrectedPtGreater()); 
-        sort(result.ltop_jets.begin(), result.ltop_jets.end(), CorrectedPtGreater()); 
+    out << endl;
+}
 
-        result.valid = true;
+// Private
+//
+bool JetTruncation::isBtagJet(const CorrectedJet &jet) const
+{
+    typedef ::google::protobuf::RepeatedPtrField<Jet::BTag> BTags;
+
+    for(BTags::const_iterator btag = jet.jet->btag().begin();
+            jet.jet->btag().end() != btag;
+            ++btag)
+    {
+        if (Jet::BTag::CSV == btag->type())
+            return Btag::discriminator() < btag->discriminator();
     }
 
-    return result;
+    return false;
 }
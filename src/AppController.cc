@@ -9,6 +9,8 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <set>
+#include <sstream>
 
 #include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
@@ -20,6 +22,7 @@
 #include "bsm_input/interface/Event.pb.h"
 #include "interface/Analyzer.h"
 #include "interface/AppController.h"
+#include "interface/Checkpoint.h"
 #include "interface/Thread.h"
 #include "interface/Utility.h"
 
@@ -27,6 +30,8 @@ using namespace std;
 using namespace boost;
 
 using bsm::AppController;
+using bsm::Checkpoint;
+using bsm::CheckpointDelegate;
 
 namespace fs = boost::filesystem;
 
@@ -36,6 +41,11 @@ AppController::AppController():
     _run_mode(SINGLE_THREAD),
     _disable_multithread(false),
     _number_of_threads(0),
+    _readers(0),
+    _queue_depth(1000),
+    _stats_period(10),
+    _checkpoint_files(10),
+    _resume(false),
     _interactive(false)
 {
     // Generic Options: common to all executables
@@ -50,6 +60,56 @@ AppController::AppController():
              boost::bind(&AppController::setNumberOfThreads, this, _1)),
          "Run Analysis with multi-threads: 0 - auto, otherwise max number of threads")
 
+        ("read-ahead",
+         po::value<uint32_t>()->implicit_value(1)->notifier(
+             boost::bind(&AppController::setReaders, this, _1)),
+         "Decode events in separate reader threads (multi-thread mode): number of readers")
+
+        ("queue-depth",
+         po::value<uint32_t>()->notifier(
+             boost::bind(&AppController::setQueueDepth, this, _1)),
+         "Maximum number of decoded events waiting for analyzer threads")
+
+        ("stats",
+         po::value<string>()->implicit_value("stats.json")->notifier(
+             boost::bind(&AppController::setStatsFile, this, _1)),
+         "Periodically write job throughput in file (multi-thread mode)")
+
+        ("stats-period",
+         po::value<uint32_t>()->notifier(
+             boost::bind(&AppController::setStatsPeriod, this, _1)),
+         "Stats are written every given number of seconds")
+
+        ("checkpoint",
+         po::value<string>()->implicit_value("checkpoint.bsm")->notifier(
+             boost::bind(&AppController::setCheckpointFile, this, _1)),
+         "Periodically save analyzer state and processed files in checkpoint")
+
+        ("checkpoint-files",
+         po::value<uint32_t>()->notifier(
+             boost::bind(&AppController::setCheckpointFiles, this, _1)),
+         "Checkpoint is saved every given number of processed input files")
+
+        ("resume",
+         po::value<bool>()->implicit_value(true)->notifier(
+             boost::bind(&AppController::setResume, this, _1)),
+         "Skip files processed in the checkpoint and merge saved state")
+
+        ("shard",
+         po::value<string>()->notifier(
+             boost::bind(&AppController::setShard, this, _1)),
+         "Process part i/N of the inputs, i = 0 .. N-1")
+
+        ("shard-events",
+         po::value<bool>()->implicit_value(true)->notifier(
+             boost::bind(&AppController::setShardEvents, this, _1)),
+         "Split every input file into N event ranges instead of files")
+
+        ("partial",
+         po::value<string>()->notifier(
+             boost::bind(&AppController::setPartialFile, this, _1)),
+         "Save partial result of the shard in file (merged with bsm_merge)")
+
         ("debug",
          po::value<string>()->implicit_value("debug.log")->notifier(
              boost::bind(&AppController::setDebugFile, this, _1)),
@@ -219,6 +279,25 @@ bool AppController::run(int &argc, char *argv[])
     }
     else
     {
+        if (_shard.isSharded())
+        {
+            const Inputs::size_type inputs = _input_files.size();
+            _input_files = _shard.select(_input_files);
+
+            clog << "shard " << _shard.name() << ": ";
+            if (_shard.isSplitEvents())
+                clog << "events of " << inputs << " input files";
+            else
+                clog << _input_files.size() << " of " << inputs
+                    << " input files";
+            clog << endl;
+
+            // Empty partial result is still saved for the merge
+            //
+            if (_input_files.empty())
+                cerr << "shard has no input files" << endl;
+        }
+
         clog << _input_files.size() << " input files" << endl;
         for(Inputs::const_iterator input = _input_files.begin();
                 _input_files.end() != input;
@@ -228,13 +307,18 @@ bool AppController::run(int &argc, char *argv[])
         }
         clog << endl;
 
-        if (SINGLE_THREAD == _run_mode
-                || (MULTI_THREAD == _run_mode
-                    && (1 == _number_of_threads
-                        || 1 == _input_files.size())))
-            processSingleThread();
-        else
-            processMultiThread();
+        if (_checkpoint_file.empty())
+        {
+            if (_resume)
+                cerr << "checkpoint is not set: nothing to resume" << endl;
+
+            process(_input_files);
+        }
+        else if (!processWithCheckpoints())
+            return false;
+
+        if (_shard.isSharded())
+            savePartial();
 
         cout << *_analyzer << endl;
 
@@ -282,6 +366,16 @@ void AppController::fileDidClose(const Reader *reader)
         _reader_delegate->fileDidClose(reader);
 }
 
+void AppController::onSnapshot(const AnalyzerPtr &analyzer,
+        const Inputs &processed)
+{
+    Inputs inputs(_checkpoint_inputs);
+    inputs.insert(inputs.end(), processed.begin(), processed.end());
+
+    _checkpoint->save(inputs,
+            *dynamic_pointer_cast<CheckpointDelegate>(analyzer));
+}
+
 // Privates
 //
 void AppController::setDebugFile(const string &filename)
@@ -300,6 +394,40 @@ void AppController::setNumberOfThreads(const uint32_t &number_of_threads)
     _run_mode = MULTI_THREAD;
 }
 
+void AppController::setReaders(const uint32_t &readers)
+{
+    _readers = readers;
+}
+
+void AppController::setQueueDepth(const uint32_t &depth)
+{
+    if (!depth)
+    {
+        cerr << "queue depth should be positive" << endl;
+
+        return;
+    }
+
+    _queue_depth = depth;
+}
+
+void AppController::setStatsFile(const string &filename)
+{
+    _stats_file = filename;
+}
+
+void AppController::setStatsPeriod(const uint32_t &period)
+{
+    if (!period)
+    {
+        cerr << "stats period should be positive" << endl;
+
+        return;
+    }
+
+    _stats_period = period;
+}
+
 void AppController::setInteractive(const bool &value)
 {
     _interactive = value;
@@ -310,52 +438,313 @@ void AppController::setOutput(const string &filename)
     _output_filename = filename;
 }
 
-void AppController::processSingleThread()
+void AppController::setCheckpointFile(const string &filename)
 {
-    shared_ptr<Summary> _summary(new Summary(_input_files.size()));
+    _checkpoint_file = filename;
+}
 
-    for(Inputs::const_iterator input = _input_files.begin();
-            _input_files.end() != input;
+void AppController::setCheckpointFiles(const uint32_t &files)
+{
+    if (!files)
+    {
+        cerr << "number of files between checkpoints should be positive"
+            << endl;
+
+        return;
+    }
+
+    _checkpoint_files = files;
+}
+
+void AppController::setResume(const bool &value)
+{
+    _resume = value;
+}
+
+void AppController::setShard(const string &shard)
+{
+    if (!_shard.parse(shard))
+        cerr << "failed to parse shard (expected i/N): " << shard << endl;
+}
+
+void AppController::setShardEvents(const bool &value)
+{
+    _shard.setSplitEvents(value);
+}
+
+void AppController::setPartialFile(const string &filename)
+{
+    _partial_file = filename;
+}
+
+void AppController::process(const Inputs &inputs)
+{
+    // Shard processes only its range of events in every file
+    //
+    Ranges ranges;
+    for(Inputs::const_iterator input = inputs.begin();
+            inputs.end() != input;
             ++input)
+    {
+        const EventRange range = _shard.range(*input);
+        if (range.isBounded()
+                && !range.size())
+            continue;
+
+        ranges.push_back(range);
+    }
+
+    // Single input file is split into event ranges in multi-thread
+    // mode
+    //
+    if (SINGLE_THREAD == _run_mode
+            || (MULTI_THREAD == _run_mode
+                && 1 == _number_of_threads))
+        processSingleThread(ranges);
+    else
+        processMultiThread(ranges);
+}
+
+bool AppController::processWithCheckpoints()
+{
+    // Reader delegates keep output per input file and can not be cloned
+    // for every range of events
+    //
+    if (isAnalyzerReaderDelegate()
+            || !dynamic_pointer_cast<CheckpointDelegate>(_analyzer))
+    {
+        cerr << "analyzer does not support checkpoints" << endl;
+
+        // Inputs can not be skipped without the saved state
+        //
+        if (_resume)
+            return false;
+
+        process(_input_files);
+
+        return true;
+    }
+
+    _checkpoint.reset(new Checkpoint(_checkpoint_file));
+    _checkpoint_inputs.clear();
+    _checkpoint_state.reset();
+
+    // Saved state is loaded into the clone of analyzer that did not
+    // process any events yet
+    //
+    Inputs inputs;
+    if (_resume
+            && _checkpoint->exists())
+    {
+        AnalyzerPtr saved = dynamic_pointer_cast<Analyzer>(_analyzer->clone());
+        if (!_checkpoint->load(_checkpoint_inputs,
+                    *dynamic_pointer_cast<CheckpointDelegate>(saved)))
+        {
+            cerr << "failed to resume: checkpoint can not be loaded" << endl;
+
+            _checkpoint.reset();
+            _checkpoint_inputs.clear();
+
+            return false;
+        }
+
+        _checkpoint_state = saved;
+
+        const set<string> skip(_checkpoint_inputs.begin(),
+                _checkpoint_inputs.end());
+        for(Inputs::const_iterator input = _input_files.begin();
+                _input_files.end() != input;
+                ++input)
+        {
+            if (!skip.count(*input))
+                inputs.push_back(*input);
+        }
+
+        clog << "resume: " << (_input_files.size() - inputs.size())
+            << " processed input files are skipped" << endl;
+    }
+    else
+    {
+        if (_resume)
+            clog << "resume: checkpoint does not exist, start from scratch"
+                << endl;
+
+        inputs = _input_files;
+    }
+
+    process(inputs);
+
+    _checkpoint.reset();
+    _checkpoint_inputs.clear();
+    _checkpoint_state.reset();
+
+    return true;
+}
+
+void AppController::savePartial()
+{
+    shared_ptr<CheckpointDelegate> delegate =
+        dynamic_pointer_cast<CheckpointDelegate>(_analyzer);
+    if (!delegate)
+    {
+        cerr << "analyzer does not support partial results" << endl;
+
+        return;
+    }
+
+    // Every shard gets its own file by default
+    //
+    string filename = _partial_file;
+    if (filename.empty())
+    {
+        ostringstream name;
+        name << "partial_" << _shard.index() << "_of_" << _shard.shards()
+            << ".bsm";
+
+        filename = name.str();
+    }
+
+    if (Checkpoint(filename).save(_input_files, *delegate))
+        clog << "partial result of shard " << _shard.name()
+            << " is saved in: " << filename << endl;
+}
+
+void AppController::saveSnapshot(const Inputs &processed)
+{
+    // Merge may change the analyzer, e.g. counter delegates are reset:
+    // state of the resumed checkpoint is added to the copy
+    //
+    AnalyzerPtr analyzer = _analyzer;
+    if (_checkpoint_state)
+    {
+        analyzer = dynamic_pointer_cast<Analyzer>(_analyzer->clone());
+        analyzer->merge(_checkpoint_state);
+    }
+
+    onSnapshot(analyzer, processed);
+}
+
+void AppController::processSingleThread(const Ranges &ranges)
+{
+    shared_ptr<Summary> _summary(new Summary(ranges.size()));
+
+    // Event is reused between files
+    //
+    EventPool events;
+
+    if (!_stats_file.empty())
+        cerr << "stats are only written in multi-thread mode" << endl;
+
+    Inputs processed;
+
+    for(Ranges::const_iterator range = ranges.begin();
+            ranges.end() != range;
+            ++range)
     {
         _summary->addFilesProcessed();
 
-        boost::shared_ptr<Reader> reader(new Reader(*input));
+        boost::shared_ptr<Reader> reader(new Reader(range->file_name));
         reader->setDelegate(this);
         reader->open();
 
         if (!reader->isOpen())
             continue;
 
+        // Events in front of the range are read but not analyzed
+        //
         uint32_t events_processed = 0;
-        for(boost::shared_ptr<Event> event(new Event());
-                reader->read(event);
-                event->Clear(), ++events_processed)
+        uint32_t event_index = 0;
+        boost::shared_ptr<Event> event = events.get();
+        for(;
+                range->last > event_index
+                    && reader->read(event);
+                event->Clear(), ++event_index)
         {
+            if (range->first > event_index)
+                continue;
+
             _analyzer->process(event.get());
+
+            ++events_processed;
+        }
+
+        events.release(event);
+
+        // Size of events is estimated with the input file size, the same
+        // way as in multi-thread mode
+        //
+        uint64_t events_size = range->bytes;
+        if (!events_size)
+        {
+            boost::system::error_code error;
+            const boost::uintmax_t bytes = fs::file_size(range->file_name,
+                    error);
+
+            events_size = error ? 0 : bytes;
         }
 
         _summary->addEventsProcessed(events_processed);
-        _summary->addEventsSize(0);
+        _summary->addEventsSize(events_size);
+
+        // Files that failed to open are tried again on resume
+        //
+        if (_checkpoint)
+        {
+            processed.push_back(range->file_name);
+            if (!(processed.size() % _checkpoint_files))
+                saveSnapshot(processed);
+        }
+    }
+
+    if (_checkpoint)
+    {
+        if (processed.size() % _checkpoint_files)
+            saveSnapshot(processed);
+
+        if (_checkpoint_state)
+            _analyzer->merge(_checkpoint_state);
     }
 
+    _summary->addEventsAllocated(events.allocated());
+
     cout << *_summary << endl;
 
     _summary.reset();
 }
 
-void AppController::processMultiThread()
+void AppController::processMultiThread(const Ranges &ranges)
 {
+    // Controller does not start without inputs: state of the resumed
+    // checkpoint is merged here
+    //
+    if (ranges.empty())
+    {
+        if (_checkpoint
+                && _checkpoint_state)
+            _analyzer->merge(_checkpoint_state);
+
+        return;
+    }
+
     boost::shared_ptr<ThreadController>
         controller(new ThreadController(_number_of_threads));
 
-    for(Inputs::const_iterator input = _input_files.begin();
-            _input_files.end() != input;
-            ++input)
+    for(Ranges::const_iterator range = ranges.begin();
+            ranges.end() != range;
+            ++range)
     {
-        controller->push(*input);
+        controller->push(*range);
     }
 
+    if (_readers)
+        controller->usePipeline(_readers, _queue_depth);
+
+    if (!_stats_file.empty())
+        controller->useStats(_stats_file, _stats_period);
+
+    if (_checkpoint)
+        controller->useSnapshots(this, _checkpoint_files, _checkpoint_state);
+
     controller->use(_analyzer, isAnalyzerReaderDelegate());
     controller->start();
 }
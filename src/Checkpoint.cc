@@ -0,0 +1,145 @@
+// Checkpoint
+//
+// Save state of the analyzer together with the list of processed input
+// files. Interrupted job can be resumed from the checkpoint: processed
+// files are skipped and saved state is merged into the analyzer.
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+#include <boost/filesystem.hpp>
+
+#include "interface/Checkpoint.h"
+
+using namespace std;
+
+using bsm::Checkpoint;
+
+namespace fs = boost::filesystem;
+
+// Format version is increased every time the layout of the file changes
+//
+static const string header = "bsm_checkpoint 1";
+
+void bsm::saveString(std::ostream &out, const std::string &value)
+{
+    out << value.size() << " ";
+    out.write(value.data(), value.size());
+}
+
+bool bsm::loadString(std::istream &in, std::string &value)
+{
+    string::size_type size = 0;
+    if (!(in >> size)
+            || ' ' != in.get())
+        return false;
+
+    value.resize(size);
+    if (size)
+        in.read(&value[0], size);
+
+    return !in.fail();
+}
+
+Checkpoint::Checkpoint(const std::string &file_name):
+    _file_name(file_name)
+{
+}
+
+bool Checkpoint::exists() const
+{
+    return fs::exists(_file_name);
+}
+
+bool Checkpoint::save(const Inputs &processed,
+        const CheckpointDelegate &analyzer) const
+{
+    const string tmp_file = _file_name + ".tmp";
+    {
+        ofstream out(tmp_file.c_str(), ios::binary);
+        if (!out)
+        {
+            cerr << "failed to write checkpoint: " << tmp_file << endl;
+
+            return false;
+        }
+
+        out << header << endl;
+        out << processed.size() << endl;
+        for(Inputs::const_iterator input = processed.begin();
+                processed.end() != input;
+                ++input)
+        {
+            out << *input << endl;
+        }
+
+        analyzer.save(out);
+
+        if (!out)
+        {
+            cerr << "failed to write checkpoint: " << tmp_file << endl;
+
+            return false;
+        }
+    }
+
+    boost::system::error_code error;
+    fs::rename(tmp_file, _file_name, error);
+    if (error)
+    {
+        cerr << "failed to write checkpoint: " << _file_name << endl;
+
+        return false;
+    }
+
+    return true;
+}
+
+bool Checkpoint::load(Inputs &processed, CheckpointDelegate &analyzer) const
+{
+    ifstream in(_file_name.c_str(), ios::binary);
+    if (!in)
+    {
+        cerr << "failed to read checkpoint: " << _file_name << endl;
+
+        return false;
+    }
+
+    string line;
+    if (!getline(in, line)
+            || header != line)
+    {
+        cerr << "unsupported checkpoint format: " << _file_name << endl;
+
+        return false;
+    }
+
+    Inputs::size_type inputs = 0;
+    if (!(in >> inputs))
+    {
+        cerr << "failed to read checkpoint inputs: " << _file_name << endl;
+
+        return false;
+    }
+    in.ignore(numeric_limits<streamsize>::max(), '\n');
+
+    Inputs files;
+    for(; inputs && getline(in, line); --inputs)
+        files.push_back(line);
+
+    if (inputs
+            || !analyzer.load(in))
+    {
+        cerr << "failed to read checkpoint: " << _file_name << endl;
+
+        return false;
+    }
+
+    processed.insert(processed.end(), files.begin(), files.end());
+
+    return true;
+}
@@ -3,8 +3,12 @@
 // Created by Samvel Khalatyan, Jun 02, 2011
 // Copyright 2011, All rights reserved
 
+#include <time.h>
+
+#include <ctime>
 #include <functional>
 
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/pointer_cast.hpp>
 
 #include "interface/Cut.h"
@@ -17,8 +21,37 @@ using boost::dynamic_pointer_cast;
 using bsm::Counter;
 using bsm::CounterPtr;
 using bsm::Cut;
+using bsm::CutflowTimer;
 using bsm::LockCounterOnUpdate;
 
+// Wall time in seconds
+//
+static double currentWallTime()
+{
+    using boost::posix_time::microsec_clock;
+    using boost::posix_time::ptime;
+
+    static const ptime epoch = microsec_clock::universal_time();
+
+    return (microsec_clock::universal_time() - epoch).total_microseconds()
+        / 1e6;
+}
+
+// Thread CPU time in seconds. Process CPU time is used if thread clock is
+// not available
+//
+static double currentCpuTime()
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+
+    return time.tv_sec + time.tv_nsec / 1e9;
+#else
+    return static_cast<double>(clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
 // Counter
 //
 Counter::Counter():
@@ -300,3 +333,168 @@ LockCounterOnUpdate::~LockCounterOnUpdate()
 {
     _counter->unlock();
 }
+
+
+
+// Cutflow Timer
+//
+CutflowTimer::Scope::Scope(CutflowTimer &timer, const uint32_t &stage):
+    _timer(timer.isEnabled() ? &timer : 0),
+    _stage(stage),
+    _wall_time(0),
+    _cpu_time(0)
+{
+    if (!_timer)
+        return;
+
+    _wall_time = currentWallTime();
+    _cpu_time = currentCpuTime();
+}
+
+CutflowTimer::Scope::~Scope()
+{
+    if (!_timer)
+        return;
+
+    _timer->add(_stage,
+            currentWallTime() - _wall_time,
+            currentCpuTime() - _cpu_time);
+}
+
+CutflowTimer::Stage::Stage():
+    calls(0),
+    wall_time(0),
+    cpu_time(0)
+{
+}
+
+CutflowTimer::CutflowTimer(const uint32_t &stages):
+    _stages(stages),
+    _is_enabled(false)
+{
+}
+
+void CutflowTimer::enable()
+{
+    _is_enabled = true;
+}
+
+void CutflowTimer::disable()
+{
+    _is_enabled = false;
+}
+
+bool CutflowTimer::isEnabled() const
+{
+    return _is_enabled;
+}
+
+uint32_t CutflowTimer::stages() const
+{
+    return _stages.size();
+}
+
+void CutflowTimer::setName(const uint32_t &stage, const std::string &name)
+{
+    _stages.at(stage).name = name;
+}
+
+std::string CutflowTimer::name(const uint32_t &stage) const
+{
+    return _stages.at(stage).name;
+}
+
+uint64_t CutflowTimer::calls(const uint32_t &stage) const
+{
+    return _stages.at(stage).calls;
+}
+
+double CutflowTimer::wallTime(const uint32_t &stage) const
+{
+    return _stages.at(stage).wall_time;
+}
+
+double CutflowTimer::cpuTime(const uint32_t &stage) const
+{
+    return _stages.at(stage).cpu_time;
+}
+
+void CutflowTimer::add(const uint32_t &stage,
+        const double &wall_time,
+        const double &cpu_time)
+{
+    if (_stages.size() <= stage)
+        return;
+
+    Stage &timer = _stages[stage];
+
+    ++timer.calls;
+    timer.wall_time += wall_time;
+    timer.cpu_time += cpu_time;
+}
+
+uint32_t CutflowTimer::id() const
+{
+    return core::ID<CutflowTimer>::get();
+}
+
+CutflowTimer::ObjectPtr CutflowTimer::clone() const
+{
+    return ObjectPtr(new CutflowTimer(*this));
+}
+
+void CutflowTimer::merge(const ObjectPtr &pointer)
+{
+    if (id() != pointer->id())
+        return;
+
+    boost::shared_ptr<CutflowTimer> object =
+        boost::dynamic_pointer_cast<CutflowTimer>(pointer);
+
+    if (!object
+            || stages() != object->stages())
+        return;
+
+    for(uint32_t stage = 0; stages() > stage; ++stage)
+    {
+        _stages[stage].calls += object->_stages[stage].calls;
+        _stages[stage].wall_time += object->_stages[stage].wall_time;
+        _stages[stage].cpu_time += object->_stages[stage].cpu_time;
+    }
+
+    _is_enabled = _is_enabled || object->isEnabled();
+}
+
+void CutflowTimer::print(ostream &out) const
+{
+    const ios_base::fmtflags flags = out.flags();
+    const streamsize precision = out.precision();
+
+    out << setw(25) << left << "     STAGE" << right
+        << " " << setw(12) << "Calls"
+        << " " << setw(10) << "Wall, s"
+        << " " << setw(10) << "CPU, s"
+        << " " << setw(10) << "CPU, us" << endl;
+    out << setw(72) << setfill('-') << left << " " << setfill(' ') << endl;
+
+    // Skip stages that were never called
+    //
+    for(uint32_t stage = 0; stages() > stage; ++stage)
+    {
+        const Stage &timer = _stages[stage];
+        if (!timer.calls)
+            continue;
+
+        out << " " << setw(2) << right << stage << " "
+            << setw(21) << left << timer.name << right
+            << " " << setw(12) << timer.calls
+            << " " << setw(10) << fixed << setprecision(3)
+                << timer.wall_time
+            << " " << setw(10) << timer.cpu_time
+            << " " << setw(10) << setprecision(1)
+                << timer.cpu_time / timer.calls * 1e6 << endl;
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
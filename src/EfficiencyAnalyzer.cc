@@ -52,8 +52,9 @@ bsm::SynchSelectorDelegate *EfficiencyAnalyzer::getSynchSelectorDelegate() const
     return _synch_selector.get();
 }
 
-void EfficiencyAnalyzer::onFileOpen(const std::string &filename, const Input *)
+void EfficiencyAnalyzer::onFileOpen(const std::string &filename, const Input *input)
 {
+    _synch_selector->setTriggerMenu(input);
 }
 
 void EfficiencyAnalyzer::process(const Event *event)
@@ -0,0 +1,156 @@
+// Pool of events
+//
+// Events are reused between files, threads and the events queue. Cleared
+// protobuf messages keep memory allocated by nested messages (jets,
+// particles, triggers) and therefore reused events do not churn allocator.
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include <boost/atomic.hpp>
+
+#include "bsm_input/interface/Event.pb.h"
+#include "interface/EventPool.h"
+
+using namespace std;
+
+using bsm::EventPool;
+
+using bsm::core::Lock;
+
+#ifdef BSM_COUNT_ALLOCATIONS
+static boost::atomic<uint64_t> allocations(0);
+
+void *operator new(std::size_t size) throw(std::bad_alloc)
+{
+    allocations.fetch_add(1, boost::memory_order_relaxed);
+
+    void *pointer = malloc(size ? size : 1);
+    if (!pointer)
+        throw std::bad_alloc();
+
+    return pointer;
+}
+
+void operator delete(void *pointer) throw()
+{
+    free(pointer);
+}
+#endif
+
+EventPool::EventPool():
+    _allocated(0)
+{
+    _condition.reset(new core::Condition());
+}
+
+EventPool::EventPtr EventPool::get()
+{
+    {
+        Lock lock(_condition);
+
+        if (!_events.empty())
+        {
+            EventPtr event = _events.back();
+            _events.pop_back();
+
+            return event;
+        }
+
+        ++_allocated;
+    }
+
+    return EventPtr(new Event());
+}
+
+void EventPool::get(Events &events, const uint32_t &size)
+{
+    uint32_t missing = size;
+    {
+        Lock lock(_condition);
+
+        const uint32_t pooled = min<uint32_t>(size, _events.size());
+        events.insert(events.end(), _events.end() - pooled, _events.end());
+        _events.resize(_events.size() - pooled);
+
+        missing -= pooled;
+        _allocated += missing;
+    }
+
+    for(; missing; --missing)
+        events.push_back(EventPtr(new Event()));
+}
+
+void EventPool::release(const EventPtr &event)
+{
+    if (!event)
+        return;
+
+    event->Clear();
+
+    Lock lock(_condition);
+
+    _events.push_back(event);
+}
+
+void EventPool::release(const Events &events)
+{
+    for(Events::const_iterator event = events.begin();
+            events.end() != event;
+            ++event)
+    {
+        if (*event)
+            (*event)->Clear();
+    }
+
+    Lock lock(_condition);
+
+    _events.reserve(_events.size() + events.size());
+    for(Events::const_iterator event = events.begin();
+            events.end() != event;
+            ++event)
+    {
+        if (*event)
+            _events.push_back(*event);
+    }
+}
+
+uint32_t EventPool::size() const
+{
+    Lock lock(_condition);
+
+    return _events.size();
+}
+
+uint32_t EventPool::allocated() const
+{
+    Lock lock(_condition);
+
+    return _allocated;
+}
+
+
+
+// Allocations
+//
+bool bsm::allocation::isCounted()
+{
+#ifdef BSM_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t bsm::allocation::count()
+{
+#ifdef BSM_COUNT_ALLOCATIONS
+    return allocations.load(boost::memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
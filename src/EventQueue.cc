@@ -0,0 +1,184 @@
+// Bounded queue of decoded events
+//
+// Reader threads decode events and push them into the queue in chunks of
+// consecutive events from one file, analyzer threads pop chunks. Consumer
+// gets chunk of its current file first if there is any: analyzers see runs
+// of events from the same file even if several readers fill the queue.
+// Producers are blocked while the queue is full and consumers are blocked
+// while it is empty. Events are reused.
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <algorithm>
+
+#include "bsm_input/interface/Event.pb.h"
+#include "bsm_input/interface/Input.pb.h"
+#include "interface/EventQueue.h"
+
+using namespace std;
+
+using bsm::EventQueue;
+
+using bsm::core::Lock;
+
+// Input File
+//
+EventQueue::InputFile::InputFile(const std::string &file_name,
+        const InputPtr &input):
+    file_name(file_name),
+    input(input)
+{
+}
+
+// Item
+//
+EventQueue::Item::Item():
+    bytes(0)
+{
+}
+
+EventQueue::Item::Item(const InputFilePtr &file):
+    file(file),
+    bytes(0)
+{
+}
+
+// Event Queue
+//
+EventQueue::EventQueue(const uint32_t &depth):
+    _depth(depth ? depth : 1),
+    _size(0),
+    _producers(0),
+    _is_closed(false)
+{
+    _condition.reset(new core::Condition());
+
+    // Several chunks should fit into the queue to keep all consumers busy
+    //
+    _chunk_size = min(64u, max(1u, _depth / 4));
+}
+
+uint32_t EventQueue::depth() const
+{
+    return _depth;
+}
+
+uint32_t EventQueue::size() const
+{
+    Lock lock(_condition);
+
+    return _size;
+}
+
+uint32_t EventQueue::chunkSize() const
+{
+    return _chunk_size;
+}
+
+void EventQueue::addProducer()
+{
+    Lock lock(_condition);
+
+    ++_producers;
+}
+
+void EventQueue::removeProducer()
+{
+    Lock lock(_condition);
+
+    if (_producers)
+        --_producers;
+
+    // Consumers should be woken up if queue is drained
+    //
+    _condition->variable()->notify_all();
+}
+
+void EventQueue::events(Events &events, const uint32_t &size)
+{
+    _events.get(events, size);
+}
+
+void EventQueue::recycle(const Events &events)
+{
+    _events.release(events);
+}
+
+uint32_t EventQueue::eventsAllocated() const
+{
+    return _events.allocated();
+}
+
+bool EventQueue::push(const Item &item)
+{
+    Lock lock(_condition);
+
+    // Item larger than the queue is accepted only if queue is empty
+    //
+    while(_size
+            && _depth < _size + item.events.size()
+            && !_is_closed)
+    {
+        _condition->variable()->wait(lock());
+    }
+
+    if (_is_closed)
+        return false;
+
+    _items.push_back(item);
+    _size += item.events.size();
+
+    _condition->variable()->notify_all();
+
+    return true;
+}
+
+bool EventQueue::pop(Item &item, const InputFilePtr &file)
+{
+    Lock lock(_condition);
+
+    while(_items.empty()
+            && _producers
+            && !_is_closed)
+    {
+        _condition->variable()->wait(lock());
+    }
+
+    if (_is_closed
+            || _items.empty())
+        return false;
+
+    Items::iterator next = _items.begin();
+    if (file)
+    {
+        for(Items::iterator queued = _items.begin();
+                _items.end() != queued;
+                ++queued)
+        {
+            if (file == queued->file)
+            {
+                next = queued;
+
+                break;
+            }
+        }
+    }
+
+    item = *next;
+    _items.erase(next);
+    _size -= item.events.size();
+
+    _condition->variable()->notify_all();
+
+    return true;
+}
+
+void EventQueue::close()
+{
+    Lock lock(_condition);
+
+    _is_closed = true;
+
+    _condition->variable()->notify_all();
+}
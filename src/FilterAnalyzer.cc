@@ -136,6 +136,8 @@ bsm::SynchSelectorDelegate *FilterAnalyzer::getSynchSelectorDelegate() const
 
 void FilterAnalyzer::onFileOpen(const string &filename, const Input *input)
 {
+    _synch_selector->setTriggerMenu(input);
+
     if (_writer)
     {
         _writer->close();
@@ -188,6 +188,7 @@ void GenMatchingAnalyzer::didCounterAdd(const Counter *counter)
 
 void GenMatchingAnalyzer::onFileOpen(const std::string &filename, const Input *input)
 {
+    _synch_selector->setTriggerMenu(input);
 }
 
 void GenMatchingAnalyzer::process(const Event *event)
@@ -235,13 +236,13 @@ void GenMatchingAnalyzer::process(const Event *event)
                     ++neutrino)
             {
                 float deltar = dr(
-                        **neutrino,
+                        *neutrino,
                         resonance.ltop.wboson.neutrino->physics_object().p4());
 
                 if (deltar < best_dr)
                 {
                     best_dr = deltar;
-                    nu_p4 = &**neutrino;
+                    nu_p4 = neutrino;
                 }
             }
 
@@ -569,6 +569,8 @@ void HadronicTopAnalyzer::setHtopNjets(const int &min, const int &max)
 
 void HadronicTopAnalyzer::onFileOpen(const std::string &filename, const Input *input)
 {
+    _synch_selector->setTriggerMenu(input);
+
     if (input->has_type())
     {
         _use_pileup = (Input::DATA != input->type());
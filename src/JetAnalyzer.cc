@@ -111,6 +111,7 @@ const JetAnalyzer::P4MonitorPtr JetAnalyzer::recoLeadingJetMonitor() const
 
 void JetAnalyzer::onFileOpen(const std::string &filename, const Input *input)
 {
+    _synch_selector->setTriggerMenu(input);
 }
 
 void JetAnalyzer::process(const Event *event)
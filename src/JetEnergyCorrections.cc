@@ -80,6 +80,20 @@ JetEnergyCorrectionOptions::JetEnergyCorrectionOptions()
              boost::bind(&JetEnergyCorrectionOptions::setChildCorrection,
                  this)),
          "Use jet constituents p4 to clean up the jet")
+
+        ("jec-max-correction",
+         po::value<float>()->notifier(
+             boost::bind(&JetEnergyCorrectionOptions::setMaxCorrection,
+                 this, _1)),
+         "Do not correct jets that can not pass pT cut with given "
+         "maximum correction")
+
+        ("jec-validate-prefilter",
+         po::value<bool>()->implicit_value(true)->notifier(
+             boost::bind(&JetEnergyCorrectionOptions::setValidatePrefilter,
+                 this, _1)),
+         "Correct jets skipped by the max correction prefilter and check "
+         "that selection does not change")
     ;
 }
 
@@ -170,15 +184,40 @@ void JetEnergyCorrectionOptions::setChildCorrection()
     delegate()->setChildCorrection();
 }
 
+void JetEnergyCorrectionOptions::setMaxCorrection(const float &value)
+{
+    if (!delegate())
+        return;
+
+    if (1 > value)
+    {
+        cerr << "maximum jet energy correction should be at least 1" << endl;
+
+        return;
+    }
+
+    delegate()->setMaxCorrection(value);
+}
+
+void JetEnergyCorrectionOptions::setValidatePrefilter(const bool &value)
+{
+    if (!delegate())
+        return;
+
+    delegate()->setValidatePrefilter(value);
+}
+
 
 
 // Jet Energy Corrections
 //
-JetEnergyCorrections::JetEnergyCorrections()
+JetEnergyCorrections::JetEnergyCorrections():
+    _max_correction(0)
 {
 }
 
-JetEnergyCorrections::JetEnergyCorrections(const JetEnergyCorrections &object)
+JetEnergyCorrections::JetEnergyCorrections(const JetEnergyCorrections &object):
+    _max_correction(object._max_correction)
 {
     setCorrectionFiles(object.correctionFiles());
 
@@ -192,7 +231,8 @@ CorrectedJet JetEnergyCorrections::correctJet(
         const Event *event,
         const Electrons &electrons,
         const Muons &muons,
-        const LorentzVector *met)
+        const LorentzVector *met,
+        const float &min_pt)
 {
     CorrectedJet corrected_jet;
     corrected_jet.jet = jet;
@@ -225,6 +265,18 @@ CorrectedJet JetEnergyCorrections::correctJet(
             || !muons.empty())
         cleanJet(corrected_jet, electrons, muons);
 
+    // Soft jet keeps MET unchanged: there is no need to evaluate corrector
+    //
+    if (isSoft(*corrected_jet.corrected_p4, min_pt))
+    {
+        corrected_jet.corrected_p4.reset();
+
+        corrected_jet.corrected_met.reset(new LorentzVector());
+        corrected_jet.corrected_met->CopyFrom(*met);
+
+        return corrected_jet;
+    }
+
     corrected_jet.subtracted_p4.reset(new LorentzVector());
     corrected_jet.subtracted_p4->CopyFrom(*corrected_jet.corrected_p4);
 
@@ -239,6 +291,11 @@ const JetEnergyCorrections::CorrectionFiles
     return _correction_files;
 }
 
+float JetEnergyCorrections::maxCorrection() const
+{
+    return _max_correction;
+}
+
 void JetEnergyCorrections::setCorrectionFiles(const CorrectionFiles &files)
 {
     // Load any set Jet Energy correction files
@@ -291,6 +348,11 @@ void JetEnergyCorrections::setSystematic(const Systematic &systematic,
     }
 }
 
+void JetEnergyCorrections::setMaxCorrection(const float &value)
+{
+    _max_correction = value;
+}
+
 // Object interface
 //
 void JetEnergyCorrections::print(std::ostream &out) const
@@ -318,6 +380,15 @@ JetEnergyCorrections::CorrectorPtr JetEnergyCorrections::corrector()
     return _jec;
 }
 
+bool JetEnergyCorrections::isSoft(const LorentzVector &p4,
+        const float &min_pt) const
+{
+    return _max_correction
+        && min_pt
+        && !_systematic
+        && pt(p4) * _max_correction < min_pt;
+}
+
 void JetEnergyCorrections::correct(CorrectedJet &jet,
         const Event *event,
         const LorentzVector *met)
@@ -5,42 +5,41 @@
 
 #include <stdexcept>
 
-#include "bsm_stat/interface/Number.h"
-#include "bsm_stat/interface/Permutation.h"
+#include <boost/lexical_cast.hpp>
+
 #include "interface/JetPermutation.h"
 
 using namespace std;
 
+using boost::lexical_cast;
+
 using bsm::JetPermutation;
 
 JetPermutation::JetPermutation():
     _flip_combination(false)
 {
-    _prime_generator.reset(new stat::PrimeNumber());
     _jets = 0;
 }
 
 void JetPermutation::init(const Jets &jets)
 {
+    if (MAX_JETS < jets.size())
+        throw runtime_error("too many jets for permutations: " +
+                lexical_cast<string>(jets.size()));
+
     _jets = &jets;
 
     _flip_combination = false;
 
-    // Test if permutations exist
+    // Test if permutations exist: there is at least one permutation for
+    // two jets and more
     //
-    PermutationTables::const_iterator current_table =
-        _permutation_tables.find(jets.size());
-    if (_permutation_tables.end() == current_table)
-    {
-        // permutations do not exist: generate these
-        //
+    Permutations &permutations = _permutation_tables[jets.size()];
+    if (permutations.empty())
         generatePermutations(jets.size());
-    }
-    else
-    {
-        _current_permutation = current_table->second.begin();
-        _end_permutation = current_table->second.end();
-    }
+
+    _current_permutation = permutations.begin();
+    _end_permutation = permutations.end();
 }
 
 bool JetPermutation::next()
@@ -83,25 +82,14 @@ JetPermutation::Jets JetPermutation::hadronicJets()
 
 // Private
 //
-JetPermutation::Jets JetPermutation::jets(uint64_t product)
+JetPermutation::Jets JetPermutation::jets(uint32_t mask) const
 {
     Jets jets;
 
-    while(1 != product)
+    for(uint32_t index = 0; mask; ++index, mask >>= 1)
     {
-        for(PrimeIDs::const_iterator prime = _prime_id.begin();
-                _prime_id.end() != prime;
-                ++prime)
-        {
-            if (0 == product % prime->first)
-            {
-                product /= prime->first;
-
-                jets.push_back((*_jets)[prime->second]);
-
-                break;
-            }
-        }
+        if (mask & 1)
+            jets.push_back((*_jets)[index]);
     }
 
     return jets;
@@ -109,79 +97,34 @@ JetPermutation::Jets JetPermutation::jets(uint64_t product)
 
 void JetPermutation::generatePermutations(const uint32_t &size)
 {
-    expandPrimeIDs(size);
-
-    // Prepare vector of primes for permutator
-    //
-    typedef vector<uint32_t> Primes;
-    Primes primes;
-    {
-        uint32_t i = 0;
-        for(PrimeIDs::const_iterator prime = _prime_id.begin();
-                size > i;
-                ++prime, ++i)
-        {
-            primes.push_back(prime->first);
-        }
-    }
-
     Permutations &permutations = _permutation_tables[size];
 
-    // Generate all possible permutations
+    // Number of unique combinations: (3^N - 2^(N + 1) + 1) / 2
     //
-    typedef stat::Permutation<uint32_t> PermutationUInt;
-    typedef PermutationUInt::ObjectIterators ObjectIterators;
-
-    for(uint32_t sub_size = 2; size >= sub_size; ++sub_size)
+    uint64_t combinations = 1;
+    uint64_t subsets = 2;
+    for(uint32_t i = 0; size > i; ++i)
     {
-        PermutationUInt permutator(primes, sub_size);
-        do
-        {
-            // Get current permutation, move the saparator from left to right,
-            // calculate the product of left and right prime numbers, store
-            // in table if unique (combination is assumed to be the same if
-            // left and right products are swapped: this swap should be taken
-            // into account later when pair is used
-            //
-            const ObjectIterators &iterators = permutator.objectIterators();
-            for(uint32_t separation = 1; sub_size > separation; ++separation)
-            {
-                // Calculate products
-                //
-                Combination combo;
-                uint32_t i = 0;
-                for(ObjectIterators::const_iterator iter = iterators.begin();
-                        iterators.end() != iter;
-                        ++iter, ++i)
-                {
-                    if (separation > i)
-                        combo.left *= *(*iter);
-                    else
-                        combo.right *= *(*iter);
-                }
-
-                if (permutations.end() != find(permutations.begin(),
-                            permutations.end(),
-                            combo))
-                    continue;
-
-                permutations.push_back(combo);
-            }
-        }
-        while(permutator.next());
+        combinations *= 3;
+        subsets *= 2;
     }
 
-    _current_permutation = permutations.begin();
-    _end_permutation = permutations.end();
-}
+    permutations.reserve((combinations - subsets + 1) / 2);
 
-void JetPermutation::expandPrimeIDs(const uint32_t &size)
-{
-    // Expand list of primary numbers
+    // Loop over all sets of used jets and split each set into two. Left
+    // set always has the lowest jet of the used ones: combination is
+    // assumed to be the same if left and right sets are swapped, this
+    // swap should be taken into account later when pair is used
     //
-    for(uint32_t i = _prime_id.size(); size > i; ++i)
+    for(uint32_t used = 1; (1u << size) > used; ++used)
     {
-        _prime_id[*_prime_generator] = i;
-        _prime_generator->next();
+        const uint32_t lowest = used & (~used + 1);
+        const uint32_t rest = used ^ lowest;
+
+        // Loop over all non-empty subsets of the rest jets that go into
+        // the right set
+        //
+        for(uint32_t right = rest; right; right = (right - 1) & rest)
+            permutations.push_back(Combination(used ^ right, right));
     }
 }
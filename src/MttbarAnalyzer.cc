@@ -243,6 +243,7 @@ void MttbarAnalyzer::setUseGeneratorMass(const bool &flag)
 
 void MttbarAnalyzer::onFileOpen(const std::string &filename, const Input *input)
 {
+    _synch_selector->setTriggerMenu(input);
 }
 
 void MttbarAnalyzer::process(const Event *event)
@@ -322,7 +323,7 @@ void MttbarAnalyzer::process(const Event *event)
         //
         do
         {
-            Generator::Hypothesis hypothesis = generator.hypothesis();
+            const Generator::Hypothesis &hypothesis = generator.hypothesis();
 
             // Skip hypotheses that do not have any leptonic or hadronic jets
             //
@@ -377,7 +378,7 @@ void MttbarAnalyzer::process(const Event *event)
                     neutrinos.end() != neutrino;
                     ++neutrino)
             {
-                const LorentzVector &neutrino_p4 = *(*neutrino);
+                const LorentzVector &neutrino_p4 = *neutrino;
 
                 LorentzVector ltop_tmp = ltop;
                 ltop_tmp += neutrino_p4;
@@ -0,0 +1,196 @@
+// Partial Merger
+//
+// Reduce partial results of the shards into one analyzer. Partial results
+// are loaded in parallel threads: every thread merges its share of files
+// into the own clone of the analyzer. Clones are merged at the end.
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+
+#include <boost/pointer_cast.hpp>
+
+#include "interface/Analyzer.h"
+#include "interface/Checkpoint.h"
+#include "interface/PartialMerger.h"
+
+using namespace std;
+
+using boost::dynamic_pointer_cast;
+
+using bsm::PartialLoadOperation;
+using bsm::PartialMerger;
+
+using bsm::core::Thread;
+
+// Partial Load Operation
+//
+PartialLoadOperation::PartialLoadOperation(const AnalyzerPtr &prototype,
+        const Inputs &partials):
+    _prototype(prototype),
+    _partials(partials),
+    _failed(0),
+    _continue(true)
+{
+    _thread = 0;
+}
+
+PartialLoadOperation::AnalyzerPtr PartialLoadOperation::analyzer() const
+{
+    return _analyzer;
+}
+
+const PartialLoadOperation::Inputs &PartialLoadOperation::processed() const
+{
+    return _processed;
+}
+
+uint32_t PartialLoadOperation::failed() const
+{
+    return _failed;
+}
+
+void PartialLoadOperation::run()
+{
+    if (!_thread)
+        return;
+
+    _analyzer = dynamic_pointer_cast<Analyzer>(_prototype->clone());
+
+    for(Inputs::const_iterator partial = _partials.begin();
+            isContinue()
+                && _partials.end() != partial;
+            ++partial)
+    {
+        // Saved state can only be loaded into analyzer that did not
+        // process any events
+        //
+        AnalyzerPtr analyzer = dynamic_pointer_cast<Analyzer>(
+                _prototype->clone());
+
+        Checkpoint::Inputs processed;
+        if (!Checkpoint(*partial).load(processed,
+                    *dynamic_pointer_cast<CheckpointDelegate>(analyzer)))
+        {
+            ++_failed;
+
+            continue;
+        }
+
+        _analyzer->merge(analyzer);
+        _processed.insert(_processed.end(),
+                processed.begin(), processed.end());
+    }
+}
+
+void PartialLoadOperation::stop()
+{
+    _continue = false;
+}
+
+void PartialLoadOperation::onThreadInit(Thread *thread)
+{
+    _thread = thread;
+}
+
+// Privates
+//
+bool PartialLoadOperation::isContinue() const
+{
+    return _continue.load(boost::memory_order_relaxed);
+}
+
+
+
+// Partial Merger
+//
+PartialMerger::PartialMerger(const AnalyzerPtr &prototype,
+        const uint32_t &max_threads):
+    _prototype(prototype),
+    _max_threads(min(max_threads ? max_threads : INT_MAX,
+                boost::thread::hardware_concurrency()))
+{
+}
+
+bool PartialMerger::merge(const Inputs &partials)
+{
+    _analyzer.reset();
+    _processed.clear();
+
+    if (!_prototype
+            || !dynamic_pointer_cast<CheckpointDelegate>(_prototype))
+    {
+        cerr << "analyzer does not support partial results" << endl;
+
+        return false;
+    }
+
+    // Partial results are dealt to threads in turn
+    //
+    const uint32_t threads = max(1u, min(_max_threads,
+                static_cast<uint32_t>(partials.size())));
+
+    vector<Inputs> shares(threads);
+    for(Inputs::size_type partial = 0; partials.size() > partial; ++partial)
+        shares[partial % threads].push_back(partials[partial]);
+
+    typedef boost::shared_ptr<Thread> ThreadPtr;
+    typedef vector<ThreadPtr> Threads;
+
+    Threads loaders;
+    for(vector<Inputs>::const_iterator share = shares.begin();
+            shares.end() != share;
+            ++share)
+    {
+        ThreadPtr thread(new Thread());
+        thread->init(PartialLoadOperationPtr(
+                    new PartialLoadOperation(_prototype, *share)));
+        thread->start();
+
+        loaders.push_back(thread);
+    }
+
+    uint32_t failed = 0;
+    for(Threads::const_iterator thread = loaders.begin();
+            loaders.end() != thread;
+            ++thread)
+    {
+        (*thread)->join();
+
+        PartialLoadOperationPtr operation =
+            dynamic_pointer_cast<PartialLoadOperation>((*thread)->operation());
+
+        if (!operation
+                || !operation->analyzer())
+            continue;
+
+        failed += operation->failed();
+
+        if (_analyzer)
+            _analyzer->merge(operation->analyzer());
+        else
+            _analyzer = operation->analyzer();
+
+        _processed.insert(_processed.end(),
+                operation->processed().begin(),
+                operation->processed().end());
+    }
+
+    if (failed)
+        cerr << failed << " partial results failed to load" << endl;
+
+    return !failed;
+}
+
+PartialMerger::AnalyzerPtr PartialMerger::analyzer() const
+{
+    return _analyzer;
+}
+
+const PartialMerger::Inputs &PartialMerger::processed() const
+{
+    return _processed;
+}
@@ -216,7 +216,7 @@ void ResonanceDumpAnalyzer::process(const Event *event)
             _log << setw(width) << right << "met: "
                 << (*_format)(resonance.neutrino) << endl;
 
-            for(ResonanceReconstructor::LorentzVectors::const_iterator p4 =
+            for(NeutrinoReconstruct::Solutions::const_iterator p4 =
                         resonance.neutrinos.begin();
                     resonance.neutrinos.end() != p4;
                     ++p4)
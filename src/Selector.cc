@@ -178,8 +178,13 @@ CutPtr JetSelector::cut(const Cut &cut_id) const
 
 bool JetSelector::apply(const Jet &jet)
 {
-    return cut(PT)->apply(bsm::pt(jet.physics_object().p4()))
-        && cut(ETA)->apply(fabs(bsm::eta(jet.physics_object().p4())));
+    return apply(jet, jet.physics_object().p4());
+}
+
+bool JetSelector::apply(const Jet &, const LorentzVector &p4)
+{
+    return cut(PT)->apply(bsm::pt(p4))
+        && cut(ETA)->apply(fabs(bsm::eta(p4)));
 }
 
 uint32_t JetSelector::id() const
@@ -376,14 +381,19 @@ CutPtr WJetSelector::cut(const Cut &cut_id) const
 }
 
 bool WJetSelector::apply(const Jet &jet)
+{
+    return apply(jet, jet.physics_object().p4());
+}
+
+bool WJetSelector::apply(const Jet &jet, const LorentzVector &p4)
 {
     if (!cut(CHILDREN)->apply(jet.child().size()))
         return false;
 
-    if (!cut(PT)->apply(bsm::pt(jet.physics_object().p4())))
+    if (!cut(PT)->apply(bsm::pt(p4)))
         return false;
 
-    float m0 = bsm::mass(jet.physics_object().p4());
+    float m0 = bsm::mass(p4);
     float m1 = bsm::mass(jet.child().Get(0).physics_object().p4());
     float m2 = bsm::mass(jet.child().Get(1).physics_object().p4());
     float m12 = bsm::mass(jet.child().Get(0).physics_object().p4()
@@ -0,0 +1,146 @@
+// Shard
+//
+// Select part of the inputs to be processed by one of N jobs. Shards are
+// deterministic: the same inputs always give the same selection. Input
+// files are distributed between shards, or every file is split into N
+// event ranges if events are split.
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <algorithm>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/regex.hpp>
+
+#include "bsm_input/interface/Input.pb.h"
+#include "bsm_input/interface/Reader.h"
+#include "interface/Shard.h"
+
+using namespace std;
+
+using bsm::EventRange;
+using bsm::Shard;
+
+namespace fs = boost::filesystem;
+
+Shard::Shard():
+    _index(0),
+    _shards(1),
+    _split_events(false)
+{
+}
+
+bool Shard::parse(const string &shard)
+{
+    boost::smatch matches;
+    if (!boost::regex_match(shard, matches,
+                boost::regex("^(\\d+)/(\\d+)$")))
+        return false;
+
+    try
+    {
+        const uint32_t index = boost::lexical_cast<uint32_t>(matches[1]);
+        const uint32_t shards = boost::lexical_cast<uint32_t>(matches[2]);
+
+        if (index >= shards)
+            return false;
+
+        _index = index;
+        _shards = shards;
+    }
+    catch(const boost::bad_lexical_cast &)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+uint32_t Shard::index() const
+{
+    return _index;
+}
+
+uint32_t Shard::shards() const
+{
+    return _shards;
+}
+
+bool Shard::isSharded() const
+{
+    return 1 < _shards;
+}
+
+void Shard::setSplitEvents(const bool &value)
+{
+    _split_events = value;
+}
+
+bool Shard::isSplitEvents() const
+{
+    return _split_events;
+}
+
+Shard::Inputs Shard::select(const Inputs &inputs) const
+{
+    if (!isSharded())
+        return inputs;
+
+    Inputs files(inputs);
+    sort(files.begin(), files.end());
+
+    if (isSplitEvents())
+        return files;
+
+    // Files are dealt to shards in turn
+    //
+    Inputs selected;
+    for(Inputs::size_type file = _index; files.size() > file; file += _shards)
+        selected.push_back(files[file]);
+
+    return selected;
+}
+
+EventRange Shard::range(const string &file_name) const
+{
+    if (!isSharded()
+            || !isSplitEvents())
+        return EventRange(file_name);
+
+    uint64_t events = 0;
+    {
+        Reader reader(file_name);
+        reader.open();
+
+        if (reader.isOpen()
+                && reader.input()->has_events())
+            events = reader.input()->events();
+    }
+
+    if (!events)
+        return _index
+            ? EventRange(file_name, 0, 0)
+            : EventRange(file_name);
+
+    EventRange range(file_name,
+            events * _index / _shards,
+            events * (_index + 1) / _shards);
+
+    boost::system::error_code error;
+    const boost::uintmax_t bytes = fs::file_size(file_name, error);
+    if (!error)
+        range.bytes = bytes * range.size() / events;
+
+    return range;
+}
+
+string Shard::name() const
+{
+    ostringstream out;
+    out << _index << "/" << _shards;
+
+    return out.str();
+}
@@ -181,8 +181,9 @@ void SynchAnalyzer::setTrigger(const Trigger &trigger)
     _triggers.push_back(trigger.hash());
 }
 
-void SynchAnalyzer::onFileOpen(const std::string &filename, const Input *)
+void SynchAnalyzer::onFileOpen(const std::string &filename, const Input *input)
 {
+    _synch_selector->setTriggerMenu(input);
 }
 
 void SynchAnalyzer::process(const Event *event)
@@ -5,17 +5,21 @@
 // Copyright 2011, All rights reserved
 
 #include <functional>
+#include <stdexcept>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/pointer_cast.hpp>
 
 #include "bsm_input/interface/Algebra.h"
 #include "bsm_input/interface/Electron.pb.h"
 #include "bsm_input/interface/Event.pb.h"
+#include "bsm_input/interface/Input.pb.h"
 #include "bsm_input/interface/Isolation.pb.h"
 #include "bsm_input/interface/Muon.pb.h"
 #include "bsm_input/interface/PrimaryVertex.pb.h"
 #include "bsm_input/interface/Physics.pb.h"
+#include "bsm_input/interface/Trigger.pb.h"
 #include "interface/Btag.h"
 #include "interface/Cut.h"
 #include "interface/SynchSelector.h"
@@ -91,6 +95,11 @@ SynchSelectorOptions::SynchSelectorOptions()
      po::value<float>()->notifier(
          boost::bind(&SynchSelectorOptions::setChi2Discriminator, this, _1)),
      "set max chi2 disriminator")
+
+    ("cutflow-timing",
+     po::value<bool>()->implicit_value(true)->notifier(
+         boost::bind(&SynchSelectorOptions::setCutflowTiming, this, _1)),
+     "measure time and calls of every selection stage")
     ;
 }
 
@@ -232,6 +241,14 @@ void SynchSelectorOptions::setChi2Discriminator(const float &value)
     delegate()->setChi2Discriminator(value);
 }
 
+void SynchSelectorOptions::setCutflowTiming(const bool &value)
+{
+    if (!delegate())
+        return;
+
+    delegate()->setCutflowTiming(value);
+}
+
 
 
 // Synchronization Exercise Selector
@@ -241,7 +258,10 @@ SynchSelector::SynchSelector():
     _cut_mode(CUT_2D),
     _qcd_template(false),
     _wjets_template(false),
-    _weighted_toptag(false)
+    _validate_jec_prefilter(false),
+    _weighted_toptag(false),
+    _passed_selections(0),
+    _prefix_passed(false)
 {
     // Cutflow table
     //
@@ -337,6 +357,9 @@ SynchSelector::SynchSelector():
 
     _btag.reset(new Btag());
     monitor(_btag);
+
+    _timer.reset(new CutflowTimer(TIMING_STAGES));
+    monitor(_timer);
 }
 
 SynchSelector::SynchSelector(const SynchSelector &object):
@@ -344,8 +367,13 @@ SynchSelector::SynchSelector(const SynchSelector &object):
     _cut_mode(object._cut_mode),
     _qcd_template(object._qcd_template),
     _wjets_template(object._wjets_template),
+    _validate_jec_prefilter(object._validate_jec_prefilter),
     _triggers(object._triggers.begin(), object._triggers.end()),
-    _weighted_toptag(false)
+    _trigger_positions(object._trigger_positions.begin(),
+            object._trigger_positions.end()),
+    _weighted_toptag(false),
+    _passed_selections(0),
+    _prefix_passed(false)
 {
     // Cutflow Table
     //
@@ -427,6 +455,9 @@ SynchSelector::SynchSelector(const SynchSelector &object):
 
     _btag = dynamic_pointer_cast<Btag>(object._btag->clone());
     monitor(_btag);
+
+    _timer = dynamic_pointer_cast<CutflowTimer>(object._timer->clone());
+    monitor(_timer);
 }
 
 SynchSelector::~SynchSelector()
@@ -490,7 +521,7 @@ SynchSelector::CutPtr SynchSelector::chi2() const
 
 uint32_t SynchSelector::countBtaggedJets()
 {
-    if (!_btagged_jets.is_valid())
+    if (!_btagged_jets.is_valid(_event_generation))
     {
         uint32_t btags = 0;
         for(GoodJets::const_iterator jet = _good_jets.begin();
@@ -501,63 +532,82 @@ uint32_t SynchSelector::countBtaggedJets()
                 ++btags;
         }
 
-        _btagged_jets.set(btags);
+        _btagged_jets.set(_event_generation, btags);
     }
 
-    return _btagged_jets.get();
+    return _btagged_jets.get(_event_generation);
 }
 
 bool SynchSelector::apply(const Event *event)
 {
-    invalidate_cache();
+    {
+        CutflowTimer::Scope timer(*_timer, PRESELECTION);
+
+        _event_generation.next();
+
+        _passed_selections = 0;
+        passSelection(PRESELECTION);
+
+        _good_primary_vertices.clear();
+        _good_electrons.clear();
+        _good_muons.clear();
+        _nice_jets.clear();
+        _good_jets.clear();
+        _ca_jets.clear();
+        _top_jets.clear();
+        _good_met.reset();
+        _closest_jet = _nice_jets.end();
+    }
 
-    _cutflow->apply(PRESELECTION);
+    _prefix_passed = triggers(event)
+                     && primaryVertices(event)
+                     && jets(event)
+                     && lepton()
+                     && secondElectronVeto()
+                     && secondMuonVeto()
+                     && isolationAnd2DCut()
+                     && leadingJetCut()
+                     && maxBtags()
+                     && minBtags()
+                     && toptagCut();
 
-    _good_primary_vertices.clear();
-    _good_electrons.clear();
-    _good_muons.clear();
-    _nice_jets.clear();
-    _good_jets.clear();
-    _ca_jets.clear();
-    _top_jets.clear();
-    _good_met.reset();
-    _closest_jet = _nice_jets.end();
+    return _prefix_passed
+           && tail(event);
+}
 
-    // QCD template
-    if (qcdTemplate())
+bool SynchSelector::apply(const Event *event, const SynchSelector &prefix)
+{
     {
-        tricut()->invert();
-        return triggers(event)
-               && primaryVertices(event)
-               && jets(event)
-               && lepton()
-               && secondElectronVeto()
-               && secondMuonVeto()
-               && isolationAnd2DCut()
-               && leadingJetCut()
-               && maxBtags()
-               && minBtags()
-               && toptagCut()
-               && htlepCut(event)
-               && missingEnergy(event)
-               && triangularCut(event);
+        CutflowTimer::Scope timer(*_timer, PRESELECTION);
+
+        _event_generation.next();
+
+        // Take objects selected by the prefix and count the same shared
+        // selections in own cutflow
+        //
+        _good_primary_vertices = prefix._good_primary_vertices;
+        _good_electrons = prefix._good_electrons;
+        _good_muons = prefix._good_muons;
+        _nice_jets = prefix._nice_jets;
+        _good_jets = prefix._good_jets;
+        _ca_jets = prefix._ca_jets;
+        _top_jets = prefix._top_jets;
+        _good_met = prefix._good_met;
+        _closest_jet = _nice_jets.begin()
+            + (prefix._closest_jet - prefix._nice_jets.begin());
+
+        _passed_selections = 0;
+        for(uint32_t selection = PRESELECTION; HTLEP > selection; ++selection)
+        {
+            if ((prefix._passed_selections >> selection) & 1)
+                passSelection(static_cast<Selection>(selection));
+        }
+
+        _prefix_passed = prefix._prefix_passed;
     }
 
-    // Nominal
-    return triggers(event)
-           && primaryVertices(event)
-           && jets(event)
-           && lepton()
-           && secondElectronVeto()
-           && secondMuonVeto()
-           && isolationAnd2DCut()
-           && leadingJetCut()
-           && maxBtags()
-           && minBtags()
-           && toptagCut()
-           && htlepCut(event)
-           && triangularCut(event)
-           && missingEnergy(event);
+    return _prefix_passed
+           && tail(event);
 }
 
 SynchSelector::CutflowPtr SynchSelector::cutflow() const
@@ -565,6 +615,11 @@ SynchSelector::CutflowPtr SynchSelector::cutflow() const
     return _cutflow;
 }
 
+SynchSelector::CutflowTimerPtr SynchSelector::timer() const
+{
+    return _timer;
+}
+
 const SynchSelector::GoodPrimaryVertices
 &SynchSelector::goodPrimaryVertices() const
 {
@@ -696,6 +751,14 @@ void SynchSelector::setWjetsTemplate(const bool &value)
     _wjets_template = value;
 }
 
+void SynchSelector::setCutflowTiming(const bool &value)
+{
+    if (value)
+        _timer->enable();
+    else
+        _timer->disable();
+}
+
 void SynchSelector::setLtopPt(const float &value)
 {
     ltop()->setValue(value);
@@ -729,6 +792,7 @@ void SynchSelector::setChildCorrection()
     //
     shared_ptr<JetEnergyCorrections> jec(new ChildJetEnergyCorrections());
     jec->setCorrectionFiles(_jec->correctionFiles());
+    jec->setMaxCorrection(_jec->maxCorrection());
 
     // Activate new Jet Energy Corrections
     //
@@ -737,11 +801,45 @@ void SynchSelector::setChildCorrection()
     monitor(_jec);
 }
 
+void SynchSelector::setMaxCorrection(const float &value)
+{
+    _jec->setMaxCorrection(value);
+}
+
+void SynchSelector::setValidatePrefilter(const bool &value)
+{
+    _validate_jec_prefilter = value;
+}
+
 // Trigger Delegate interface
 //
 void SynchSelector::setTrigger(const Trigger &trigger)
 {
     _triggers.push_back(trigger.hash());
+    _trigger_positions.push_back(-1);
+}
+
+void SynchSelector::setTriggerMenu(const Input *input)
+{
+    _trigger_positions.assign(_triggers.size(), -1);
+
+    if (_triggers.empty()
+            || !input->has_info())
+        return;
+
+    typedef ::google::protobuf::RepeatedPtrField<TriggerItem> TriggerItems;
+
+    const TriggerItems &paths = input->info().trigger().path();
+    for(int position = 0; paths.size() > position; ++position)
+    {
+        const uint64_t hash = paths.Get(position).hash();
+        for(uint32_t index = 0; _triggers.size() > index; ++index)
+        {
+            if (hash == _triggers[index]
+                    && 0 > _trigger_positions[index])
+                _trigger_positions[index] = position;
+        }
+    }
 }
 
 // Selector interface
@@ -806,6 +904,17 @@ void SynchSelector::print(std::ostream &out) const
     out << "Cutflow [" << _lepton_mode << ": " << _cut_mode << "]" << endl;
     out << *_cutflow << endl;
     out << endl;
+
+    if (!_timer->isEnabled())
+        return;
+
+    for(uint32_t stage = 0; SELECTIONS > stage; ++stage)
+        _timer->setName(stage, _cutflow->cut(stage)->name());
+
+    _timer->setName(LEPTON_ID, "Lepton ID");
+
+    out << "Cutflow Timing" << endl;
+    out << *_timer << endl;
 }
 
 bool SynchSelector::reconstruction(const bool &value)
@@ -814,7 +923,7 @@ bool SynchSelector::reconstruction(const bool &value)
         return true;
 
     return reconstruction()->apply(value)
-           && (_cutflow->apply(RECONSTRUCTION), true);
+           && (passSelection(RECONSTRUCTION), true);
 }
 
 bool SynchSelector::ltop(const float &value)
@@ -822,8 +931,10 @@ bool SynchSelector::ltop(const float &value)
     if (ltop()->isDisabled())
         return true;
 
+    CutflowTimer::Scope timer(*_timer, LTOP);
+
     return ltop()->apply(value)
-           && (_cutflow->apply(LTOP), true);
+           && (passSelection(LTOP), true);
 }
 
 bool SynchSelector::chi2(const float &value)
@@ -831,14 +942,41 @@ bool SynchSelector::chi2(const float &value)
     if (chi2()->isDisabled())
         return true;
 
+    CutflowTimer::Scope timer(*_timer, CHI2);
+
     return chi2()->apply(value)
-        && (_cutflow->apply(CHI2), true);
+        && (passSelection(CHI2), true);
 }
 
 // Private
 //
+void SynchSelector::passSelection(const Selection &selection)
+{
+    _cutflow->apply(selection);
+    _passed_selections |= 1u << selection;
+}
+
+bool SynchSelector::tail(const Event *event)
+{
+    // QCD template
+    if (qcdTemplate())
+    {
+        tricut()->invert();
+        return htlepCut(event)
+               && missingEnergy(event)
+               && triangularCut(event);
+    }
+
+    // Nominal
+    return htlepCut(event)
+           && triangularCut(event)
+           && missingEnergy(event);
+}
+
 bool SynchSelector::triggers(const Event *event)
 {
+    CutflowTimer::Scope timer(*_timer, TRIGGER);
+
     bool result = _triggers.empty();
 
     if (!result
@@ -846,43 +984,71 @@ bool SynchSelector::triggers(const Event *event)
     {
         // OR triggers
         //
-        typedef ::google::protobuf::RepeatedPtrField<Trigger> PBTriggers;
-        for(Triggers::const_iterator trigger = _triggers.begin();
-                _triggers.end() != trigger
-                && !result;
-                ++trigger)
+        for(uint32_t index = 0; _triggers.size() > index && !result; ++index)
         {
-            for(PBTriggers::const_iterator hlt = event->hlt().trigger().begin();
-                    event->hlt().trigger().end() != hlt;
-                    ++hlt)
+            const Trigger *hlt = findTrigger(event, index);
+            if (hlt
+                    && hlt->pass())
+                result = true;
+        }
+    }
+
+    return result
+           && (passSelection(TRIGGER), true);
+}
+
+const Trigger *SynchSelector::findTrigger(const Event *event,
+        const uint32_t &index)
+{
+    typedef ::google::protobuf::RepeatedPtrField<Trigger> PBTriggers;
+
+    const PBTriggers &hlts = event->hlt().trigger();
+
+    // Search for trigger only if it is not found at the known position
+    //
+    int &position = _trigger_positions[index];
+    if (0 > position
+            || hlts.size() <= position
+            || hlts.Get(position).hash() != _triggers[index])
+    {
+        position = -1;
+        for(int hlt = 0; hlts.size() > hlt; ++hlt)
+        {
+            if (hlts.Get(hlt).hash() == _triggers[index])
             {
-                if (hlt->hash() == *trigger)
-                {
-                    if (hlt->pass())
-                        result = true;
+                position = hlt;
 
-                    break;
-                }
+                break;
             }
         }
     }
 
-    return result
-           && (_cutflow->apply(TRIGGER), true);
+    return 0 > position ? 0 : &hlts.Get(position);
 }
 
 bool SynchSelector::primaryVertices(const Event *event)
 {
+    CutflowTimer::Scope timer(*_timer, PRIMARY_VERTEX);
+
     selectGoodPrimaryVertices(event);
 
     return !goodPrimaryVertices().empty()
-           && (_cutflow->apply(PRIMARY_VERTEX), true);
+           && (passSelection(PRIMARY_VERTEX), true);
 }
 
 bool SynchSelector::jets(const Event *event)
 {
-    selectGoodElectrons(event);
-    selectGoodMuons(event);
+    // Leptons are needed to clean jets: time lepton ID separately from jet
+    // energy corrections
+    //
+    {
+        CutflowTimer::Scope timer(*_timer, LEPTON_ID);
+
+        selectGoodElectrons(event);
+        selectGoodMuons(event);
+    }
+
+    CutflowTimer::Scope timer(*_timer, JET);
 
     // Correct all jets
     //
@@ -891,6 +1057,7 @@ bool SynchSelector::jets(const Event *event)
     LockSelectorEventCounterOnUpdate lock_nice_jets(*_nice_jet_selector);
     LockSelectorEventCounterOnUpdate lock_good_jets(*_good_jet_selector);
     const LorentzVector *met = &(event->missing_energy().p4());
+    const float min_pt = jecPrefilterPt();
     for(Jets::const_iterator jet = event->jet().begin();
             event->jet().end() != jet;
             ++jet)
@@ -899,33 +1066,38 @@ bool SynchSelector::jets(const Event *event)
                                   event,
                                   _good_electrons,
                                   _good_muons,
-                                  met);
+                                  met,
+                                  min_pt);
 
         // Skip jet if energy corrections failed
         //
-        if (!correction.corrected_p4)
+        if (!correction.corrected_met)
             continue;
 
+        // Jets skipped by the prefilter fail nice jet selection and pass
+        // MET unchanged
+        //
+        if (!correction.corrected_p4
+                && _validate_jec_prefilter)
+            validateJecPrefilter(&*jet, event, met, min_pt);
+
         met = correction.corrected_met.get();
         _good_met = correction.corrected_met;
 
-        // Original jet in the event can not be modified and Jet Selector can
-        // only be applied to jet: therefore copy jet, set corrected p4 and
-        // apply selector
-        //
-        Jet corrected_jet;
-        corrected_jet.CopyFrom(*jet);
-        corrected_jet.mutable_physics_object()->mutable_p4()->CopyFrom(
-            *correction.corrected_p4);
+        if (!correction.corrected_p4)
+            continue;
 
-        if (!_nice_jet_selector->apply(corrected_jet))
+        // Original jet in the event can not be modified: apply selector to
+        // the jet with corrected p4
+        //
+        if (!_nice_jet_selector->apply(*jet, *correction.corrected_p4))
             continue;
 
         // Store original jet and corrected p4
         //
         _nice_jets.push_back(correction);
 
-        if (!_good_jet_selector->apply(corrected_jet))
+        if (!_good_jet_selector->apply(*jet, *correction.corrected_p4))
             continue;
 
         _good_jets.push_back(correction);
@@ -974,35 +1146,80 @@ bool SynchSelector::jets(const Event *event)
 
     if (_wjets_template)
         return 1 == _good_jets.size()
-               && (_cutflow->apply(JET), true);
+               && (passSelection(JET), true);
 
     return 1 < _good_jets.size()
-           && (_cutflow->apply(JET), true);
+           && (passSelection(JET), true);
+}
+
+float SynchSelector::jecPrefilterPt() const
+{
+    // Jets are skipped only if they fail nice jet pT cut. Good jets are
+    // a subset of the nice ones
+    //
+    const CutPtr pt_cut = _nice_jet_selector->cut(JetSelector::PT);
+
+    return pt_cut->isDisabled() || pt_cut->isInverted()
+        ? 0
+        : pt_cut->value();
+}
+
+void SynchSelector::validateJecPrefilter(const Jet *jet,
+        const Event *event,
+        const LorentzVector *met,
+        const float &min_pt)
+{
+    CorrectedJet correction = _jec->correctJet(jet,
+                              event,
+                              _good_electrons,
+                              _good_muons,
+                              met);
+
+    if (!correction.corrected_p4)
+        throw runtime_error("jet skipped by energy corrections prefilter "
+                "fails corrections");
+
+    if (min_pt < pt(*correction.corrected_p4))
+        throw runtime_error("jet skipped by energy corrections prefilter "
+                "has corrected pT " +
+                lexical_cast<string>(pt(*correction.corrected_p4)) +
+                " above " + lexical_cast<string>(min_pt));
+
+    if (correction.corrected_met->px() != met->px()
+            || correction.corrected_met->py() != met->py())
+        throw runtime_error("jet skipped by energy corrections prefilter "
+                "changes MET");
 }
 
 bool SynchSelector::lepton()
 {
+    CutflowTimer::Scope timer(*_timer, LEPTON);
+
     return (ELECTRON == _lepton_mode
             ? !_good_electrons.empty()
             : !_good_muons.empty())
 
-           && (_cutflow->apply(LEPTON), true);
+           && (passSelection(LEPTON), true);
 }
 
 bool SynchSelector::secondElectronVeto()
 {
+    CutflowTimer::Scope timer(*_timer, VETO_SECOND_ELECTRON);
+
     return (ELECTRON == _lepton_mode
             ? 1 == _good_electrons.size()
             : _good_electrons.empty())
-           && (_cutflow->apply(VETO_SECOND_ELECTRON), true);
+           && (passSelection(VETO_SECOND_ELECTRON), true);
 }
 
 bool SynchSelector::secondMuonVeto()
 {
+    CutflowTimer::Scope timer(*_timer, VETO_SECOND_MUON);
+
     return (ELECTRON == _lepton_mode
             ? _good_muons.empty()
             : 1 == _good_muons.size())
-           && (_cutflow->apply(VETO_SECOND_MUON), true);
+           && (passSelection(VETO_SECOND_MUON), true);
 }
 
 bool SynchSelector::isolationAnd2DCut()
@@ -1010,6 +1227,8 @@ bool SynchSelector::isolationAnd2DCut()
     if (_cut->isDisabled())
         return true;
 
+    CutflowTimer::Scope timer(*_timer, CUT_LEPTON);
+
     const LorentzVector *lepton_p4 = 0;
     const PFIsolation *lepton_isolation = 0;
 
@@ -1042,7 +1261,7 @@ bool SynchSelector::isolationAnd2DCut()
     }
 
     return _cut->apply(result)
-           && (_cutflow->apply(CUT_LEPTON), true);
+           && (passSelection(CUT_LEPTON), true);
 }
 
 bool SynchSelector::leadingJetCut()
@@ -1050,6 +1269,8 @@ bool SynchSelector::leadingJetCut()
     if (leadingJet()->isDisabled())
         return true;
 
+    CutflowTimer::Scope timer(*_timer, LEADING_JET);
+
     float max_pt = 0;
     for(GoodJets::const_iterator jet = _good_jets.begin();
             _good_jets.end() != jet;
@@ -1061,7 +1282,7 @@ bool SynchSelector::leadingJetCut()
     }
 
     return leadingJet()->apply(max_pt)
-           && (_cutflow->apply(LEADING_JET), true);
+           && (passSelection(LEADING_JET), true);
 }
 
 bool SynchSelector::maxBtags()
@@ -1069,8 +1290,10 @@ bool SynchSelector::maxBtags()
     if (maxBtag()->isDisabled())
         return true;
 
+    CutflowTimer::Scope timer(*_timer, MAX_BTAG);
+
     return maxBtag()->apply(countBtaggedJets())
-        && (_cutflow->apply(MAX_BTAG), true);
+        && (passSelection(MAX_BTAG), true);
 }
 
 bool SynchSelector::minBtags()
@@ -1078,8 +1301,10 @@ bool SynchSelector::minBtags()
     if (minBtag()->isDisabled())
         return true;
 
+    CutflowTimer::Scope timer(*_timer, MIN_BTAG);
+
     return minBtag()->apply(countBtaggedJets())
-                && (_cutflow->apply(MIN_BTAG), true);
+                && (passSelection(MIN_BTAG), true);
 }
 
 bool SynchSelector::toptagCut()
@@ -1087,6 +1312,8 @@ bool SynchSelector::toptagCut()
     if (toptag()->isDisabled())
         return true;
 
+    CutflowTimer::Scope timer(*_timer, TOPTAG);
+
     bool result = false;
 
     if (toptag()->value() == 0)
@@ -1094,7 +1321,7 @@ bool SynchSelector::toptagCut()
     else if (toptag()->value() == 1)
         result = (_top_jets.size() > 0);
 
-    return result && (_cutflow->apply(TOPTAG), true);
+    return result && (passSelection(TOPTAG), true);
 }
 
 bool SynchSelector::htlepCut(const Event *event)
@@ -1102,13 +1329,15 @@ bool SynchSelector::htlepCut(const Event *event)
     if (htlep()->isDisabled())
         return true;
 
+    CutflowTimer::Scope timer(*_timer, HTLEP);
+
     const LorentzVector &lepton_p4 = (ELECTRON == _lepton_mode
                                       ? (*_good_electrons.begin())->physics_object().p4()
                                       : (*_good_muons.begin())->physics_object().p4());
 
     return goodMET()
            && htlep()->apply(pt(*goodMET()) + pt(lepton_p4))
-           && (_cutflow->apply(HTLEP), true);
+           && (passSelection(HTLEP), true);
 }
 
 bool SynchSelector::triangularCut(const Event *event)
@@ -1116,6 +1345,8 @@ bool SynchSelector::triangularCut(const Event *event)
     if (tricut()->isDisabled())
         return true;
 
+    CutflowTimer::Scope timer(*_timer, TRICUT);
+
     if (!goodMET())
         return false;
 
@@ -1135,7 +1366,7 @@ bool SynchSelector::triangularCut(const Event *event)
                 && dphi_el_met > (-slope * met_pt + 1.5)
                 && dphi_ljet_met < (slope * met_pt + 1.5)
                 && dphi_ljet_met > (-slope * met_pt + 1.5)
-                && (_cutflow->apply(TRICUT), true);
+                && (passSelection(TRICUT), true);
 
     return tricut()->isInverted() ? !pass : pass;
 }
@@ -1145,9 +1376,11 @@ bool SynchSelector::missingEnergy(const Event *event)
     if (met()->isDisabled())
         return true;
 
+    CutflowTimer::Scope timer(*_timer, MET);
+
     return goodMET()
            && met()->apply(pt(*goodMET()))
-           && (_cutflow->apply(MET), true);
+           && (passSelection(MET), true);
 }
 
 bool SynchSelector::cut2D(const LorentzVector *lepton_p4)
@@ -1186,11 +1419,6 @@ bool SynchSelector::isolation(const LorentzVector *p4, const PFIsolation *isolat
            / pt(*p4);
 }
 
-void SynchSelector::invalidate_cache()
-{
-    _btagged_jets.invalidate();
-}
-
 void SynchSelector::selectGoodPrimaryVertices(const Event *event)
 {
     typedef ::google::protobuf::RepeatedPtrField<PrimaryVertex> PrimaryVertices;
@@ -1276,113 +1504,29 @@ bool SynchSelector::isToptagWeight() const
     return _weighted_toptag;
 }
 
-static float toptagWeight(float x)
+float SynchSelector::toptagWeight()
 {
-    float p0 = 5.40683e-02;
-    float p1 = 4.48390e+02;
-    float p2 = 2.76646e-02;
-    float p3 = 1.85887e-06;
-
-    return p0/(1+exp(-p2*(x-p1)-p3*pow(x-p1,3)));
+    return toptagWeights().atLeastOne();
 }
 
-// Overlapping area of two interceting circles
-static float overlapArea(
-    float d,
-    float r = 0.5,
-    float R = 0.8
-)
+float SynchSelector::toptagWeight(const uint32_t &tags)
 {
-    if (d > r+R) return 0.0;
-    if (d < R-r) return r*r*M_PI;
-
-    float d2 = d*d;
-    float r2 = r*r;
-    float R2 = R*R;
-
-    float A = r2*acos((d2+r2-R2)/(2*d*r));
-    float B = R2*acos((d2+R2-r2)/(2*d*R));
-    float C = 0.5*sqrt((-d+r+R)*(d+r-R)*(d-r+R)*(d+r+R));
-
-    return A + B - C;
+    return toptagWeights().exactly(tags);
 }
 
-float SynchSelector::toptagWeight()
+const bsm::ToptagWeight &SynchSelector::toptagWeights()
 {
-    float total_weight = 0.0;
-    uint32_t nperm = pow(2,_ca_jets.size());
-
-    for(uint32_t perm = 1; perm < nperm; ++perm)
+    // Tag probabilities are calculated once per event
+    //
+    if (!_toptag_weight.is_valid(_event_generation))
     {
-        uint32_t index = 0;
-        float weight = 1.0;    
-
-        for(SynchSelector::GoodJets::const_iterator cajet = _ca_jets.begin();
-                _ca_jets.end() != cajet;
-                ++cajet, ++index)
-        {
-            bool tag = (perm >> index) & 1;
+        ToptagWeight weight;
+        weight.add(_ca_jets);
 
-            if (!tag)
-                weight *= 1.0 - ::toptagWeight(pt(*cajet->corrected_p4));
-            else
-            {
-                weight *= ::toptagWeight(pt(*cajet->corrected_p4));
-
-                // Loop over the good jets to find
-                // those close to leading ca jet
-                /*typedef vector<float> Areas;
-                typedef vector<SynchSelector::GoodJets::iterator> ConeJets;
-
-                float totalArea = 0.0;
-                Areas areas;
-                ConeJets coneJets;
-                LorentzVector p4;
-
-                for(SynchSelector::GoodJets::iterator jet = _good_jets.begin();
-                    _good_jets.end() != jet;
-                ++jet)
-                {
-                float x = dr(*jet->corrected_p4, *cajet->corrected_p4);
-
-                if (x < 1.3)
-                {
-                    float area = overlapArea(x);
-                    // cout << "Area: " << x << " : " << area << endl;
-                    totalArea += area;
-                    areas.push_back(area);
-                    coneJets.push_back(jet);
-                    LorentzVector p4jet = *(jet->corrected_p4);
-                    p4jet *= area;
-                    p4 += p4jet;
-                }
-                }
-
-                p4 *= (1.0/totalArea);
-
-                float mass = _random_generator->value();
-                float e = sqrt(
-                p4.px() * p4.px() +
-                p4.py() * p4.py() +
-                p4.pz() * p4.pz() +
-                mass * mass
-                );
-
-                for(size_t i = 0; i < coneJets.size(); ++i)
-                {
-                coneJets[i]->corrected_p4->set_e(
-                    e * areas[i] * coneJets[i]->corrected_p4->e() / (p4.e()*totalArea)
-                );
-                }*/
-            }
-        }
-        total_weight += weight;
+        _toptag_weight.set(_event_generation, weight);
     }
 
-    // cout << "leading jet pt: " << pt(*_good_jets[0].corrected_p4);
-    // cout << " weight: " << total_weight << endl;
-
-    return total_weight;
+    return _toptag_weight.get(_event_generation);
 }
 
 // Helpers
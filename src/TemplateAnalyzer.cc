@@ -104,6 +104,41 @@ TemplatesOptions::TemplatesOptions()
              boost::bind(&TemplatesOptions::setReconstructionWithCollimatedTops, this)),
          "Reconstruct collimated tops with mass constrain")
 
+        ("pruned-reconstruction",
+         po::value<bool>()->implicit_value(true)->notifier(
+             boost::bind(&TemplatesOptions::setPrunedReconstruction, this)),
+         "Skip jets assignments that can not improve the best hypothesis (same result, faster)")
+
+        ("incremental-reconstruction",
+         po::value<bool>()->implicit_value(true)->notifier(
+             boost::bind(&TemplatesOptions::setIncrementalReconstruction, this)),
+         "Update hadronic top with one jet per hypothesis (result may differ at rounding level)")
+
+        ("batch-chi2-reconstruction",
+         po::value<bool>()->implicit_value(true)->notifier(
+             boost::bind(&TemplatesOptions::setBatchChi2Reconstruction, this)),
+         "Score chi2 hypotheses in blocks (same chi2 of the best hypothesis, faster)")
+
+        ("shootout-reconstruction",
+         po::value<bool>()->implicit_value(true)->notifier(
+             boost::bind(&TemplatesOptions::setShootoutReconstruction, this)),
+         "Reconstruct mttbar with all algorithms in one pass and save mttbar templates of every algorithm")
+
+        ("reconstruction-max-jets",
+         po::value<uint32_t>()->notifier(
+             boost::bind(&TemplatesOptions::setReconstructionMaxJets, this, _1)),
+         "Reconstruct mttbar with given number of leading jets (0 - all jets)")
+
+        ("reconstruction-keep-btags",
+         po::value<bool>()->implicit_value(true)->notifier(
+             boost::bind(&TemplatesOptions::setReconstructionKeepBtags, this)),
+         "Keep b-tagged jets beyond the leading ones in reconstruction")
+
+        ("truncation-report",
+         po::value<bool>()->implicit_value(true)->notifier(
+             boost::bind(&TemplatesOptions::setTruncationReport, this)),
+         "Reconstruct mttbar with all jets too and save histograms of events where jets truncation changed the best hypothesis")
+
         ("chi2-reconstruction",
          po::value<string>()->notifier(
              boost::bind(&TemplatesOptions::setChi2Reconstruction, this, _1)),
@@ -231,6 +266,62 @@ void TemplatesOptions::setReconstructionWithCollimatedTops()
     delegate()->setReconstructionWithCollimatedTops();
 }
 
+void TemplatesOptions::setPrunedReconstruction()
+{
+    if (!delegate())
+        return;
+
+    delegate()->setPrunedReconstruction();
+}
+
+void TemplatesOptions::setIncrementalReconstruction()
+{
+    if (!delegate())
+        return;
+
+    delegate()->setIncrementalReconstruction();
+}
+
+void TemplatesOptions::setBatchChi2Reconstruction()
+{
+    if (!delegate())
+        return;
+
+    delegate()->setBatchChi2Reconstruction();
+}
+
+void TemplatesOptions::setShootoutReconstruction()
+{
+    if (!delegate())
+        return;
+
+    delegate()->setShootoutReconstruction();
+}
+
+void TemplatesOptions::setReconstructionMaxJets(const uint32_t &value)
+{
+    if (!delegate())
+        return;
+
+    delegate()->setReconstructionMaxJets(value);
+}
+
+void TemplatesOptions::setReconstructionKeepBtags()
+{
+    if (!delegate())
+        return;
+
+    delegate()->setReconstructionKeepBtags();
+}
+
+void TemplatesOptions::setTruncationReport()
+{
+    if (!delegate())
+        return;
+
+    delegate()->setTruncationReport();
+}
+
 void TemplatesOptions::setChi2Reconstruction(const string &value)
 {
     if (!delegate())
@@ -365,7 +456,10 @@ TemplateAnalyzer::TemplateAnalyzer():
     _data_input(false),
     _wjets_input(false),
     _zjets_input(false),
-    _apply_wjet_correction(false)
+    _apply_wjet_correction(false),
+    _reconstruction_search(ResonanceReconstructor::EXHAUSTIVE),
+    _batch_chi2_reconstruction(false),
+    _report_truncation(false)
 {
     _synch_selector.reset(new SynchSelector());
     monitor(_synch_selector);
@@ -577,13 +671,25 @@ TemplateAnalyzer::TemplateAnalyzer():
 
     _reconstructor.reset(new SimpleResonanceReconstructor());
     monitor(_reconstructor);
+
+    _shootout_templates.reset(new HistogramBookkeeper());
+    monitor(_shootout_templates);
+
+    _jet_truncation.reset(new JetTruncation());
+    monitor(_jet_truncation);
+
+    _truncation_report.reset(new HistogramBookkeeper());
+    monitor(_truncation_report);
 }
 
 TemplateAnalyzer::TemplateAnalyzer(const TemplateAnalyzer &object):
     _data_input(false),
     _wjets_input(false),
     _zjets_input(false),
-    _apply_wjet_correction(object._apply_wjet_correction)
+    _apply_wjet_correction(object._apply_wjet_correction),
+    _reconstruction_search(object._reconstruction_search),
+    _batch_chi2_reconstruction(object._batch_chi2_reconstruction),
+    _report_truncation(object._report_truncation)
 {
     _synch_selector = 
         dynamic_pointer_cast<SynchSelector>(object._synch_selector->clone());
@@ -816,108 +922,190 @@ TemplateAnalyzer::TemplateAnalyzer(const TemplateAnalyzer &object):
     _reconstructor = 
         dynamic_pointer_cast<ResonanceReconstructor>(object._reconstructor->clone());
     monitor(_reconstructor);
+
+    if (object._shootout)
+        _shootout =
+            dynamic_pointer_cast<ResonanceShootout>(object._shootout->clone());
+
+    _shootout_templates =
+        dynamic_pointer_cast<HistogramBookkeeper>(object._shootout_templates->clone());
+    monitor(_shootout_templates);
+
+    _jet_truncation =
+        dynamic_pointer_cast<JetTruncation>(object._jet_truncation->clone());
+    monitor(_jet_truncation);
+
+    _truncation_report =
+        dynamic_pointer_cast<HistogramBookkeeper>(object._truncation_report->clone());
+    monitor(_truncation_report);
 }
 
 void TemplateAnalyzer::setBtagReconstruction()
 {
-    stopMonitor(_reconstructor);
-
-    _reconstructor.reset(new BtagResonanceReconstructor());
-    monitor(_reconstructor);
+    setReconstructor(new BtagResonanceReconstructor());
 }
 
 void TemplateAnalyzer::setSimpleDrReconstruction()
 {
-    stopMonitor(_reconstructor);
-
-    _reconstructor.reset(new SimpleDrResonanceReconstructor());
-    monitor(_reconstructor);
+    setReconstructor(new SimpleDrResonanceReconstructor());
 }
 
 void TemplateAnalyzer::setHemisphereReconstruction()
 {
-    stopMonitor(_reconstructor);
-
-    _reconstructor.reset(new HemisphereResonanceReconstructor());
-    monitor(_reconstructor);
+    setReconstructor(new HemisphereResonanceReconstructor());
 }
 
 void TemplateAnalyzer::setReconstructionWithMass()
 {
-    stopMonitor(_reconstructor);
-
-    _reconstructor.reset(new ResonanceReconstructorWithMass());
-    monitor(_reconstructor);
+    setReconstructor(new ResonanceReconstructorWithMass());
 }
 
 void TemplateAnalyzer::setReconstructionWithPhi()
 {
-    stopMonitor(_reconstructor);
-
-    _reconstructor.reset(new ResonanceReconstructorWithPhi());
-    monitor(_reconstructor);
+    setReconstructor(new ResonanceReconstructorWithPhi());
 }
 
 void TemplateAnalyzer::setReconstructionWithMassAndPhi()
 {
-    stopMonitor(_reconstructor);
-
-    _reconstructor.reset(new ResonanceReconstructorWithMassAndPhi());
-    monitor(_reconstructor);
+    setReconstructor(new ResonanceReconstructorWithMassAndPhi());
 }
 
 void TemplateAnalyzer::setSimpleReconstructionWithMassAndPhi()
 {
-    stopMonitor(_reconstructor);
-
-    _reconstructor.reset(new SimpleResonanceReconstructorWithMassAndPhi());
-    monitor(_reconstructor);
+    setReconstructor(new SimpleResonanceReconstructorWithMassAndPhi());
 }
 
 void TemplateAnalyzer::setSimpleReconstructionWithMass()
 {
-    stopMonitor(_reconstructor);
-
-    _reconstructor.reset(new SimpleResonanceReconstructorWithMass());
-    monitor(_reconstructor);
+    setReconstructor(new SimpleResonanceReconstructorWithMass());
 }
 
 void TemplateAnalyzer::setCollimatedSimpleReconstructionWithMass()
 {
-    stopMonitor(_reconstructor);
-
-    _reconstructor.reset(new CollimatedSimpleResonanceReconstructorWithMass());
-    monitor(_reconstructor);
+    setReconstructor(new CollimatedSimpleResonanceReconstructorWithMass());
 }
 
 void TemplateAnalyzer::setCollimatedSimpleReconstructionWithTopMass()
 {
-    stopMonitor(_reconstructor);
-
-    _reconstructor.reset(new CollimatedSimpleResonanceReconstructorWithTopMass());
-    monitor(_reconstructor);
+    setReconstructor(new CollimatedSimpleResonanceReconstructorWithTopMass());
 }
 
 void TemplateAnalyzer::setReconstructionWithCollimatedTops()
 {
-    stopMonitor(_reconstructor);
+    setReconstructor(new ResonanceReconstructorWithCollimatedTops());
+}
 
-    _reconstructor.reset(new ResonanceReconstructorWithCollimatedTops());
-    monitor(_reconstructor);
+void TemplateAnalyzer::setPrunedReconstruction()
+{
+    _reconstruction_search = ResonanceReconstructor::PRUNED;
+
+    _reconstructor->setSearch(_reconstruction_search);
+}
+
+void TemplateAnalyzer::setIncrementalReconstruction()
+{
+    _reconstruction_search = ResonanceReconstructor::INCREMENTAL;
+
+    _reconstructor->setSearch(_reconstruction_search);
+}
+
+void TemplateAnalyzer::setBatchChi2Reconstruction()
+{
+    _batch_chi2_reconstruction = true;
+
+    // Options are applied in alphabetical order: chi2 reconstructor may
+    // be created later
+    //
+    boost::shared_ptr<Chi2ResonanceReconstructor> reconstructor =
+        dynamic_pointer_cast<Chi2ResonanceReconstructor>(_reconstructor);
+
+    if (reconstructor)
+        reconstructor->setBatch(_batch_chi2_reconstruction);
+}
+
+void TemplateAnalyzer::setShootoutReconstruction()
+{
+    if (_shootout)
+        return;
+
+    typedef ResonanceShootout::ReconstructorPtr ReconstructorPtr;
+
+    _shootout.reset(new ResonanceShootout());
+    _shootout->add("simple",
+            ReconstructorPtr(new SimpleResonanceReconstructor()));
+    _shootout->add("btag",
+            ReconstructorPtr(new BtagResonanceReconstructor()));
+    _shootout->add("simple_dr",
+            ReconstructorPtr(new SimpleDrResonanceReconstructor()));
+    _shootout->add("hemisphere",
+            ReconstructorPtr(new HemisphereResonanceReconstructor()));
+    _shootout->add("mass",
+            ReconstructorPtr(new ResonanceReconstructorWithMass()));
+    _shootout->add("phi",
+            ReconstructorPtr(new ResonanceReconstructorWithPhi()));
+    _shootout->add("mass_and_phi",
+            ReconstructorPtr(new ResonanceReconstructorWithMassAndPhi()));
+    _shootout->add("simple_mass_and_phi",
+            ReconstructorPtr(new SimpleResonanceReconstructorWithMassAndPhi()));
+    _shootout->add("simple_mass",
+            ReconstructorPtr(new SimpleResonanceReconstructorWithMass()));
+    _shootout->add("collimated_simple_mass",
+            ReconstructorPtr(new CollimatedSimpleResonanceReconstructorWithMass()));
+    _shootout->add("collimated_simple_top_mass",
+            ReconstructorPtr(new CollimatedSimpleResonanceReconstructorWithTopMass()));
+    _shootout->add("collimated_tops",
+            ReconstructorPtr(new ResonanceReconstructorWithCollimatedTops()));
+
+    // Options are applied in alphabetical order: chi2 reconstructor is
+    // already created if requested
+    //
+    if (dynamic_pointer_cast<Chi2ResonanceReconstructor>(_reconstructor))
+    {
+        _shootout->add("chi2",
+                dynamic_pointer_cast<ResonanceReconstructor>(
+                    _reconstructor->clone()));
+    }
+
+    for(uint32_t index = 0; _shootout->size() > index; ++index)
+    {
+        _shootout_templates->book1d("mttbar_before_htlep_" +
+                _shootout->name(index), 4000, 0, 4);
+        _shootout_templates->book1d("mttbar_after_htlep_" +
+                _shootout->name(index), 4000, 0, 4);
+    }
+}
+
+void TemplateAnalyzer::setReconstructionMaxJets(const uint32_t &max_jets)
+{
+    _jet_truncation->setMaxJets(max_jets);
+}
+
+void TemplateAnalyzer::setReconstructionKeepBtags()
+{
+    _jet_truncation->setKeepBtags(true);
+}
+
+void TemplateAnalyzer::setTruncationReport()
+{
+    if (_report_truncation)
+        return;
+
+    _report_truncation = true;
+
+    _truncation_report->book1d("truncated_njets", 15, 0, 15);
+    _truncation_report->book1d("truncation_changed_njets", 15, 0, 15);
+    _truncation_report->book1d("truncation_mttbar_shift", 400, -2, 2);
 }
 
 void TemplateAnalyzer::setChi2Reconstruction(const Chi2Discriminators &ltop,
                                              const Chi2Discriminators &htop)
 {
-    stopMonitor(_reconstructor);
-
     Chi2ResonanceReconstructor *reco = new Chi2ResonanceReconstructor();
     reco->setLtopDiscriminators(ltop);
     reco->setHtopDiscriminators(htop);
+    reco->setBatch(_batch_chi2_reconstruction);
 
-    _reconstructor.reset(reco);
-
-    monitor(_reconstructor);
+    setReconstructor(reco);
 }
 
 const TemplateAnalyzer::H1Ptr TemplateAnalyzer::cutflow() const
@@ -1195,6 +1383,18 @@ const TemplateAnalyzer::H1Ptr TemplateAnalyzer::njet2DrLeptonJet2AfterReconstruc
     return _njet2_dr_lepton_jet2_after_reconstruction->histogram();
 }
 
+const boost::shared_ptr<bsm::HistogramBookkeeper>
+    TemplateAnalyzer::shootoutTemplates() const
+{
+    return _shootout_templates;
+}
+
+const boost::shared_ptr<bsm::HistogramBookkeeper>
+    TemplateAnalyzer::truncationReport() const
+{
+    return _truncation_report;
+}
+
 bsm::JetEnergyCorrectionDelegate
     *TemplateAnalyzer::getJetEnergyCorrectionDelegate() const
 {
@@ -1254,6 +1454,8 @@ void TemplateAnalyzer::didCounterAdd(const Counter *counter)
 
 void TemplateAnalyzer::onFileOpen(const std::string &filename, const Input *input)
 {
+    _synch_selector->setTriggerMenu(input);
+
     if (input->has_type())
     {
         _data_input = (Input::DATA == input->type());
@@ -1279,12 +1481,27 @@ void TemplateAnalyzer::onFileOpen(const std::string &filename, const Input *inpu
 
 void TemplateAnalyzer::process(const Event *event)
 {
+    _event_generation.next();
+
     if (!_synch_selector_with_inverted_htlep)
     {
         _synch_selector_with_inverted_htlep =
             dynamic_pointer_cast<SynchSelector>(_synch_selector->clone());
 
         _synch_selector_with_inverted_htlep->htlep()->invert();
+
+        // Selector is not printed: do not waste time on its timing
+        //
+        _synch_selector_with_inverted_htlep->setCutflowTiming(false);
+    }
+
+    if (_shootout
+            && !_shootout_reconstruction)
+    {
+        _shootout_reconstruction =
+            dynamic_pointer_cast<Cut>(_synch_selector->reconstruction()->clone());
+        _shootout_ltop = dynamic_pointer_cast<Cut>(_synch_selector->ltop()->clone());
+        _shootout_chi2 = dynamic_pointer_cast<Cut>(_synch_selector->chi2()->clone());
     }
 
     _pileup_weight = _data_input ? 1. : 0.;
@@ -1327,7 +1544,10 @@ void TemplateAnalyzer::process(const Event *event)
                     _pileup_weight * _extra_weight);
         }
 
-        Mttbar resonance = mttbar();
+        if (_shootout)
+            fillShootout(*_synch_selector, "mttbar_after_htlep_", true);
+
+        const Mttbar &resonance = mttbar();
 
         if (_synch_selector->reconstruction(resonance.valid)
                 && _synch_selector->ltop(pt(resonance.ltop))
@@ -1492,11 +1712,16 @@ void TemplateAnalyzer::process(const Event *event)
         }
     }
 
-    // Process only events, that pass the synch selector with htlep inverted
+    // Process only events, that pass the synch selector with htlep inverted.
+    // Selections before htlep are shared with the nominal selector
     //
-    if (_synch_selector_with_inverted_htlep->apply(event))
+    if (_synch_selector_with_inverted_htlep->apply(event, *_synch_selector))
     {
-        Mttbar resonance = mttbar();
+        if (_shootout)
+            fillShootout(*_synch_selector_with_inverted_htlep,
+                         "mttbar_before_htlep_", false);
+
+        const Mttbar &resonance = mttbar();
 
         if (_synch_selector_with_inverted_htlep->reconstruction(resonance.valid)
                 && _synch_selector_with_inverted_htlep->ltop(pt(resonance.ltop)))
@@ -1504,7 +1729,7 @@ void TemplateAnalyzer::process(const Event *event)
             htlep()->fill(htlepValue(), _pileup_weight * _extra_weight);
             htlepBeforeHtlep()->fill(htlepValue(), _pileup_weight * _extra_weight);
             htlepBeforeHtlepNoWeight()->fill(htlepValue());
-            mttbarBeforeHtlep()->fill(mass(mttbar().mttbar) / 1000, _pileup_weight * _extra_weight);
+            mttbarBeforeHtlep()->fill(mass(resonance.mttbar) / 1000, _pileup_weight * _extra_weight);
         }
     } 
 
@@ -1538,7 +1763,7 @@ void TemplateAnalyzer::merge(const ObjectPtr &pointer)
 
     // Reset counter delegates
     //
-    for(uint32_t cut = 0; SynchSelector::SELECTIONS < cut; ++cut)
+    for(uint32_t cut = 0; SynchSelector::SELECTIONS > cut; ++cut)
         _synch_selector->cutflow()->cut(cut)->events().get()->setDelegate(0);
 
     Object::merge(pointer);
@@ -1549,6 +1774,17 @@ void TemplateAnalyzer::print(std::ostream &out) const
     out << "Reconstructor: " << *_reconstructor << endl;
     out << endl;
 
+    if (_shootout)
+    {
+        out << *_shootout << endl;
+        out << endl;
+    }
+
+    if (_jet_truncation->maxJets())
+    {
+        out << *_jet_truncation << endl;
+    }
+
     out << *_synch_selector << endl;
 }
 
@@ -1602,8 +1838,27 @@ void TemplateAnalyzer::fillDrVsPtrel()
     }
 }
 
-TemplateAnalyzer::Mttbar TemplateAnalyzer::mttbar() const
+const TemplateAnalyzer::Mttbar &TemplateAnalyzer::mttbar()
 {
+    if (!_mttbar.is_valid(_event_generation))
+    {
+        _mttbar.set(_event_generation, reconstruct());
+
+        if (_report_truncation)
+            reportTruncation(_mttbar.get(_event_generation));
+    }
+
+    return _mttbar.get(_event_generation);
+}
+
+TemplateAnalyzer::Mttbar TemplateAnalyzer::reconstruct() const
+{
+    // Reconstruction of both nominal and inverted hTlep selections is
+    // accounted in the nominal selector
+    //
+    CutflowTimer::Scope timer(*_synch_selector->timer(),
+            SynchSelector::RECONSTRUCTION);
+
     if (!_event)
     {
         clog << "event is not available: can not reconstruct mttbar" << endl;
@@ -1618,9 +1873,18 @@ TemplateAnalyzer::Mttbar TemplateAnalyzer::mttbar() const
         ? (*_synch_selector->goodElectrons().begin())->physics_object().p4()
         : (*_synch_selector->goodMuons().begin())->physics_object().p4();
 
-    if (10 < _synch_selector->goodJets().size())
+    // Hypotheses are generated for the leading jets only if truncation
+    // is enabled
+    //
+    SynchSelector::GoodJets truncated_jets;
+    const SynchSelector::GoodJets &jets =
+        _jet_truncation->apply(_synch_selector->goodJets(), truncated_jets)
+        ? truncated_jets
+        : _synch_selector->goodJets();
+
+    if (10 < jets.size())
     {
-        clog << _synch_selector->goodJets().size()
+        clog << jets.size()
             << " good jets are found: skip hypothesis generation" << endl;
 
         return Mttbar();
@@ -1628,7 +1892,140 @@ TemplateAnalyzer::Mttbar TemplateAnalyzer::mttbar() const
 
     return _reconstructor->run(lepton_p4,
                                *_synch_selector->goodMET(),
-                               _synch_selector->goodJets());
+                               jets);
+}
+
+void TemplateAnalyzer::reportTruncation(const Mttbar &resonance)
+{
+    const SynchSelector::GoodJets &good_jets = _synch_selector->goodJets();
+
+    // Events without dropped jets are not affected. Reference can not be
+    // reconstructed if there are too many jets
+    //
+    SynchSelector::GoodJets truncated_jets;
+    if (!_jet_truncation->apply(good_jets, truncated_jets)
+            || 10 < good_jets.size())
+        return;
+
+    const LorentzVector &lepton_p4 =
+        SynchSelector::ELECTRON == _synch_selector->leptonMode()
+        ? (*_synch_selector->goodElectrons().begin())->physics_object().p4()
+        : (*_synch_selector->goodMuons().begin())->physics_object().p4();
+
+    const Mttbar reference = _reconstructor->run(lepton_p4,
+                                                 *_synch_selector->goodMET(),
+                                                 good_jets);
+
+    const float weight = _pileup_weight * _extra_weight;
+
+    _truncation_report->get1d("truncated_njets")->fill(good_jets.size(),
+            weight);
+
+    if (isSameHypothesis(resonance, reference))
+        return;
+
+    _truncation_report->get1d("truncation_changed_njets")->fill(
+            good_jets.size(), weight);
+
+    if (resonance.valid
+            && reference.valid)
+    {
+        _truncation_report->get1d("truncation_mttbar_shift")->fill(
+                (mass(resonance.mttbar) - mass(reference.mttbar)) / 1000,
+                weight);
+    }
+}
+
+bool TemplateAnalyzer::isSameHypothesis(const Mttbar &resonance,
+        const Mttbar &other_resonance) const
+{
+    if (resonance.valid != other_resonance.valid)
+        return false;
+
+    if (!resonance.valid)
+        return true;
+
+    // Truncated jets share corrected p4 with good jets
+    //
+    typedef ResonanceReconstructor::CorrectedJets CorrectedJets;
+
+    const CorrectedJets *jets[] = {&resonance.ltop_jets, &resonance.htop_jets};
+    const CorrectedJets *other_jets[] = {&other_resonance.ltop_jets,
+                                         &other_resonance.htop_jets};
+
+    for(uint32_t side = 0; 2 > side; ++side)
+    {
+        if (jets[side]->size() != other_jets[side]->size())
+            return false;
+
+        for(uint32_t jet = 0; jets[side]->size() > jet; ++jet)
+        {
+            if ((*jets[side])[jet].corrected_p4
+                    != (*other_jets[side])[jet].corrected_p4)
+                return false;
+        }
+    }
+
+    // Neutrino solution is chosen with the jets assignment
+    //
+    const LorentzVector &neutrino = resonance.neutrino;
+    const LorentzVector &other_neutrino = other_resonance.neutrino;
+
+    return neutrino.px() == other_neutrino.px()
+        && neutrino.py() == other_neutrino.py()
+        && neutrino.pz() == other_neutrino.pz();
+}
+
+void TemplateAnalyzer::fillShootout(const SynchSelector &selector,
+        const std::string &prefix,
+        const bool &apply_chi2)
+{
+    CutflowTimer::Scope timer(*_synch_selector->timer(),
+            SynchSelector::RECONSTRUCTION);
+
+    // Same event requirements as of the nominal reconstruction
+    //
+    SynchSelector::GoodJets truncated_jets;
+    const SynchSelector::GoodJets &jets =
+        _jet_truncation->apply(selector.goodJets(), truncated_jets)
+        ? truncated_jets
+        : selector.goodJets();
+
+    if (10 < jets.size())
+        return;
+
+    const LorentzVector &lepton_p4 =
+        SynchSelector::ELECTRON == selector.leptonMode()
+        ? (*selector.goodElectrons().begin())->physics_object().p4()
+        : (*selector.goodMuons().begin())->physics_object().p4();
+
+    ResonanceShootout::Results results;
+    _shootout->run(lepton_p4, *selector.goodMET(), jets, results);
+
+    for(uint32_t index = 0; results.size() > index; ++index)
+    {
+        const Mttbar &resonance = results[index];
+
+        if (!_shootout_reconstruction->apply(resonance.valid)
+                || !_shootout_ltop->apply(pt(resonance.ltop))
+                || (apply_chi2
+                    && !_shootout_chi2->apply(resonance.ltop_discriminator +
+                                              resonance.htop_discriminator)))
+            continue;
+
+        _shootout_templates->get1d(prefix + _shootout->name(index))->fill(
+                mass(resonance.mttbar) / 1000, _pileup_weight * _extra_weight);
+    }
+}
+
+void TemplateAnalyzer::setReconstructor(ResonanceReconstructor *reconstructor)
+{
+    stopMonitor(_reconstructor);
+
+    _reconstructor.reset(reconstructor);
+    _reconstructor->setSearch(_reconstruction_search);
+
+    monitor(_reconstructor);
 }
 
 void TemplateAnalyzer::monitorJets()
@@ -1647,30 +2044,41 @@ void TemplateAnalyzer::monitorJets()
 }
 
 
-float TemplateAnalyzer::htlepValue() const
+float TemplateAnalyzer::htlepValue()
 {
-    // Note: leptons are kept in a vector of pointers
-    const LorentzVector &lepton_p4 =
-        SynchSelector::ELECTRON == _synch_selector->leptonMode()
-        ? (*_synch_selector->goodElectrons().begin())->physics_object().p4()
-        : (*_synch_selector->goodMuons().begin())->physics_object().p4();
+    if (!_htlep_value.is_valid(_event_generation))
+    {
+        // Note: leptons are kept in a vector of pointers
+        const LorentzVector &lepton_p4 =
+            SynchSelector::ELECTRON == _synch_selector->leptonMode()
+            ? (*_synch_selector->goodElectrons().begin())->physics_object().p4()
+            : (*_synch_selector->goodMuons().begin())->physics_object().p4();
 
-    return pt(*_synch_selector->goodMET()) + pt(lepton_p4);
+        _htlep_value.set(_event_generation,
+                pt(*_synch_selector->goodMET()) + pt(lepton_p4));
+    }
+
+    return _htlep_value.get(_event_generation);
 }
 
-float TemplateAnalyzer::htallValue() const
+float TemplateAnalyzer::htallValue()
 {
-    // Computting the HT of the event
-    float htjets = 0;
-    for(
-        SynchSelector::GoodJets::const_iterator jet =
-        _synch_selector->goodJets().begin();
-        _synch_selector->goodJets().end() != jet;
-        ++jet
-    )
-        htjets += pt(*jet->corrected_p4);
+    if (!_htall_value.is_valid(_event_generation))
+    {
+        // Computting the HT of the event
+        float htjets = 0;
+        for(
+            SynchSelector::GoodJets::const_iterator jet =
+            _synch_selector->goodJets().begin();
+            _synch_selector->goodJets().end() != jet;
+            ++jet
+        )
+            htjets += pt(*jet->corrected_p4);
+
+        _htall_value.set(_event_generation, htjets + htlepValue());
+    }
 
-    return htjets + htlepValue();
+    return _htall_value.get(_event_generation);
 }
 
 WDecay TemplateAnalyzer::eventDecay(const Event *event) const
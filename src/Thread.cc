@@ -7,12 +7,16 @@
 
 #include <algorithm>
 #include <climits>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 
+#include <boost/filesystem.hpp>
 #include <boost/pointer_cast.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 #include "bsm_input/interface/Event.pb.h"
+#include "bsm_input/interface/Input.pb.h"
 #include "bsm_core/interface/Keyboard.h"
 
 #include "interface/Analyzer.h"
@@ -23,9 +27,16 @@ using namespace std;
 
 using boost::shared_ptr;
 
+namespace fs = boost::filesystem;
+
 using bsm::AnalyzerPtr;
+using bsm::EventRange;
 using bsm::KeyboardOperation;
 using bsm::AnalyzerOperation;
+using bsm::MergeOperation;
+using bsm::ReaderOperation;
+using bsm::StatsOperation;
+using bsm::Summary;
 using bsm::ThreadController;
 
 using bsm::core::Lock;
@@ -33,6 +44,82 @@ using bsm::core::Thread;
 
 typedef boost::shared_ptr<AnalyzerOperation> AnalyzerOperationPtr;
 typedef boost::shared_ptr<KeyboardOperation> KeyboardOperationPtr;
+typedef boost::shared_ptr<MergeOperation> MergeOperationPtr;
+typedef boost::shared_ptr<ReaderOperation> ReaderOperationPtr;
+typedef boost::shared_ptr<StatsOperation> StatsOperationPtr;
+
+// Compare ranges by the number of events. Unbounded ranges are treated as
+// empty ones since they can not be split
+//
+static bool eventRangeLess(const EventRange &r1, const EventRange &r2)
+{
+    return (r1.isBounded() ? r1.size() : 0) < (r2.isBounded() ? r2.size() : 0);
+}
+
+// Order ranges longest-first by the size on disk
+//
+static bool eventRangeLonger(const EventRange &r1, const EventRange &r2)
+{
+    return r1.bytes > r2.bytes;
+}
+
+// Estimated size of the part of the range [first, last)
+//
+static uint64_t rangeBytes(const EventRange &range,
+        const uint32_t &first,
+        const uint32_t &last)
+{
+    return range.size() && last > first
+        ? range.bytes * (last - first) / range.size()
+        : 0;
+}
+
+// Analyzer thread cursor keeps index of the next event to be read and the
+// end of range in one word: both values are updated with a single CAS
+//
+static uint64_t cursor(const uint32_t &event, const uint32_t &last)
+{
+    return (static_cast<uint64_t>(event) << 32) | last;
+}
+
+static uint32_t cursorEvent(const uint64_t &cursor)
+{
+    return cursor >> 32;
+}
+
+static uint32_t cursorLast(const uint64_t &cursor)
+{
+    return cursor & 0xFFFFFFFF;
+}
+
+// Event Range
+//
+EventRange::EventRange(const std::string &file_name,
+        const uint32_t &first,
+        const uint32_t &last):
+    file_name(file_name),
+    first(first),
+    last(last),
+    bytes(0)
+{
+}
+
+bool EventRange::empty() const
+{
+    return file_name.empty();
+}
+
+bool EventRange::isBounded() const
+{
+    return UINT_MAX != last;
+}
+
+uint32_t EventRange::size() const
+{
+    return last > first ? last - first : 0;
+}
+
+
 
 // Keyboard Thread
 //
@@ -93,12 +180,72 @@ bool KeyboardOperation::isContinue() const
 
 
 
+// Stats Thread
+//
+StatsOperation::StatsOperation(ThreadController *controller,
+        const uint32_t &period):
+    _controller(controller),
+    _period(period ? period : 1),
+    _continue(true)
+{
+    _thread = 0;
+}
+
+void StatsOperation::run()
+{
+    using boost::posix_time::microsec_clock;
+    using boost::posix_time::ptime;
+    using boost::posix_time::seconds;
+
+    if (!_thread
+            || !_controller)
+        return;
+
+    // Sleep in short intervals not to delay the job end
+    //
+    ptime next_sample = microsec_clock::universal_time() + seconds(_period);
+    for(boost::posix_time::milliseconds delay(100);
+            isContinue();
+            boost::this_thread::sleep(delay))
+    {
+        if (microsec_clock::universal_time() < next_sample)
+            continue;
+
+        _controller->writeStats();
+
+        next_sample = microsec_clock::universal_time() + seconds(_period);
+    }
+}
+
+void StatsOperation::stop()
+{
+    _continue = false;
+}
+
+void StatsOperation::onThreadInit(Thread *thread)
+{
+    _thread = thread;
+}
+
+// Private
+//
+bool StatsOperation::isContinue() const
+{
+    return _continue.load(boost::memory_order_relaxed);
+}
+
+
+
 // Analyzer Thread
 //
 AnalyzerOperation::AnalyzerOperation():
     _continue(true),
+    _cursor(0),
     _events_processed(0),
-    _total_events_size(0)
+    _total_events_size(0),
+    _predicted_load(0),
+    _bytes_processed(0),
+    _busy_time(0)
 {
     _thread = 0;
     _controller = 0;
@@ -126,6 +273,14 @@ void AnalyzerOperation::use(const AnalyzerPtr &analyzer)
     _analyzer = analyzer;
 }
 
+void AnalyzerOperation::use(const EventQueuePtr &queue)
+{
+    if (isRunning())
+        return;
+
+    _queue = queue;
+}
+
 void AnalyzerOperation::setReaderDelegate(ReaderDelegate *delegate)
 {
     _reader_delegate = delegate;
@@ -141,9 +296,24 @@ AnalyzerPtr AnalyzerOperation::analyzer() const
     return _analyzer;
 }
 
+AnalyzerPtr AnalyzerOperation::swap(const AnalyzerPtr &analyzer)
+{
+    Lock lock(thread()->condition());
+
+    AnalyzerPtr previous = _analyzer;
+    _analyzer = analyzer;
+
+    return previous;
+}
+
 bool AnalyzerOperation::init(const std::string &file_name)
 {
-    if (file_name.empty())
+    return init(EventRange(file_name));
+}
+
+bool AnalyzerOperation::init(const EventRange &range)
+{
+    if (range.empty())
         return false;
 
     if (thread())
@@ -152,19 +322,99 @@ bool AnalyzerOperation::init(const std::string &file_name)
             return false;
 
         Lock lock(thread()->condition());
-        _file_name = file_name;
+        _range = range;
     }
     else
     {
-        if (!_file_name.empty())
+        if (!_range.empty())
             return false;
 
-        _file_name = file_name;
+        _range = range;
     }
 
     return true;
 }
 
+uint32_t AnalyzerOperation::eventsLeft() const
+{
+    Lock lock(thread()->condition());
+
+    if (_current.empty()
+            || !_current.isBounded())
+        return 0;
+
+    const uint64_t position = _cursor.load();
+    const uint32_t first = max(cursorEvent(position), _current.first);
+    const uint32_t last = cursorLast(position);
+
+    return last > first ? last - first : 0;
+}
+
+EventRange AnalyzerOperation::steal(const uint32_t &min_events)
+{
+    Lock lock(thread()->condition());
+
+    if (_current.empty()
+            || !_current.isBounded())
+        return EventRange();
+
+    // Events that are already read can not be given away. The analyzer
+    // thread keeps reading while the range is split: retry if the cursor
+    // has moved
+    //
+    for(uint64_t position = _cursor.load(); ; )
+    {
+        const uint32_t first = max(cursorEvent(position), _current.first);
+        const uint32_t last = cursorLast(position);
+        const uint32_t events_left = last > first ? last - first : 0;
+
+        if (2 > events_left
+                || 2 * min_events > events_left)
+            return EventRange();
+
+        const uint32_t middle = first + events_left / 2;
+
+        if (_cursor.compare_exchange_weak(position,
+                    cursor(cursorEvent(position), middle)))
+        {
+            EventRange range(_current.file_name, middle, last);
+            range.bytes = rangeBytes(_current, middle, last);
+
+            _current.last = middle;
+            _current.bytes -= range.bytes;
+
+            return range;
+        }
+    }
+}
+
+EventRange AnalyzerOperation::processedRange() const
+{
+    Lock lock(thread()->condition());
+
+    return _processed;
+}
+
+void AnalyzerOperation::setPredictedLoad(const uint64_t &bytes)
+{
+    _predicted_load = bytes;
+}
+
+uint64_t AnalyzerOperation::predictedLoad() const
+{
+    return _predicted_load;
+}
+
+uint64_t AnalyzerOperation::bytesProcessed() const
+{
+    return _bytes_processed.load(boost::memory_order_relaxed);
+}
+
+double AnalyzerOperation::busyTime() const
+{
+    return _busy_time;
+}
+
 void AnalyzerOperation::run()
 {
     if (!thread()
@@ -172,11 +422,22 @@ void AnalyzerOperation::run()
             || !hasController())
         return;
 
+    using boost::posix_time::microsec_clock;
+    using boost::posix_time::ptime;
+
     for(; isContinue();)
     {
-        // Process file
+        const ptime start = microsec_clock::universal_time();
+
+        // Process file or events decoded by reader threads
         //
-        processFile();
+        if (_queue)
+            processQueue();
+        else
+            processFile();
+
+        _busy_time += (microsec_clock::universal_time() - start)
+            .total_microseconds() / 1e6;
 
         // Start run loop
         //
@@ -190,6 +451,9 @@ void AnalyzerOperation::run()
 
 void AnalyzerOperation::stop()
 {
+    // Lock is necessary not to miss the notification if thread is waiting
+    // for instructions
+    //
     Lock lock(thread()->condition());
 
     _continue = false;
@@ -244,12 +508,17 @@ void AnalyzerOperation::onRunLoopCommand(const uint32_t &command)
 
 uint32_t AnalyzerOperation::eventsProcessed() const
 {
-    return _events_processed;
+    return _events_processed.load(boost::memory_order_relaxed);
+}
+
+uint64_t AnalyzerOperation::totalEventsSize() const
+{
+    return _total_events_size.load(boost::memory_order_relaxed);
 }
 
-uint32_t AnalyzerOperation::totalEventsSize() const
+uint32_t AnalyzerOperation::eventsAllocated() const
 {
-    return _total_events_size;
+    return _events.allocated();
 }
 
 // Privates
@@ -262,16 +531,28 @@ bool AnalyzerOperation::isRunning() const
 
 bool AnalyzerOperation::isContinue() const
 {
-    Lock lock(thread()->condition());
-    
-    return _continue;
+    return _continue.load(boost::memory_order_relaxed);
+}
+
+bool AnalyzerOperation::nextEvent(uint32_t &event)
+{
+    for(uint64_t position = _cursor.load(); ; )
+    {
+        event = cursorEvent(position);
+        if (cursorLast(position) <= event)
+            return false;
+
+        if (_cursor.compare_exchange_weak(position,
+                    cursor(event + 1, cursorLast(position))))
+            return true;
+    }
 }
 
 bool AnalyzerOperation::isFileEmpty() const
 {
     Lock lock(thread()->condition());
 
-    return _file_name.empty();
+    return _range.empty();
 }
 
 bool AnalyzerOperation::hasAnalyzer() const
@@ -292,13 +573,20 @@ AnalyzerOperation::ReaderPtr AnalyzerOperation::createReader()
 {
     Lock lock(thread()->condition());
 
-    ReaderPtr reader(new Reader(_file_name));
+    ReaderPtr reader(new Reader(_range.file_name));
     reader->setDelegate(this);
-    _file_name.clear();
+
+    _current = _range;
+    _range = EventRange();
 
     reader->open();
     if (!reader->isOpen())
         reader.reset();
+    else if (reader->input()->has_events())
+        _current.last = min(_current.last,
+                static_cast<uint32_t>(reader->input()->events()));
+
+    _cursor = cursor(0, reader ? _current.last : 0);
 
     return reader;
 }
@@ -309,19 +597,104 @@ void AnalyzerOperation::processFile()
         return;
 
     ReaderPtr reader = createReader();
-    if (!reader)
-        return;
 
-    for(shared_ptr<Event> event(new Event());
-            isContinue()
-                && reader->read(event);
-            event->Clear())
+    // Input file size is attributed to events evenly: the rest is added
+    // once the range is processed
+    //
+    uint64_t event_bytes = 0;
+    uint64_t range_bytes = 0;
     {
         Lock lock(thread()->condition());
 
-        _analyzer->process(event.get());
+        if (_current.isBounded()
+                && _current.size())
+            event_bytes = _current.bytes / _current.size();
+    }
+
+    if (reader)
+    {
+        // Events are stored sequentially in the file: events in front of
+        // the range are read but not analyzed. The end of the range may be
+        // moved by the Controller at any time if part of the events is
+        // given to another thread.
+        //
+        // Note: the loop does not lock: analyzer is only accessed by this
+        //       thread until it is joined
+        //
+        const uint32_t first = _current.first;
+        uint32_t event_index = 0;
+        shared_ptr<Event> event = _events.get();
+        for(;
+                isContinue()
+                    && nextEvent(event_index)
+                    && reader->read(event);
+                event->Clear())
+        {
+            if (first > event_index)
+                continue;
+
+            _analyzer->process(event.get());
+
+            _events_processed.fetch_add(1, boost::memory_order_relaxed);
+            _total_events_size.fetch_add(event_bytes,
+                    boost::memory_order_relaxed);
+            _bytes_processed.fetch_add(event_bytes,
+                    boost::memory_order_relaxed);
 
-        ++_events_processed;
+            range_bytes += event_bytes;
+        }
+
+        _events.release(event);
+    }
+
+    Lock lock(thread()->condition());
+
+    if (_continue
+            && _current.bytes > range_bytes)
+    {
+        _total_events_size.fetch_add(_current.bytes - range_bytes,
+                boost::memory_order_relaxed);
+        _bytes_processed.fetch_add(_current.bytes - range_bytes,
+                boost::memory_order_relaxed);
+    }
+
+    _processed = _current;
+    _current = EventRange();
+    _cursor = 0;
+}
+
+void AnalyzerOperation::processQueue()
+{
+    // Queue keeps chunks of consecutive events from one file and gives
+    // chunks of the current file first: analyzer is notified only when the
+    // file is changed
+    //
+    EventQueue::InputFilePtr file;
+    for(EventQueue::Item item;
+            isContinue()
+                && _queue->pop(item, file);
+            )
+    {
+        if (file != item.file)
+        {
+            file = item.file;
+
+            _analyzer->onFileOpen(file->file_name, file->input.get());
+        }
+
+        for(EventQueue::Events::const_iterator event = item.events.begin();
+                item.events.end() != event
+                    && isContinue();
+                ++event)
+        {
+            _analyzer->process(event->get());
+
+            _events_processed.fetch_add(1, boost::memory_order_relaxed);
+        }
+
+        _queue->recycle(item.events);
+
+        _total_events_size.fetch_add(item.bytes, boost::memory_order_relaxed);
     }
 }
 
@@ -339,7 +712,7 @@ void AnalyzerOperation::waitForInstructions()
     // notify this thread. Notification should come only after wait on
     // lock (lines below) is issued
     //
-    while(_file_name.empty()
+    while(_range.empty()
             && _continue)
     {
         thread()->condition()->variable()->wait(lock());
@@ -348,90 +721,426 @@ void AnalyzerOperation::waitForInstructions()
 
 
 
-// Thread controller
+// Reader Thread
 //
-ThreadController::ThreadController(const uint32_t &max_threads):
-    _max_threads(min(max_threads ? max_threads : INT_MAX,
-                boost::thread::hardware_concurrency())),
-    _analyzer_is_reader_delegate(false)
+ReaderOperation::ReaderOperation(ThreadController *controller,
+        const EventQueuePtr &queue):
+    _controller(controller),
+    _queue(queue),
+    _continue(true),
+    _files_read(0),
+    _bytes_read(0)
 {
-    _condition.reset(new core::Condition());
-    _input_files.reset(new InputFiles());
-
-    _threads_waiting.reset(new ThreadsFIFO());
+    _thread = 0;
 }
 
-ThreadController::~ThreadController()
+uint32_t ReaderOperation::filesRead() const
 {
-    // Check if any threads are still running and let them finish
-    // before quit application
+    return _files_read;
 }
 
-bsm::core::ConditionPtr ThreadController::condition() const
+uint64_t ReaderOperation::bytesRead() const
 {
-    return _condition;
+    return _bytes_read.load(boost::memory_order_relaxed);
 }
 
-void ThreadController::use(const AnalyzerPtr &analyzer,
-        const bool &is_reader_delegate)
+void ReaderOperation::run()
 {
-    _analyzer = analyzer;
-    _analyzer_is_reader_delegate = is_reader_delegate;
+    if (!_queue)
+        return;
+
+    if (_thread
+            && _controller)
+    {
+        for(EventRange range = _controller->nextInput();
+                isContinue()
+                    && !range.empty();
+                range = _controller->nextInput())
+        {
+            readFile(range);
+
+            ++_files_read;
+            _bytes_read.fetch_add(range.bytes, boost::memory_order_relaxed);
+        }
+    }
+
+    // Analyzer threads will stop once the queue is drained and all
+    // readers are removed
+    //
+    _queue->removeProducer();
 }
 
-bool ThreadController::isAnalyzerReaderDelegate() const
+void ReaderOperation::stop()
 {
-    return _analyzer_is_reader_delegate;
+    _continue = false;
 }
 
-void ThreadController::push(const std::string &file_name)
+void ReaderOperation::onThreadInit(Thread *thread)
 {
-    Lock lock(condition());
+    _thread = thread;
+}
 
-    _input_files->push(file_name);
+// Private
+//
+bool ReaderOperation::isContinue() const
+{
+    return _continue.load(boost::memory_order_relaxed);
 }
 
-void ThreadController::start()
+void ReaderOperation::readFile(const EventRange &range)
 {
-    if (!hasInputFiles()
-            || !hasAnalyzer())
+    Reader reader(range.file_name);
+    reader.open();
+
+    if (!reader.isOpen())
         return;
 
-    _summary.reset(new Summary(_input_files->size()));
+    EventQueue::InputFilePtr file(new EventQueue::InputFile(range.file_name,
+                reader.input()));
 
-    //startKeyboardThread();
+    // Events are queued in chunks: consumers see runs of events from the
+    // same file. Input file size is attributed to events evenly and the
+    // rest goes with the last chunk: full chunk is queued only once the
+    // next event is read
+    //
+    const uint64_t event_bytes = range.isBounded() && range.size()
+        ? range.bytes / range.size()
+        : 0;
+    uint64_t range_bytes = 0;
 
-    for(uint32_t threads_to_create = countMaxThreads();
-            threads_to_create;
-            --threads_to_create)
+    // Events are reused: empty events are taken from the queue for the
+    // whole chunk at once, events that were not queued are returned back
+    //
+    EventQueue::Events events;
+    EventQueue::Item chunk(file);
+    for(uint32_t event_index = 0; ; ++event_index)
     {
-        addThread();
-    }
+        if (events.empty())
+            _queue->events(events, _queue->chunkSize());
 
-    run();
+        EventQueue::EventPtr event = events.back();
+        if (!isContinue()
+                || range.last <= event_index
+                || !reader.read(event))
+            break;
 
-    //stopKeyboardThread();
-    
-    cout << *_summary << endl;
+        // Events in front of the range are read but not queued
+        //
+        if (range.first > event_index)
+        {
+            event->Clear();
 
-    _summary.reset();
-}
+            continue;
+        }
 
-void 
-ThreadController::threadIsWaiting(Thread *thread)
-{
-    _threads_waiting->push(thread);
-}
+        // Block while queue is full
+        //
+        if (_queue->chunkSize() <= chunk.events.size())
+        {
+            if (!_queue->push(chunk))
+            {
+                _queue->recycle(events);
 
-void ThreadController::quit()
-{
-    Lock lock(condition());
+                return;
+            }
 
-    _keyboard_thread->stop();
+            chunk.events.clear();
+            chunk.bytes = 0;
+        }
+
+        events.pop_back();
+
+        chunk.events.push_back(event);
+        chunk.bytes += event_bytes;
+        range_bytes += event_bytes;
+    }
+
+    _queue->recycle(events);
+
+    if (chunk.events.empty())
+        return;
+
+    if (isContinue()
+            && range.bytes > range_bytes)
+        chunk.bytes += range.bytes - range_bytes;
+
+    _queue->push(chunk);
+}
+
+
+
+// Merge Thread
+//
+MergeOperation::MergeOperation(ThreadController *controller,
+        const AnalyzerPtr &analyzer,
+        const AnalyzerPtr &other_analyzer):
+    _controller(controller),
+    _analyzer(analyzer),
+    _other_analyzer(other_analyzer)
+{
+    _thread = 0;
+}
+
+AnalyzerPtr MergeOperation::analyzer() const
+{
+    return _analyzer;
+}
+
+void MergeOperation::run()
+{
+    if (!_thread
+            || !_controller)
+        return;
+
+    _analyzer->merge(_other_analyzer);
+    _other_analyzer.reset();
+
+    Lock lock(_controller->condition());
+
+    _controller->mergeIsDone(_thread);
+    _controller->condition()->variable()->notify_all();
+}
+
+void MergeOperation::stop()
+{
+    // Merge can not be interrupted
+}
+
+void MergeOperation::onThreadInit(Thread *thread)
+{
+    _thread = thread;
+}
+
+
+
+// Thread controller
+//
+ThreadController::Sample::Sample():
+    id(0),
+    events(0),
+    events_size(0)
+{
+}
+
+ThreadController::ThreadController(const uint32_t &max_threads):
+    _max_threads(min(max_threads ? max_threads : INT_MAX,
+                boost::thread::hardware_concurrency())),
+    _min_range_size(1000),
+    _readers(0),
+    _queue_depth(0),
+    _input_bytes(0),
+    _stats_period(0),
+    _stats_threads(0),
+    _analyzer_is_reader_delegate(false),
+    _snapshot_delegate(0),
+    _snapshot_files(0),
+    _snapshot_pending(0)
+{
+    _condition.reset(new core::Condition());
+    _input_files.reset(new InputFiles());
+
+    _threads_waiting.reset(new ThreadsFIFO());
+    _merges_done.reset(new ThreadsFIFO());
+}
+
+ThreadController::~ThreadController()
+{
+    // Check if any threads are still running and let them finish
+    // before quit application
+}
+
+bsm::core::ConditionPtr ThreadController::condition() const
+{
+    return _condition;
+}
+
+void ThreadController::use(const AnalyzerPtr &analyzer,
+        const bool &is_reader_delegate)
+{
+    _analyzer = analyzer;
+    _analyzer_is_reader_delegate = is_reader_delegate;
+}
+
+bool ThreadController::isAnalyzerReaderDelegate() const
+{
+    return _analyzer_is_reader_delegate;
+}
+
+void ThreadController::usePipeline(const uint32_t &readers,
+        const uint32_t &queue_depth)
+{
+    _readers = readers;
+    _queue_depth = queue_depth;
+}
+
+bool ThreadController::isPipeline() const
+{
+    return _readers;
+}
+
+void ThreadController::useSnapshots(SnapshotDelegate *delegate,
+        const uint32_t &files,
+        const AnalyzerPtr &state)
+{
+    _snapshot_delegate = delegate;
+    _snapshot_files = files;
+    _snapshot = state;
+}
+
+bool ThreadController::isSnapshots() const
+{
+    return _snapshot_delegate;
+}
+
+void ThreadController::push(const std::string &file_name)
+{
+    Lock lock(condition());
+
+    _input_files->push_back(EventRange(file_name));
+}
+
+void ThreadController::push(const EventRange &range)
+{
+    Lock lock(condition());
+
+    _input_files->push_back(range);
+}
+
+EventRange ThreadController::nextInput()
+{
+    Lock lock(condition());
+
+    if (_input_files->empty())
+        return EventRange();
+
+    const EventRange range(_input_files->front());
+    _input_files->pop_front();
+
+    return range;
+}
+
+void ThreadController::start()
+{
+    if (!hasInputFiles()
+            || !hasAnalyzer())
+        return;
+
+    _summary.reset(new Summary(_input_files->size()));
+
+    sortInputs();
+
+    // Reader delegates, e.g. filter, keep output per input file: files
+    // can not be split between threads or mixed in the events queue
+    //
+    if (isPipeline()
+            && isAnalyzerReaderDelegate())
+        clog << "pipeline is not supported by the analyzer" << endl;
+
+    // Events of different files are mixed in the queue: state of the
+    // processed files can not be taken from the analyzer threads
+    //
+    if (isPipeline()
+            && isSnapshots())
+        clog << "pipeline is not supported with snapshots" << endl;
+
+    if (isPipeline()
+            && !isAnalyzerReaderDelegate()
+            && !isSnapshots())
+    {
+        _queue.reset(new EventQueue(_queue_depth));
+
+        for(uint32_t readers = min(_readers,
+                    static_cast<uint32_t>(_input_files->size()));
+                readers;
+                --readers)
+        {
+            addReaderThread();
+        }
+    }
+    else if (!isAnalyzerReaderDelegate())
+        splitInputs();
+
+    // Analyzer threads share the events queue in pipeline mode: the load
+    // is not planned
+    //
+    if (!_queue)
+        planLoad();
+
+    if (isSnapshots())
+    {
+        if (!_snapshot)
+            _snapshot = boost::dynamic_pointer_cast<Analyzer>(
+                    _analyzer->clone());
+
+        for(InputFiles::const_iterator range = _input_files->begin();
+                _input_files->end() != range;
+                ++range)
+        {
+            ++_ranges_left[range->file_name];
+        }
+    }
+
+    //startKeyboardThread();
+
+    if (!_stats_file.empty())
+        startStatsThread();
+
+    for(uint32_t threads_to_create = countMaxThreads();
+            threads_to_create;
+            --threads_to_create)
+    {
+        addThread();
+    }
+
+    run();
+
+    if (_stats_thread)
+        stopStatsThread();
+
+    joinReaderThreads();
+
+    if (_queue)
+        _summary->addEventsAllocated(_queue->eventsAllocated());
+
+    _queue.reset();
+
+    //stopKeyboardThread();
+    
+    cout << *_summary << endl;
+
+    _summary.reset();
+}
+
+void 
+ThreadController::threadIsWaiting(Thread *thread)
+{
+    _threads_waiting->push(thread);
+}
+
+void ThreadController::mergeIsDone(Thread *thread)
+{
+    _merges_done->push(thread);
+}
+
+void ThreadController::quit()
+{
+    Lock lock(condition());
+
+    _keyboard_thread->stop();
+
+    if (_queue)
+        _queue->close();
+
+    for(Threads::iterator thread = _reader_threads.begin();
+            _reader_threads.end() != thread;
+            ++thread)
+    {
+        thread->first->stop();
+    }
 
     while(!_input_files->empty())
     {
-        _input_files->pop();
+        _input_files->pop_front();
     }
 
     for(Threads::iterator thread = _threads.begin();
@@ -452,6 +1161,146 @@ void ThreadController::info()
     cout << endl;
 }
 
+void ThreadController::useStats(const std::string &file_name,
+        const uint32_t &period)
+{
+    _stats_file = file_name;
+    _stats_period = period;
+}
+
+void ThreadController::writeStats()
+{
+    using boost::dynamic_pointer_cast;
+    using boost::posix_time::microsec_clock;
+    using boost::posix_time::ptime;
+
+    Lock lock(condition());
+
+    if (!_summary)
+        return;
+
+    const ptime now = microsec_clock::universal_time();
+    const double elapsed = (now - _start_time).total_microseconds() / 1e6;
+    const double period = (now - _stats_time).total_microseconds() / 1e6;
+
+    _stats_time = now;
+
+    // Counters of joined threads are already added to the summary
+    //
+    uint64_t events = _summary->eventsProcessed();
+    uint64_t events_size = _summary->totalEventsSize();
+    uint64_t bytes = 0;
+    for(Summary::ThreadLoads::const_iterator load =
+                _summary->threadLoads().begin();
+            _summary->threadLoads().end() != load;
+            ++load)
+    {
+        bytes += load->processed_bytes;
+    }
+
+    ostringstream threads;
+    Samples samples;
+    for(Threads::const_iterator thread = _threads.begin();
+            _threads.end() != thread;
+            ++thread)
+    {
+        AnalyzerOperationPtr operation =
+            dynamic_pointer_cast<AnalyzerOperation>(thread->first->operation());
+
+        if (!operation)
+            continue;
+
+        Samples::iterator last_sample = _stats_samples.find(thread->first);
+
+        Sample sample;
+        if (_stats_samples.end() != last_sample)
+            sample = last_sample->second;
+        else
+            sample.id = _stats_threads++;
+
+        const uint64_t thread_events = operation->eventsProcessed();
+        const uint64_t thread_events_size = operation->totalEventsSize();
+
+        threads << (samples.empty() ? "" : ",") << endl
+            << "    {\"id\": " << sample.id
+            << ", \"events\": " << thread_events
+            << ", \"events_per_second\": " << (period > 0
+                    ? (thread_events - sample.events) / period
+                    : 0)
+            << ", \"bytes_per_second\": " << (period > 0
+                    ? (thread_events_size - sample.events_size) / period
+                    : 0)
+            << "}";
+
+        events += thread_events;
+        events_size += thread_events_size;
+        bytes += operation->bytesProcessed();
+
+        sample.events = thread_events;
+        sample.events_size = thread_events_size;
+
+        samples[thread->first] = sample;
+    }
+
+    // Samples of finished threads are dropped
+    //
+    _stats_samples.swap(samples);
+
+    // Reader threads own input files in pipeline mode
+    //
+    for(Threads::const_iterator thread = _reader_threads.begin();
+            _reader_threads.end() != thread;
+            ++thread)
+    {
+        ReaderOperationPtr operation =
+            dynamic_pointer_cast<ReaderOperation>(thread->first->operation());
+
+        if (operation)
+            bytes += operation->bytesRead();
+    }
+
+    const double bytes_rate = elapsed > 0 ? bytes / elapsed : 0;
+    const double eta = bytes_rate > 0 && _input_bytes > bytes
+        ? (_input_bytes - bytes) / bytes_rate
+        : 0;
+
+    // Write into temporary file first: readers never see partial stats
+    //
+    const string tmp_file = _stats_file + ".tmp";
+    {
+        ofstream out(tmp_file.c_str());
+        if (!out)
+        {
+            cerr << "failed to write stats: " << tmp_file << endl;
+
+            return;
+        }
+
+        out << "{" << endl
+            << "  \"time\": " << elapsed << "," << endl
+            << "  \"events\": " << events << "," << endl
+            << "  \"events_per_second\": "
+                << (elapsed > 0 ? events / elapsed : 0) << "," << endl
+            << "  \"bytes_per_second\": "
+                << (elapsed > 0 ? events_size / elapsed : 0) << "," << endl
+            << "  \"input_bytes\": " << bytes << "," << endl
+            << "  \"input_bytes_total\": " << _input_bytes << "," << endl
+            << "  \"queue_size\": " << (_queue ? _queue->size() : 0)
+                << "," << endl
+            << "  \"queue_depth\": " << (_queue ? _queue->depth() : 0)
+                << "," << endl
+            << "  \"eta\": " << eta << "," << endl
+            << "  \"threads\": [" << threads.str() << endl
+            << "  ]" << endl
+            << "}" << endl;
+    }
+
+    boost::system::error_code error;
+    fs::rename(tmp_file, _stats_file, error);
+    if (error)
+        cerr << "failed to write stats: " << _stats_file << endl;
+}
+
 // Private
 //
 bool ThreadController::hasInputFiles() const
@@ -472,9 +1321,146 @@ uint32_t ThreadController::countMaxThreads()
 {
     Lock lock(condition());
 
+    // All analyzer threads share the same queue in pipeline mode
+    //
+    if (_queue)
+        return _max_threads;
+
     return min(_max_threads, static_cast<uint32_t>(_input_files->size()));
 }
 
+void ThreadController::sortInputs()
+{
+    Lock lock(condition());
+
+    for(InputFiles::iterator range = _input_files->begin();
+            _input_files->end() != range;
+            ++range)
+    {
+        // Size of the scheduled events range is known
+        //
+        if (!range->bytes)
+        {
+            boost::system::error_code error;
+            const boost::uintmax_t bytes = fs::file_size(range->file_name,
+                    error);
+
+            range->bytes = error ? 0 : bytes;
+        }
+
+        _input_bytes += range->bytes;
+    }
+
+    stable_sort(_input_files->begin(), _input_files->end(), eventRangeLonger);
+}
+
+void ThreadController::splitInputs()
+{
+    Lock lock(condition());
+
+    if (_input_files->size() >= _max_threads)
+        return;
+
+    // Get number of events from the file header
+    //
+    for(InputFiles::iterator range = _input_files->begin();
+            _input_files->end() != range;
+            ++range)
+    {
+        Reader reader(range->file_name);
+        reader.open();
+
+        if (reader.isOpen()
+                && reader.input()->has_events())
+            range->last = min(range->last,
+                    static_cast<uint32_t>(reader.input()->events()));
+    }
+
+    // Split the largest range in halves until all threads are busy
+    //
+    while(_input_files->size() < _max_threads)
+    {
+        InputFiles::iterator largest = max_element(_input_files->begin(),
+                _input_files->end(),
+                eventRangeLess);
+
+        if (!largest->isBounded()
+                || 2 * _min_range_size > largest->size())
+            break;
+
+        const uint32_t middle = largest->first + largest->size() / 2;
+
+        EventRange range(largest->file_name, middle, largest->last);
+        range.bytes = rangeBytes(*largest, middle, largest->last);
+
+        largest->last = middle;
+        largest->bytes -= range.bytes;
+
+        _input_files->push_back(range);
+    }
+
+    stable_sort(_input_files->begin(), _input_files->end(), eventRangeLonger);
+}
+
+void ThreadController::planLoad()
+{
+    const uint32_t threads = countMaxThreads();
+
+    Lock lock(condition());
+
+    // Every range goes to the least loaded thread
+    //
+    _predicted_load.assign(threads, 0);
+    for(InputFiles::const_iterator range = _input_files->begin();
+            _input_files->end() != range
+                && threads;
+            ++range)
+    {
+        *min_element(_predicted_load.begin(), _predicted_load.end())
+            += range->bytes;
+    }
+}
+
+EventRange ThreadController::steal(Thread *thief)
+{
+    using boost::dynamic_pointer_cast;
+
+    // Find thread with the largest number of events left
+    //
+    AnalyzerOperationPtr victim;
+    uint32_t max_events_left = 0;
+    for(Threads::const_iterator thread = _threads.begin();
+            _threads.end() != thread;
+            ++thread)
+    {
+        if (thief == thread->first)
+            continue;
+
+        AnalyzerOperationPtr operation =
+            dynamic_pointer_cast<AnalyzerOperation>(thread->first->operation());
+
+        if (!operation)
+            continue;
+
+        const uint32_t events_left = operation->eventsLeft();
+        if (events_left > max_events_left)
+        {
+            max_events_left = events_left;
+            victim = operation;
+        }
+    }
+
+    if (!victim)
+        return EventRange();
+
+    const EventRange range = victim->steal(_min_range_size);
+    if (isSnapshots()
+            && !range.empty())
+        ++_ranges_left[range.file_name];
+
+    return range;
+}
+
 void ThreadController::addThread()
 {
     ThreadPtr thread(new Thread());
@@ -483,11 +1469,19 @@ void ThreadController::addThread()
 
     operation->use(this);
 
-    instruct(operation.get());
+    if (_queue)
+        operation->use(_queue);
+    else
+        instruct(operation.get());
 
     {
         Lock lock(condition());
 
+        // Threads are instructed in the same order as ranges are planned
+        //
+        if (_threads.size() < _predicted_load.size())
+            operation->setPredictedLoad(_predicted_load[_threads.size()]);
+
         AnalyzerPtr analyzer_clone =
             boost::dynamic_pointer_cast<Analyzer>(_analyzer->clone());
         operation->use(analyzer_clone);
@@ -507,14 +1501,57 @@ void ThreadController::addThread()
     thread->start();
 }
 
+void ThreadController::addReaderThread()
+{
+    ThreadPtr thread(new Thread());
+    ReaderOperationPtr operation(new ReaderOperation(this, _queue));
+    thread->init(operation);
+
+    // Queue should not be drained before reader starts
+    //
+    _queue->addProducer();
+
+    {
+        Lock lock(condition());
+
+        _reader_threads[thread.get()] = thread;
+    }
+
+    thread->start();
+}
+
+void ThreadController::joinReaderThreads()
+{
+    using boost::dynamic_pointer_cast;
+
+    for(Threads::iterator thread = _reader_threads.begin();
+            _reader_threads.end() != thread;
+            ++thread)
+    {
+        thread->first->join();
+
+        ReaderOperationPtr operation =
+            dynamic_pointer_cast<ReaderOperation>(thread->first->operation());
+
+        if (!operation)
+            continue;
+
+        for(uint32_t files = operation->filesRead(); files; --files)
+            _summary->addFilesProcessed();
+    }
+
+    Lock lock(condition());
+    _reader_threads.clear();
+}
+
 void ThreadController::instruct(AnalyzerOperation *operation)
 {
     Lock lock(condition());
 
-    const std::string input_file(_input_files->front());
-    _input_files->pop();
+    const EventRange range(_input_files->front());
+    _input_files->pop_front();
 
-    operation->init(input_file);
+    operation->init(range);
 }
 
 void ThreadController::run()
@@ -525,9 +1562,31 @@ void ThreadController::run()
         //
         wait();
 
+        // Collect merged analyzers
+        //
+        onMergeDone();
+
         // Process waiting threads
         //
-        onThreadWait();
+        if (hasWaitingThreads())
+            onThreadWait();
+    }
+
+    // At most one analyzer is left after all merges are done
+    //
+    if (!_analyzers_to_merge.empty())
+    {
+        _analyzer->merge(_analyzers_to_merge.top());
+        _analyzers_to_merge.pop();
+    }
+
+    if (isSnapshots())
+    {
+        if (_snapshot_pending)
+            snapshot();
+
+        _analyzer->merge(_snapshot);
+        _snapshot.reset();
     }
 }
 
@@ -535,7 +1594,8 @@ void ThreadController::wait()
 {
     Lock lock(condition());
 
-    while(_threads_waiting->empty())
+    while(_threads_waiting->empty()
+            && _merges_done->empty())
     {
         condition()->variable()->wait(lock());
     }
@@ -545,34 +1605,60 @@ bool ThreadController::isRunning() const
 {
     Lock lock(condition());
 
-    return !_threads.empty();
+    return !_threads.empty()
+        || !_merge_threads.empty();
+}
+
+bool ThreadController::hasWaitingThreads() const
+{
+    Lock lock(condition());
+
+    return !_threads_waiting->empty();
 }
 
 void ThreadController::onThreadWait()
 {
     using boost::dynamic_pointer_cast;
 
-    _summary->addFilesProcessed();
+    Thread *thread = waitingThread();
+    AnalyzerOperationPtr operation = 
+        dynamic_pointer_cast<AnalyzerOperation>(thread->operation());
+
+    // Only the first range of the file starts with event 0: stolen ranges
+    // are not counted. Reader threads count files in pipeline mode
+    //
+    if (!_queue
+            && (!operation
+                || !operation->processedRange().first))
+        _summary->addFilesProcessed();
+
+    if (operation
+            && isSnapshots())
+        onRangeDone(operation.get());
 
-    if (hasInputFiles())
+    if (!_queue
+            && hasInputFiles())
     {
         // More input files left
         //
-        Thread *thread = waitingThread();
-        AnalyzerOperationPtr operation = 
-            dynamic_pointer_cast<AnalyzerOperation>(thread->operation());
-        
         if (operation)
             instruct(operation.get());
 
         thread->condition()->variable()->notify_all();
     }
+    else if (operation
+            && !_queue
+            && !isAnalyzerReaderDelegate()
+            && operation->init(steal(thread)))
+    {
+        // Thread took over part of the events from the busiest thread
+        //
+        thread->condition()->variable()->notify_all();
+    }
     else
     {
         // Stop thread
         //
-        Thread *thread = waitingThread();
-
         thread->stop();
         thread->condition()->variable()->notify_all();
 
@@ -580,21 +1666,34 @@ void ThreadController::onThreadWait()
         //
         thread->join();
 
-        AnalyzerOperationPtr operation =
-            dynamic_pointer_cast<AnalyzerOperation>(thread->operation());
+        // Analyzer of the last range is already given to the snapshot
+        //
+        if (operation
+                && !isSnapshots())
+            reduce(operation->analyzer());
+
+        // Summary and the list of running threads are updated at once:
+        // stats are collected from both
+        //
+        Lock lock(condition());
 
         if (operation)
         {
-            _analyzer->merge(operation->analyzer());
-
-            Lock lock(condition());
             _summary->addEventsProcessed(operation->eventsProcessed());
             _summary->addEventsSize(operation->totalEventsSize());
+            _summary->addEventsAllocated(operation->eventsAllocated());
+
+            Summary::ThreadLoad load;
+            load.predicted_bytes = operation->predictedLoad();
+            load.processed_bytes = operation->bytesProcessed();
+            load.events = operation->eventsProcessed();
+            load.busy_time = operation->busyTime();
+
+            _summary->addThreadLoad(load);
         }
 
         // Remove thread form the list of running threads
         //
-        Lock lock(condition());
         _threads.erase(thread);
     }
 }
@@ -608,6 +1707,102 @@ Thread *ThreadController::waitingThread()
     return thread;
 }
 
+void ThreadController::reduce(const AnalyzerPtr &analyzer)
+{
+    _analyzers_to_merge.push(analyzer);
+
+    // Merge analyzers pairwise
+    //
+    while(1 < _analyzers_to_merge.size())
+    {
+        AnalyzerPtr left = _analyzers_to_merge.top();
+        _analyzers_to_merge.pop();
+
+        AnalyzerPtr right = _analyzers_to_merge.top();
+        _analyzers_to_merge.pop();
+
+        ThreadPtr thread(new Thread());
+        MergeOperationPtr operation(new MergeOperation(this, left, right));
+        thread->init(operation);
+
+        {
+            Lock lock(condition());
+
+            _merge_threads[thread.get()] = thread;
+        }
+
+        thread->start();
+    }
+}
+
+void ThreadController::onMergeDone()
+{
+    using boost::dynamic_pointer_cast;
+
+    for(;;)
+    {
+        Thread *thread = 0;
+        {
+            Lock lock(condition());
+
+            if (_merges_done->empty())
+                break;
+
+            thread = _merges_done->front();
+            _merges_done->pop();
+        }
+
+        thread->join();
+
+        MergeOperationPtr operation =
+            dynamic_pointer_cast<MergeOperation>(thread->operation());
+
+        if (operation)
+            reduce(operation->analyzer());
+
+        Lock lock(condition());
+        _merge_threads.erase(thread);
+    }
+}
+
+void ThreadController::onRangeDone(AnalyzerOperation *operation)
+{
+    const string file_name = operation->processedRange().file_name;
+
+    // Thread continues with a new analyzer
+    //
+    _range_analyzers.insert(make_pair(file_name,
+                operation->swap(boost::dynamic_pointer_cast<Analyzer>(
+                        _analyzer->clone()))));
+
+    RangesLeft::iterator ranges = _ranges_left.find(file_name);
+    if (_ranges_left.end() == ranges
+            || --ranges->second)
+        return;
+
+    _ranges_left.erase(ranges);
+
+    for(RangeAnalyzers::iterator analyzer =
+                _range_analyzers.lower_bound(file_name);
+            _range_analyzers.end() != analyzer
+                && file_name == analyzer->first;
+            )
+    {
+        _snapshot->merge(analyzer->second);
+        _range_analyzers.erase(analyzer++);
+    }
+
+    _snapshot_inputs.push_back(file_name);
+    if (_snapshot_files <= ++_snapshot_pending)
+        snapshot();
+}
+
+void ThreadController::snapshot()
+{
+    _snapshot_delegate->onSnapshot(_snapshot, _snapshot_inputs);
+    _snapshot_pending = 0;
+}
+
 void ThreadController::startKeyboardThread()
 {
     Lock lock(condition());
@@ -625,3 +1820,29 @@ void ThreadController::stopKeyboardThread()
     _keyboard_thread->stop();
     _keyboard_thread->join();
 }
+
+void ThreadController::startStatsThread()
+{
+    Lock lock(condition());
+
+    _stats_thread.reset(new Thread());
+    StatsOperationPtr operation(new StatsOperation(this, _stats_period));
+    _stats_thread->init(operation);
+
+    _start_time = boost::posix_time::microsec_clock::universal_time();
+    _stats_time = _start_time;
+
+    _stats_thread->start();
+}
+
+void ThreadController::stopStatsThread()
+{
+    _stats_thread->stop();
+    _stats_thread->join();
+
+    // The last sample shows the job is done
+    //
+    writeStats();
+
+    _stats_thread.reset();
+}
@@ -0,0 +1,101 @@
+// Top-tag by weight: every CA jet is top-tagged with pT dependent
+// probability. Event weight is the probability of the tagged jets
+// multiplicity: at least one tag or exactly k tags
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <cmath>
+
+#include "bsm_input/interface/Algebra.h"
+#include "bsm_input/interface/Physics.pb.h"
+#include "interface/ToptagWeight.h"
+
+using namespace std;
+
+using bsm::ToptagWeight;
+
+ToptagWeight::ToptagWeight():
+    _at_least_one(0)
+{
+}
+
+float ToptagWeight::probability(const float &x)
+{
+    float p0 = 5.40683e-02;
+    float p1 = 4.48390e+02;
+    float p2 = 2.76646e-02;
+    float p3 = 1.85887e-06;
+
+    return p0/(1+exp(-p2*(x-p1)-p3*pow(x-p1,3)));
+}
+
+void ToptagWeight::clear()
+{
+    _probabilities.clear();
+    _multiplicity.clear();
+    _at_least_one = 0;
+}
+
+void ToptagWeight::add(const float &probability)
+{
+    _probabilities.push_back(probability);
+    _multiplicity.clear();
+
+    // Either one of the previous jets is tagged or only the new one: sum
+    // of positive terms does not lose precision for small probabilities
+    //
+    _at_least_one += probability * (1 - _at_least_one);
+}
+
+void ToptagWeight::add(const Jets &jets)
+{
+    _probabilities.reserve(_probabilities.size() + jets.size());
+
+    for(Jets::const_iterator jet = jets.begin(); jets.end() != jet; ++jet)
+        add(probability(pt(*jet->corrected_p4)));
+}
+
+uint32_t ToptagWeight::size() const
+{
+    return _probabilities.size();
+}
+
+float ToptagWeight::atLeastOne() const
+{
+    return _at_least_one;
+}
+
+float ToptagWeight::exactly(const uint32_t &tags) const
+{
+    if (tags > _probabilities.size())
+        return 0;
+
+    if (_multiplicity.empty())
+    {
+        // Add jets one by one: k tags are found if k tags were found
+        // before and the jet is not tagged or k - 1 tags were found and
+        // the jet is tagged
+        //
+        _multiplicity.resize(_probabilities.size() + 1, 0);
+        _multiplicity[0] = 1;
+
+        uint32_t jets = 0;
+        for(Probabilities::const_iterator probability =
+                    _probabilities.begin();
+                _probabilities.end() != probability;
+                ++probability)
+        {
+            ++jets;
+            for(uint32_t k = jets; 0 < k; --k)
+            {
+                _multiplicity[k] = _multiplicity[k] * (1 - *probability)
+                    + _multiplicity[k - 1] * *probability;
+            }
+
+            _multiplicity[0] *= 1 - *probability;
+        }
+    }
+
+    return _multiplicity[tags];
+}
@@ -121,8 +121,21 @@ TriggerAnalyzer::TriggerAnalyzer()
 {
 }
 
+TriggerAnalyzer::TriggerAnalyzer(const TriggerAnalyzer &object):
+    _hlt_map(object._hlt_map),
+    _hlt_cutflow(object._hlt_cutflow)
+{
+}
+
 void TriggerAnalyzer::onFileOpen(const std::string &filename, const Input *input)
 {
+    // Positions of triggers in the event HLT list follow the file menu
+    //
+    _hlt_counters.assign(input->has_info()
+            ? input->info().trigger().path().size()
+            : 0,
+            _hlt_cutflow.end());
+
     if (!input->has_info())
     {
         clog << "event info is not available" << endl;
@@ -160,15 +173,92 @@ void TriggerAnalyzer::process(const Event *event)
         return;
     }
 
-    for(Triggers::const_iterator hlt = event->hlt().trigger().begin();
-            event->hlt().trigger().end() != hlt;
+    const Triggers &hlts = event->hlt().trigger();
+    if (_hlt_counters.size() < static_cast<uint32_t>(hlts.size()))
+        _hlt_counters.resize(hlts.size(), _hlt_cutflow.end());
+
+    for(int position = 0; hlts.size() > position; ++position)
+    {
+        const Trigger &hlt = hlts.Get(position);
+
+        HLTCutflow::iterator &counter = _hlt_counters[position];
+        if (_hlt_cutflow.end() == counter
+                || counter->first.hash() != hlt.hash()
+                || counter->first.version() != hlt.version()
+                || counter->first.prescale() != hlt.prescale())
+            counter = _hlt_cutflow.insert(make_pair(hlt, 0)).first;
+
+        if (hlt.pass())
+            ++counter->second;
+    }
+}
+
+// Checkpoint: HLT names and cutflow are saved as
+//
+//      hlts
+//      hash name_length name
+//      ...
+//      triggers
+//      trigger_length serialized_trigger counts
+//      ...
+//
+void TriggerAnalyzer::save(std::ostream &out) const
+{
+    out << _hlt_map.size() << endl;
+    for(HLTMap::const_iterator hlt = _hlt_map.begin();
+            _hlt_map.end() != hlt;
             ++hlt)
     {
-        if (hlt->pass())
-            ++_hlt_cutflow[*hlt];
-        else
-            _hlt_cutflow[*hlt];
+        out << hlt->first << " ";
+        saveString(out, hlt->second);
+        out << endl;
     }
+
+    out << _hlt_cutflow.size() << endl;
+    for(HLTCutflow::const_iterator hlt = _hlt_cutflow.begin();
+            _hlt_cutflow.end() != hlt;
+            ++hlt)
+    {
+        saveString(out, hlt->first.SerializeAsString());
+        out << " " << hlt->second << endl;
+    }
+}
+
+bool TriggerAnalyzer::load(std::istream &in)
+{
+    HLTMap::size_type hlts = 0;
+    if (!(in >> hlts))
+        return false;
+
+    for(; hlts; --hlts)
+    {
+        HLTMap::key_type hash = 0;
+        string name;
+        if (!(in >> hash)
+                || !loadString(in, name))
+            return false;
+
+        _hlt_map[hash] = name;
+    }
+
+    HLTCutflow::size_type triggers = 0;
+    if (!(in >> triggers))
+        return false;
+
+    for(; triggers; --triggers)
+    {
+        string buffer;
+        uint32_t counts = 0;
+        Trigger trigger;
+        if (!loadString(in, buffer)
+                || !trigger.ParseFromString(buffer)
+                || !(in >> counts))
+            return false;
+
+        _hlt_cutflow[trigger] += counts;
+    }
+
+    return true;
 }
 
 uint32_t TriggerAnalyzer::id() const
@@ -14,6 +14,7 @@
 #include "bsm_input/interface/Algebra.h"
 #include "bsm_input/interface/Physics.pb.h"
 #include "interface/CorrectedJet.h"
+#include "interface/EventPool.h"
 #include "interface/Utility.h"
 
 using namespace std;
@@ -21,12 +22,22 @@ using namespace std;
 using namespace bsm::utility;
 using namespace bsm;
 
+Summary::ThreadLoad::ThreadLoad():
+    predicted_bytes(0),
+    processed_bytes(0),
+    events(0),
+    busy_time(0)
+{
+}
+
 Summary:: Summary(const uint32_t &files_total):
     _events_processed(0),
     _files_total(files_total),
     _files_processed(0),
     _total_events_size(0),
-    _percent_done(0)
+    _percent_done(0),
+    _events_allocated(0),
+    _allocations(allocation::count())
 {
 }
 
@@ -43,12 +54,47 @@ void Summary::addFilesProcessed()
     }
 }
 
+double Summary::allocationsPerEvent() const
+{
+    return eventsProcessed()
+        ? 1.0 * (allocation::count() - _allocations) / eventsProcessed()
+        : 0;
+}
+
 ostream &bsm::operator <<(ostream &out, const Summary &summary)
 {
     out << "Job Summary" << endl;
     out << "  Processed Events: " << summary.eventsProcessed() << endl;
     out << "  Processed  Files: " << summary.filesProcessed() << endl;
-    out << "Average Event Size: " << summary.averageEventSize();
+    out << "Average Event Size: " << summary.averageEventSize() << endl;
+    out << "  Allocated Events: " << summary.eventsAllocated();
+
+    if (allocation::isCounted())
+        out << endl << " Allocations/Event: " << summary.allocationsPerEvent();
+
+    if (summary.threadLoads().empty())
+        return out;
+
+    out << endl << endl;
+    out << "Thread Load" << endl;
+    out << "  " << setw(6) << "thread"
+        << " " << setw(14) << "predicted, MB"
+        << " " << setw(14) << "processed, MB"
+        << " " << setw(10) << "events"
+        << " " << setw(10) << "busy, s";
+
+    const uint32_t megabyte = 1 << 20;
+    for(Summary::ThreadLoads::const_iterator load =
+                summary.threadLoads().begin();
+            summary.threadLoads().end() != load;
+            ++load)
+    {
+        out << endl << "  " << setw(6) << (load - summary.threadLoads().begin())
+            << " " << setw(14) << load->predicted_bytes / megabyte
+            << " " << setw(14) << load->processed_bytes / megabyte
+            << " " << setw(10) << load->events
+            << " " << setw(10) << load->busy_time;
+    }
 
     return out;
 }
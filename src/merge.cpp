@@ -0,0 +1,142 @@
+// Merge partial results of the sharded jobs (see --shard option) and
+// produce the final table. Merged result can be saved and merged again.
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/pointer_cast.hpp>
+#include <boost/program_options.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "bsm_input/interface/Event.pb.h"
+#include "interface/Checkpoint.h"
+#include "interface/PartialMerger.h"
+#include "interface/TriggerAnalyzer.h"
+
+using namespace std;
+
+using boost::dynamic_pointer_cast;
+using boost::shared_ptr;
+
+namespace po = boost::program_options;
+
+using bsm::Checkpoint;
+using bsm::CheckpointDelegate;
+using bsm::PartialMerger;
+using bsm::TriggerAnalyzer;
+
+int main(int argc, char *argv[])
+{
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    bool result = false;
+    try
+    {
+        typedef vector<string> Inputs;
+
+        po::options_description options("Merge Options");
+        options.add_options()
+            ("help,h",
+             "Help message")
+
+            ("analyzer",
+             po::value<string>()->default_value("trigger"),
+             "Analyzer of the partial results: trigger")
+
+            ("multi-thread",
+             po::value<uint32_t>()->default_value(0),
+             "Load partial results in threads: 0 - auto, otherwise max number of threads")
+
+            ("output",
+             po::value<string>(),
+             "Save merged result in file")
+        ;
+
+        po::options_description hidden_options("Hidden Options");
+        hidden_options.add_options()
+            ("input",
+             po::value<Inputs>(),
+             "partial result file(s)")
+        ;
+
+        po::options_description cmdline_options;
+        cmdline_options.add(options).add(hidden_options);
+
+        po::positional_options_description positional_options;
+        positional_options.add("input", -1);
+
+        po::variables_map arguments;
+        po::store(po::command_line_parser(argc, argv).
+                options(cmdline_options).
+                positional(positional_options).
+                run(),
+                arguments);
+        po::notify(arguments);
+
+        if (arguments.count("help")
+                || !arguments.count("input"))
+        {
+            cout << "usage: " << argv[0] << " [options] partial.bsm ..."
+                << endl << endl;
+            cout << options << endl;
+        }
+        else
+        {
+            // Only analyzers that implement CheckpointDelegate can be
+            // merged
+            //
+            PartialMerger::AnalyzerPtr analyzer;
+
+            const string name = arguments["analyzer"].as<string>();
+            if ("trigger" == name)
+                analyzer.reset(new TriggerAnalyzer());
+            else
+                throw runtime_error("unsupported analyzer: " + name);
+
+            const Inputs partials = arguments["input"].as<Inputs>();
+
+            PartialMerger merger(analyzer,
+                    arguments["multi-thread"].as<uint32_t>());
+
+            result = merger.merge(partials);
+
+            clog << partials.size() << " partial results are merged: "
+                << merger.processed().size() << " input files" << endl;
+            clog << endl;
+
+            cout << *merger.analyzer() << endl;
+
+            if (arguments.count("output")
+                    && !Checkpoint(arguments["output"].as<string>()).save(
+                        merger.processed(),
+                        *dynamic_pointer_cast<CheckpointDelegate>(
+                            merger.analyzer())))
+                result = false;
+        }
+    }
+    catch(const exception &error)
+    {
+        cerr << error.what() << endl;
+
+        result = false;
+    }
+    catch(...)
+    {
+        cerr << "Unknown error" << endl;
+
+        result = false;
+    }
+
+    // Clean Up any memory allocated by libprotobuf
+    //
+    google::protobuf::ShutdownProtobufLibrary();
+
+    return result
+        ? 0
+        : 1;
+}
@@ -20,6 +20,7 @@
 #include "interface/AppController.h"
 #include "interface/Btag.h"
 #include "interface/Cut2DSelector.h"
+#include "interface/HistogramBookkeeper.h"
 #include "interface/JetEnergyCorrections.h"
 #include "interface/MonitorCanvas.h"
 #include "interface/Pileup.h"
@@ -332,6 +333,9 @@ int main(int argc, char *argv[])
                 njet2_dr_lepton_jet1_after_reconstruction->Write();
                 njet2_dr_lepton_jet2_after_reconstruction->Write();
 
+                analyzer->shootoutTemplates()->write();
+                analyzer->truncationReport()->write();
+
                 first_jet->write(*analyzer->firstJet(), app->output().get());
                 second_jet->write(*analyzer->secondJet(), app->output().get());
                 third_jet->write(*analyzer->thirdJet(), app->output().get());
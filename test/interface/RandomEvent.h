@@ -0,0 +1,53 @@
+// Random events for the reconstruction tests and comparison of the
+// reconstruction results
+//
+// Created by agent, Oct 17, 2026
+// Copyright 2026, All rights reserved
+
+#ifndef BSM_TEST_RANDOM_EVENT
+#define BSM_TEST_RANDOM_EVENT
+
+#include "bsm_input/interface/bsm_input_fwd.h"
+#include "interface/Algorithm.h"
+
+// Random p4 with given pT range and mass
+//
+bsm::LorentzVector random_p4(const float &min_pt,
+                             const float &max_pt,
+                             const float &mass);
+
+// Random corrected p4 of every jet: jets are sorted by pT and all point to
+// the same original jet
+//
+void random_jets(bsm::SynchSelector::GoodJets &jets, const bsm::Jet &jet);
+
+// Random event for the selection: primary vertices, HyperTight1 electrons,
+// jets with uncorrected p4 and area, rho and MET. Values are spread around
+// the SynchSelector cuts for every stage to pass and fail
+//
+void random_event(bsm::Event &, const uint32_t &max_jets);
+
+// Exact comparison: the same p4 components, the same corrected jets and the
+// same solution with the same discriminators
+//
+bool isSame(const bsm::LorentzVector &, const bsm::LorentzVector &);
+
+bool isSame(const bsm::ResonanceReconstructor::CorrectedJets &,
+            const bsm::ResonanceReconstructor::CorrectedJets &);
+
+// Corrected jets of different selectors: the same original jets and the
+// same corrected p4 values
+//
+bool isSameCorrection(const bsm::SynchSelector::GoodJets &,
+                      const bsm::SynchSelector::GoodJets &);
+
+bool isSame(const bsm::ResonanceReconstructor::Mttbar &,
+            const bsm::ResonanceReconstructor::Mttbar &);
+
+// Comparison at the level of rounding: 1e-9 relative or 1e-9 absolute for
+// values below 1
+//
+bool isClose(const double &, const double &);
+bool isClose(const bsm::LorentzVector &, const bsm::LorentzVector &);
+
+#endif
@@ -0,0 +1,190 @@
+// Random events for the reconstruction tests and comparison of the
+// reconstruction results
+//
+// Created by agent, Oct 17, 2026
+// Copyright 2026, All rights reserved
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "bsm_input/interface/Electron.pb.h"
+#include "bsm_input/interface/Event.pb.h"
+#include "bsm_input/interface/Jet.pb.h"
+#include "bsm_input/interface/MissingEnergy.pb.h"
+#include "bsm_input/interface/Physics.pb.h"
+#include "bsm_input/interface/PrimaryVertex.pb.h"
+#include "interface/Utility.h"
+
+#include "interface/RandomEvent.h"
+
+using namespace std;
+
+using bsm::Electron;
+using bsm::Event;
+using bsm::Jet;
+using bsm::LorentzVector;
+using bsm::PrimaryVertex;
+using bsm::ResonanceReconstructor;
+
+namespace
+{
+    float random_value(const float &min, const float &max)
+    {
+        return min + (max - min) * rand() / RAND_MAX;
+    }
+}
+
+LorentzVector random_p4(const float &min_pt, const float &max_pt,
+        const float &mass)
+{
+    const float pt = min_pt + (max_pt - min_pt) * rand() / RAND_MAX;
+    const float eta = 4.0 * rand() / RAND_MAX - 2.0;
+    const float phi = 2 * M_PI * rand() / RAND_MAX - M_PI;
+
+    LorentzVector p4;
+    p4.set_px(pt * cos(phi));
+    p4.set_py(pt * sin(phi));
+    p4.set_pz(pt * sinh(eta));
+    p4.set_e(sqrt(pow(pt * cosh(eta), 2) + mass * mass));
+
+    return p4;
+}
+
+void random_jets(bsm::SynchSelector::GoodJets &jets, const bsm::Jet &jet)
+{
+    for(bsm::SynchSelector::GoodJets::iterator good_jet = jets.begin();
+            jets.end() != good_jet;
+            ++good_jet)
+    {
+        good_jet->jet = &jet;
+        good_jet->corrected_p4.reset(new LorentzVector(
+                    random_p4(30, 1000, 5)));
+    }
+
+    sort(jets.begin(), jets.end(), bsm::CorrectedPtGreater());
+}
+
+void random_event(Event &event, const uint32_t &max_jets)
+{
+    event.Clear();
+
+    // Primary vertices: the first one is used by the selector and fails
+    // ndof, z or rho cuts from time to time
+    //
+    for(uint32_t vertices = 1 + rand() % 2; vertices; --vertices)
+    {
+        PrimaryVertex *pv = event.add_primary_vertex();
+        pv->mutable_vertex()->set_z(random_value(-30, 30));
+        pv->mutable_extra()->set_ndof(random_value(0, 20));
+        pv->mutable_extra()->set_rho(random_value(0, 2.5));
+    }
+
+    // Electrons: pT around the lepton cut, rare failures of the
+    // identification
+    //
+    for(uint32_t electrons = rand() % 3; electrons; --electrons)
+    {
+        Electron *electron = event.add_electron();
+        electron->mutable_physics_object()->mutable_p4()->CopyFrom(
+                random_p4(20, 200, 0.0005));
+        electron->mutable_physics_object()->mutable_vertex()->CopyFrom(
+                event.primary_vertex(0).vertex());
+
+        Electron::ElectronID *id = electron->add_id();
+        id->set_name(Electron::HyperTight1);
+        id->set_identification(rand() % 10);
+        id->set_conversion_rejection(rand() % 10);
+    }
+
+    // Jets are not sorted: the selector sorts good jets by corrected pT
+    //
+    for(uint32_t jets = rand() % (max_jets + 1); jets; --jets)
+    {
+        Jet *jet = event.add_jet();
+        const LorentzVector p4 = random_p4(20, 400, 5);
+        jet->mutable_physics_object()->mutable_p4()->CopyFrom(p4);
+        jet->mutable_uncorrected_p4()->CopyFrom(p4);
+        jet->mutable_extra()->set_area(random_value(0.4, 1.0));
+    }
+
+    event.mutable_extra()->set_rho(random_value(0, 20));
+
+    LorentzVector met = random_p4(0, 200, 0);
+    met.set_pz(0);
+    met.set_e(sqrt(met.px() * met.px() + met.py() * met.py()));
+    event.mutable_missing_energy()->mutable_p4()->CopyFrom(met);
+}
+
+bool isSame(const LorentzVector &p4, const LorentzVector &other_p4)
+{
+    return p4.e() == other_p4.e()
+        && p4.px() == other_p4.px()
+        && p4.py() == other_p4.py()
+        && p4.pz() == other_p4.pz();
+}
+
+bool isSame(const ResonanceReconstructor::CorrectedJets &jets,
+        const ResonanceReconstructor::CorrectedJets &other_jets)
+{
+    if (jets.size() != other_jets.size())
+        return false;
+
+    for(uint32_t jet = 0; jets.size() > jet; ++jet)
+    {
+        if (jets[jet].corrected_p4 != other_jets[jet].corrected_p4)
+            return false;
+    }
+
+    return true;
+}
+
+bool isSameCorrection(const bsm::SynchSelector::GoodJets &jets,
+        const bsm::SynchSelector::GoodJets &other_jets)
+{
+    if (jets.size() != other_jets.size())
+        return false;
+
+    for(uint32_t jet = 0; jets.size() > jet; ++jet)
+    {
+        if (jets[jet].jet != other_jets[jet].jet
+                || !isSame(*jets[jet].corrected_p4,
+                    *other_jets[jet].corrected_p4))
+            return false;
+    }
+
+    return true;
+}
+
+bool isSame(const ResonanceReconstructor::Mttbar &result,
+        const ResonanceReconstructor::Mttbar &other_result)
+{
+    if (result.valid != other_result.valid
+            || result.solutions != other_result.solutions)
+        return false;
+
+    return !result.valid
+        || (isSame(result.mttbar, other_result.mttbar)
+            && isSame(result.ltop, other_result.ltop)
+            && isSame(result.htop, other_result.htop)
+            && isSame(result.neutrino, other_result.neutrino)
+            && result.htop_njets == other_result.htop_njets
+            && result.ltop_discriminator == other_result.ltop_discriminator
+            && result.htop_discriminator == other_result.htop_discriminator
+            && isSame(result.htop_jets, other_result.htop_jets)
+            && isSame(result.ltop_jets, other_result.ltop_jets));
+}
+
+bool isClose(const double &value, const double &other_value)
+{
+    return fabs(value - other_value)
+        <= 1e-9 * max(1.0, max(fabs(value), fabs(other_value)));
+}
+
+bool isClose(const LorentzVector &p4, const LorentzVector &other_p4)
+{
+    return isClose(p4.e(), other_p4.e())
+        && isClose(p4.px(), other_p4.px())
+        && isClose(p4.py(), other_p4.py())
+        && isClose(p4.pz(), other_p4.pz());
+}
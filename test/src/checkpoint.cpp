@@ -0,0 +1,111 @@
+// Test checkpoint save and load: processed files and analyzer state
+// should be restored
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "interface/Checkpoint.h"
+
+using namespace std;
+
+using bsm::Checkpoint;
+using bsm::CheckpointDelegate;
+using bsm::loadString;
+using bsm::saveString;
+
+// Count events per input file
+//
+class Counts : public CheckpointDelegate
+{
+    public:
+        typedef map<string, int> Events;
+
+        Events events;
+
+        virtual void save(ostream &out) const
+        {
+            out << events.size() << endl;
+            for(Events::const_iterator file = events.begin();
+                    events.end() != file;
+                    ++file)
+            {
+                saveString(out, file->first);
+                out << " " << file->second << endl;
+            }
+        }
+
+        virtual bool load(istream &in)
+        {
+            Events::size_type files = 0;
+            if (!(in >> files))
+                return false;
+
+            for(; files; --files)
+            {
+                string file;
+                int counts = 0;
+                if (!loadString(in, file)
+                        || !(in >> counts))
+                    return false;
+
+                events[file] += counts;
+            }
+
+            return true;
+        }
+};
+
+int main(int argc, char *argv[])
+try
+{
+    const string file_name = "checkpoint_test.bsm";
+
+    Checkpoint::Inputs processed;
+    processed.push_back("input_1.pb");
+    processed.push_back("input with spaces.pb");
+
+    Counts counts;
+    counts.events["input_1.pb"] = 10;
+    counts.events["input_2.pb"] = 20;
+    counts.events["input with spaces.pb"] = 30;
+
+    const Checkpoint checkpoint(file_name);
+    if (!checkpoint.save(processed, counts))
+        throw runtime_error("failed to save checkpoint");
+
+    Checkpoint::Inputs restored_files;
+    Counts restored_counts;
+    if (!checkpoint.load(restored_files, restored_counts))
+        throw runtime_error("failed to load checkpoint");
+
+    remove(file_name.c_str());
+
+    if (processed != restored_files)
+        throw runtime_error("processed files are not restored");
+
+    if (counts.events != restored_counts.events)
+        throw runtime_error("analyzer state is not restored");
+
+    cout << "checkpoint is restored: " << restored_files.size()
+        << " files" << endl;
+
+    return 0;
+}
+catch(const exception &error)
+{
+    cerr << "error: " << error.what() << endl;
+
+    return 1;
+}
+catch(...)
+{
+    cerr << "Unknown error" << endl;
+
+    return 1;
+}
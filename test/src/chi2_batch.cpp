@@ -0,0 +1,225 @@
+// Regression test of the batch chi2 scoring: batch kernels of every
+// discriminator are compared with regular calculation and random events
+// are reconstructed with regular and batch chi2 reconstruction, the best
+// hypotheses should be the same
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "bsm_input/interface/Algebra.h"
+#include "bsm_input/interface/Jet.pb.h"
+#include "bsm_input/interface/Physics.pb.h"
+#include "interface/Algorithm.h"
+#include "interface/RandomEvent.h"
+#include "interface/Utility.h"
+
+using namespace std;
+
+using boost::lexical_cast;
+
+using namespace bsm;
+
+typedef Chi2ResonanceReconstructor::Chi2DiscriminatorPtr DiscriminatorPtr;
+typedef Chi2ResonanceReconstructor::Chi2Discriminators Discriminators;
+typedef SynchSelector::GoodJets Jets;
+
+// Batch chi2 tolerance: 1e-5 relative or 1e-5 absolute for chi2 below 1
+//
+bool isChi2Close(const float &value, const float &other_value)
+{
+    return fabs(value - other_value)
+        <= 1e-5 * max(1.0f, max(fabs(value), fabs(other_value)));
+}
+
+// Fill batch with random hypotheses and compare kernels of all
+// discriminators with regular calculation
+//
+uint32_t testKernels(const Discriminators &discriminators, const Jets &jets)
+{
+    typedef Chi2Batch::Generator Generator;
+
+    Chi2Batch batch;
+    batch.objects = &jets;
+    batch.lepton = random_p4(30, 500, 0.1);
+    batch.lepton_eta = eta(batch.lepton);
+    batch.lepton_phi = phi(batch.lepton);
+
+    for(uint32_t index = 0; jets.size() > index; ++index)
+    {
+        const LorentzVector &p4 = *jets[index].corrected_p4;
+
+        batch.jets.e[index] = p4.e();
+        batch.jets.px[index] = p4.px();
+        batch.jets.py[index] = p4.py();
+        batch.jets.pz[index] = p4.pz();
+        batch.jets.eta[index] = eta(p4);
+        batch.jets.phi[index] = phi(p4);
+    }
+
+    while(!batch.full())
+    {
+        uint32_t ltop_jets = 0;
+        uint32_t htop_jets = 0;
+        for(uint32_t index = 0; jets.size() > index; ++index)
+        {
+            switch(rand() % 3)
+            {
+                case 0: ltop_jets |= 1u << index; break;
+                case 1: htop_jets |= 1u << index; break;
+            }
+        }
+
+        if (!ltop_jets
+                || !htop_jets)
+            continue;
+
+        Generator::Hypothesis hypothesis;
+        batch.decay(ltop_jets, htop_jets, hypothesis);
+
+        LorentzVector htop;
+        for(Generator::Iterators::const_iterator jet =
+                    hypothesis.hadronic.begin();
+                hypothesis.hadronic.end() != jet;
+                ++jet)
+        {
+            htop += *(*jet)->corrected_p4;
+        }
+
+        batch.push_back(random_p4(20, 500, 0),
+                        *hypothesis.leptonic.front()->corrected_p4,
+                        htop, ltop_jets, htop_jets, 0);
+    }
+
+    uint32_t failures = 0;
+    for(Discriminators::const_iterator discriminator = discriminators.begin();
+            discriminators.end() != discriminator;
+            ++discriminator)
+    {
+        float chi2[Chi2Batch::SIZE] = {0};
+        (*discriminator)->calculateBatch(batch, chi2);
+
+        for(uint32_t index = 0; batch.size > index; ++index)
+        {
+            const float expected =
+                (*discriminator)->calculate(batch.hypothesis(index));
+
+            if (!isChi2Close(expected, chi2[index]))
+            {
+                cerr << "batch chi2 " << chi2[index] << " is different from "
+                    << expected << endl;
+
+                ++failures;
+            }
+        }
+    }
+
+    return failures;
+}
+
+int main(int argc, char *argv[])
+try
+{
+    if (3 > argc)
+    {
+        cerr << "usage: " << argv[0] << " events max_jets" << endl;
+
+        return 0;
+    }
+
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    const uint32_t events = lexical_cast<uint32_t>(argv[1]);
+    const uint32_t max_jets = lexical_cast<uint32_t>(argv[2]);
+
+    Discriminators ltop;
+    ltop.push_back(DiscriminatorPtr(new LtopMassDiscriminator(180, 40)));
+    ltop.push_back(DiscriminatorPtr(new LtopDeltaRSumDiscriminator(2, 1)));
+
+    Discriminators htop;
+    htop.push_back(DiscriminatorPtr(new HtopMassDiscriminator(180, 40)));
+    htop.push_back(DiscriminatorPtr(new HtopDeltaRSumDiscriminator(3, 1)));
+    htop.push_back(DiscriminatorPtr(new DeltaPhiDiscriminator(3.14, 0.5)));
+
+    Discriminators all(ltop);
+    all.insert(all.end(), htop.begin(), htop.end());
+
+    Chi2ResonanceReconstructor reconstructor;
+    reconstructor.setLtopDiscriminators(ltop);
+    reconstructor.setHtopDiscriminators(htop);
+
+    Jet jet;
+
+    uint32_t failures = 0;
+    double regular_time = 0;
+    double batch_time = 0;
+    for(uint32_t event = 0; events > event; ++event)
+    {
+        const LorentzVector lepton = random_p4(30, 500, 0.1);
+        const LorentzVector met = random_p4(20, 500, 0);
+
+        const uint32_t number_of_jets = 2 + rand() % (max_jets - 1);
+
+        Jets jets(number_of_jets);
+        random_jets(jets, jet);
+
+        failures += testKernels(all, jets);
+
+        reconstructor.setBatch(false);
+
+        clock_t start = clock();
+        const ResonanceReconstructor::Mttbar expected =
+            reconstructor.run(lepton, met, jets);
+        regular_time += double(clock() - start) / CLOCKS_PER_SEC;
+
+        reconstructor.setBatch(true);
+
+        start = clock();
+        const ResonanceReconstructor::Mttbar result =
+            reconstructor.run(lepton, met, jets);
+        batch_time += double(clock() - start) / CLOCKS_PER_SEC;
+
+        if (!isSame(expected, result))
+        {
+            cerr << "event " << event << " with " << number_of_jets
+                << " jets: different solution found by batch scoring" << endl;
+
+            ++failures;
+        }
+    }
+
+    cout << "regular chi2 scoring" << endl;
+    cout << "it took " << regular_time << " seconds" << endl;
+    cout << endl;
+
+    cout << "batch chi2 scoring" << endl;
+    cout << "it took " << batch_time << " seconds" << endl;
+    cout << endl;
+
+    cout << failures << " differences found" << endl;
+
+    return failures ? 1 : 0;
+}
+catch(const exception &error)
+{
+    cerr << "error: " << error.what() << endl;
+
+    return 1;
+}
+catch(...)
+{
+    cerr << "Unknown error" << endl;
+
+    return 1;
+}
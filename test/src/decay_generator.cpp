@@ -0,0 +1,347 @@
+// Compare enumeration of the decay hypotheses: vector based generator (jets
+// are copied, every hypothesis allocates legs) against the generator with
+// assignment code and fixed capacity legs
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include "interface/DecayGenerator.h"
+
+using namespace std;
+using boost::lexical_cast;
+
+using bsm::DecayGenerator;
+
+// Count heap allocations
+//
+uint64_t allocations = 0;
+
+void *operator new(size_t size) throw(std::bad_alloc)
+{
+    ++allocations;
+
+    void *memory = malloc(size ? size : 1);
+    if (!memory)
+        throw std::bad_alloc();
+
+    return memory;
+}
+
+void operator delete(void *memory) throw()
+{
+    free(memory);
+}
+
+struct Jet
+{
+    Jet(const float &pt = 0):
+        pt(pt)
+    {
+    }
+
+    float pt;
+};
+
+typedef vector<Jet> Jets;
+
+// Vector based generator
+//
+class VectorDecayGenerator
+{
+    public:
+        typedef vector<Jets::const_iterator> Iterators;
+
+        struct Hypothesis
+        {
+            Iterators leptonic;
+            Iterators hadronic;
+            Iterators neutral;
+        };
+
+        void init(const Jets &jets)
+        {
+            _jets = jets;
+
+            _number_of_hypotheses = pow(3.0, static_cast<int>(jets.size()));
+            _current_hypothesis = 0;
+        }
+
+        bool next()
+        {
+            if (_number_of_hypotheses <= _current_hypothesis)
+                return false;
+
+            return _number_of_hypotheses > ++_current_hypothesis;
+        }
+
+        Hypothesis hypothesis() const
+        {
+            return hypothesis(_current_hypothesis);
+        }
+
+        // Hypothesis at any position in counting order
+        //
+        Hypothesis hypothesis(uint32_t current_hypothesis) const
+        {
+            Hypothesis hypothesis;
+
+            for(Jets::const_iterator jet = _jets.begin();
+                    _jets.end() != jet;
+                    ++jet, current_hypothesis /= 3)
+            {
+                switch(current_hypothesis % 3)
+                {
+                    case 0: hypothesis.leptonic.push_back(jet); break;
+                    case 1: hypothesis.hadronic.push_back(jet); break;
+                    default: hypothesis.neutral.push_back(jet); break;
+                }
+            }
+
+            return hypothesis;
+        }
+
+    private:
+        Jets _jets;
+
+        uint32_t _number_of_hypotheses;
+        uint32_t _current_hypothesis;
+};
+
+// Sum pT of the hadronic legs: prevent compiler from optimizing the loop
+// away
+//
+volatile float htop_pt = 0;
+
+template<class Generator, class Hypothesis>
+float sum(const Hypothesis &hypothesis)
+{
+    float pt = 0;
+    for(typename Generator::Iterators::const_iterator jet =
+                hypothesis.hadronic.begin();
+            hypothesis.hadronic.end() != jet;
+            ++jet)
+    {
+        pt += (*jet)->pt;
+    }
+
+    return pt;
+}
+
+double vectorLoop(const Jets &jets, const uint32_t &events)
+{
+    clock_t start = clock();
+    for(uint32_t event = 0; events > event; ++event)
+    {
+        VectorDecayGenerator generator;
+        generator.init(jets);
+
+        do
+        {
+            VectorDecayGenerator::Hypothesis hypothesis =
+                generator.hypothesis();
+
+            htop_pt += sum<VectorDecayGenerator>(hypothesis);
+        }
+        while(generator.next());
+    }
+    clock_t end = clock();
+
+    return double(end - start) / CLOCKS_PER_SEC;
+}
+
+double fixedLoop(const Jets &jets,
+        const uint32_t &events,
+        const DecayGenerator<Jet>::Order &order)
+{
+    typedef DecayGenerator<Jet> Generator;
+
+    clock_t start = clock();
+    for(uint32_t event = 0; events > event; ++event)
+    {
+        Generator generator;
+        generator.init(jets, order);
+
+        do
+        {
+            const Generator::Hypothesis &hypothesis = generator.hypothesis();
+
+            htop_pt += sum<Generator>(hypothesis);
+        }
+        while(generator.next());
+    }
+    clock_t end = clock();
+
+    return double(end - start) / CLOCKS_PER_SEC;
+}
+
+// Both generators should produce the same hypotheses in the same order
+//
+bool isSame(const Jets &jets)
+{
+    typedef DecayGenerator<Jet> Generator;
+
+    VectorDecayGenerator vector_generator;
+    vector_generator.init(jets);
+
+    Generator generator;
+    generator.init(jets);
+
+    for(;;)
+    {
+        VectorDecayGenerator::Hypothesis expected =
+            vector_generator.hypothesis();
+        const Generator::Hypothesis &hypothesis = generator.hypothesis();
+
+        if (expected.leptonic.size() != hypothesis.leptonic.size()
+                || expected.hadronic.size() != hypothesis.hadronic.size()
+                || expected.neutral.size() != hypothesis.neutral.size()
+                || sum<VectorDecayGenerator>(expected)
+                    != sum<Generator>(hypothesis))
+            return false;
+
+        const bool has_next = vector_generator.next();
+        if (has_next != generator.next())
+            return false;
+
+        if (!has_next)
+            break;
+    }
+
+    return true;
+}
+
+// pT of the leg objects in ascending order: objects are not kept in the
+// input order in Gray order
+//
+template<class Iterators>
+vector<float> sorted(const Iterators &leg)
+{
+    vector<float> pts;
+    for(typename Iterators::const_iterator jet = leg.begin();
+            leg.end() != jet;
+            ++jet)
+    {
+        pts.push_back((*jet)->pt);
+    }
+
+    sort(pts.begin(), pts.end());
+
+    return pts;
+}
+
+// Every hypothesis in Gray order should match the hypothesis at the same
+// index in counting order, and all hypotheses should be visited once
+//
+bool isSameGray(const Jets &jets)
+{
+    typedef DecayGenerator<Jet> Generator;
+
+    VectorDecayGenerator vector_generator;
+    vector_generator.init(jets);
+
+    Generator generator;
+    generator.init(jets, Generator::GRAY);
+
+    vector<bool> visited(pow(3.0, static_cast<int>(jets.size())), false);
+    do
+    {
+        if (visited[generator.index()])
+            return false;
+
+        visited[generator.index()] = true;
+
+        VectorDecayGenerator::Hypothesis expected =
+            vector_generator.hypothesis(generator.index());
+        const Generator::Hypothesis &hypothesis = generator.hypothesis();
+
+        if (sorted(expected.leptonic) != sorted(hypothesis.leptonic)
+                || sorted(expected.hadronic) != sorted(hypothesis.hadronic)
+                || sorted(expected.neutral) != sorted(hypothesis.neutral))
+            return false;
+    }
+    while(generator.next());
+
+    return visited.end() == find(visited.begin(), visited.end(), false);
+}
+
+int main(int argc, char *argv[])
+try
+{
+    if (3 > argc)
+    {
+        cerr << "usage: " << argv[0] << " jets events" << endl;
+
+        return 0;
+    }
+
+    const uint32_t number_of_jets = lexical_cast<uint32_t>(argv[1]);
+    const uint32_t events = lexical_cast<uint32_t>(argv[2]);
+
+    Jets jets;
+    for(uint32_t jet = 0; number_of_jets > jet; ++jet)
+        jets.push_back(Jet(100.0 / (jet + 1)));
+
+    if (!isSame(jets)
+            || !isSameGray(jets))
+    {
+        cerr << "generators produce different hypotheses" << endl;
+
+        return 1;
+    }
+
+    cout << number_of_jets << " jets: " << pow(3.0, (int) number_of_jets)
+        << " hypotheses per event" << endl;
+    cout << endl;
+
+    uint64_t allocations_before = allocations;
+    const double vector_time = vectorLoop(jets, events);
+    cout << "vector generator: " << events << " events" << endl;
+    cout << "it took " << vector_time << " seconds" << endl;
+    cout << "  allocations per event: "
+        << (allocations - allocations_before) / events << endl;
+    cout << endl;
+
+    allocations_before = allocations;
+    const double fixed_time = fixedLoop(jets, events,
+            DecayGenerator<Jet>::COUNTING);
+    cout << "fixed capacity generator: " << events << " events" << endl;
+    cout << "it took " << fixed_time << " seconds" << endl;
+    cout << "  allocations per event: "
+        << (allocations - allocations_before) / events << endl;
+    cout << endl;
+
+    allocations_before = allocations;
+    const double gray_time = fixedLoop(jets, events,
+            DecayGenerator<Jet>::GRAY);
+    cout << "fixed capacity generator, Gray order: " << events
+        << " events" << endl;
+    cout << "it took " << gray_time << " seconds" << endl;
+    cout << "  allocations per event: "
+        << (allocations - allocations_before) / events << endl;
+
+    return 0;
+}
+catch(const exception &error)
+{
+    cerr << "error: " << error.what() << endl;
+
+    return 1;
+}
+catch(...)
+{
+    cerr << "Unknown error" << endl;
+
+    return 1;
+}
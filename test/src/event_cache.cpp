@@ -0,0 +1,80 @@
+// Test event cache: value is valid only within the event it was set in
+// and invalid cache throws on access
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <iostream>
+#include <stdexcept>
+
+#include "interface/Cache.h"
+
+using namespace std;
+using namespace bsm;
+
+int main(int argc, char *argv[])
+try
+{
+    EventGeneration generation;
+    EventCache<float> cache;
+
+    uint32_t failures = 0;
+    uint32_t calculations = 0;
+    for(uint32_t event = 0; 10 > event; ++event)
+    {
+        generation.next();
+
+        // Value is requested several times per event
+        //
+        for(uint32_t request = 0; 3 > request; ++request)
+        {
+            if (!cache.is_valid(generation))
+            {
+                cache.set(generation, event * 1.5);
+
+                ++calculations;
+            }
+
+            if (event * 1.5 != cache.get(generation))
+            {
+                cerr << "event " << event << ": wrong cached value "
+                    << cache.get(generation) << endl;
+
+                ++failures;
+            }
+        }
+    }
+
+    cout << calculations << " calculations in 10 events" << endl;
+    if (10 != calculations)
+        ++failures;
+
+    generation.next();
+    try
+    {
+        cache.get(generation);
+
+        cerr << "cache of the previous event is valid" << endl;
+
+        ++failures;
+    }
+    catch(const runtime_error &)
+    {
+    }
+
+    cout << failures << " failures found" << endl;
+
+    return failures ? 1 : 0;
+}
+catch(const exception &error)
+{
+    cerr << "error: " << error.what() << endl;
+
+    return 1;
+}
+catch(...)
+{
+    cerr << "Unknown error" << endl;
+
+    return 1;
+}
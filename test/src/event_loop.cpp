@@ -0,0 +1,130 @@
+// Measure per-event overhead of the analyzer thread event loop
+//
+// Compare the loop that locks thread mutex for every event (continue flag
+// and analyzer call) with the lock-free loop that uses atomic continue flag,
+// atomic cursor and atomic events counter
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <time.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/atomic.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "bsm_core/interface/Thread.h"
+
+using namespace std;
+using boost::lexical_cast;
+
+using bsm::core::Condition;
+using bsm::core::ConditionPtr;
+using bsm::core::Lock;
+
+// Prevent compiler from optimizing the loop away
+//
+volatile uint32_t analyzed = 0;
+
+void analyze()
+{
+    ++analyzed;
+}
+
+// Event loop with mutex: isContinue() and process() lock
+//
+double lockedLoop(const uint32_t &events)
+{
+    ConditionPtr condition(new Condition());
+    bool is_continue = true;
+    uint32_t events_processed = 0;
+
+    clock_t start = clock();
+    for(uint32_t event = 0; events > event; ++event)
+    {
+        {
+            Lock lock(condition);
+            if (!is_continue)
+                break;
+        }
+
+        Lock lock(condition);
+
+        analyze();
+
+        ++events_processed;
+    }
+    clock_t end = clock();
+
+    return double(end - start) / CLOCKS_PER_SEC;
+}
+
+// Lock-free event loop: atomic continue flag, cursor and events counter
+//
+double atomicLoop(const uint32_t &events)
+{
+    boost::atomic<bool> is_continue(true);
+    boost::atomic<uint64_t> cursor(events);
+    boost::atomic<uint32_t> events_processed(0);
+
+    clock_t start = clock();
+    for(;;)
+    {
+        if (!is_continue.load(boost::memory_order_relaxed))
+            break;
+
+        uint64_t position = cursor.load();
+        if ((position >> 32) >= (position & 0xFFFFFFFF))
+            break;
+
+        if (!cursor.compare_exchange_weak(position, position + (1ULL << 32)))
+            continue;
+
+        analyze();
+
+        events_processed.fetch_add(1, boost::memory_order_relaxed);
+    }
+    clock_t end = clock();
+
+    return double(end - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[])
+try
+{
+    if (2 > argc)
+    {
+        cerr << "usage: " << argv[0] << " events" << endl;
+
+        return 0;
+    }
+
+    const uint32_t events = lexical_cast<uint32_t>(argv[1]);
+
+    const double locked = lockedLoop(events);
+    cout << "locked loop: " << events << " events" << endl;
+    cout << "it took " << locked << " seconds" << endl;
+    cout << "  per event: " << locked / events * 1e9 << " ns" << endl;
+    cout << endl;
+
+    const double lock_free = atomicLoop(events);
+    cout << "lock-free loop: " << events << " events" << endl;
+    cout << "it took " << lock_free << " seconds" << endl;
+    cout << "  per event: " << lock_free / events * 1e9 << " ns" << endl;
+
+    return 0;
+}
+catch(const exception &error)
+{
+    cerr << "error: " << error.what() << endl;
+
+    return 1;
+}
+catch(...)
+{
+    cerr << "Unknown error" << endl;
+
+    return 1;
+}
@@ -1,4 +1,5 @@
-// Test Jet Permutation class
+// Test Jet Permutation class: every pair of non-overlapping non-empty
+// leptonic and hadronic sets of jets should be generated once
 //
 // Created by Samvel Khalatyan, Aug 12, 2011
 // Copyright 2011, All rights reserved
@@ -6,7 +7,9 @@
 #include <time.h>
 
 #include <iostream>
+#include <set>
 #include <stdexcept>
+#include <utility>
 
 #include <boost/lexical_cast.hpp>
 
@@ -63,6 +66,21 @@ ostream &operator<<(ostream &out, const Jets &jets)
     return out;
 }
 
+// Mask of jet ids
+//
+uint32_t mask(const Jets &jets)
+{
+    uint32_t result = 0;
+    for(Jets::const_iterator jet = jets.begin();
+            jets.end() != jet;
+            ++jet)
+    {
+        result |= 1u << ((*jet)->id() - 1);
+    }
+
+    return result;
+}
+
 // This method is used for debugging
 //
 void printJets()
@@ -74,15 +92,17 @@ void printJets()
 }
 
 int main(int argc, char *argv[])
+try
 {
     if (2 > argc)
     {
-        cerr << "usage: " << argv[0] << " jets" << endl;
+        cerr << "usage: " << argv[0] << " jets [loops]" << endl;
 
         return 0;
     }
 
     const uint32_t number_of_jets = lexical_cast<uint32_t>(argv[1]);
+    const uint32_t loops = 2 < argc ? lexical_cast<uint32_t>(argv[2]) : 10;
 
     for(uint32_t i = 0; number_of_jets > i; ++i)
     {
@@ -98,6 +118,10 @@ int main(int argc, char *argv[])
     permutation.init(::jets);
 
     uint32_t total_permutations = 0;
+    uint32_t failures = 0;
+
+    typedef set<pair<uint32_t, uint32_t> > Masks;
+    Masks masks;
 
     do
     {
@@ -107,6 +131,26 @@ int main(int argc, char *argv[])
         //cout << "Leptonic: " << leptonic << endl;
         //cout << "Hadronic: " << hadronic << endl;
         //cout << endl;
+
+        const uint32_t leptonic_mask = mask(leptonic);
+        const uint32_t hadronic_mask = mask(hadronic);
+
+        // There are no permutations for less than two jets
+        //
+        if (2 > number_of_jets)
+            continue;
+
+        if (!leptonic_mask
+                || !hadronic_mask
+                || (leptonic_mask & hadronic_mask)
+                || !masks.insert(make_pair(leptonic_mask,
+                                           hadronic_mask)).second)
+        {
+            cerr << "wrong permutation: " << leptonic << "| "
+                << hadronic << endl;
+
+            ++failures;
+        }
     }
     while(permutation.next());
 
@@ -115,19 +159,45 @@ int main(int argc, char *argv[])
     cout << total_permutations << " total permutations were generated" << endl;
     cout << "it took " << double(end - start) / CLOCKS_PER_SEC << " seconds" << endl;
 
+    // All pairs: 3^N - 2^(N + 1) + 1
+    //
+    if (1 < number_of_jets)
+    {
+        uint64_t expected = 1;
+        uint64_t subsets = 2;
+        for(uint32_t i = 0; number_of_jets > i; ++i)
+        {
+            expected *= 3;
+            subsets *= 2;
+        }
+
+        expected += 1 - subsets;
+
+        if (expected != total_permutations)
+        {
+            cerr << expected << " permutations are expected" << endl;
+
+            ++failures;
+        }
+    }
+
     cout << endl;
-    cout << "reuse tables" << endl;
+    cout << "reuse tables " << loops << " times" << endl;
     start = clock();
-    permutation.init(::jets);
 
     total_permutations = 0;
-    do
+    for(uint32_t loop = 0; loops > loop; ++loop)
     {
-        ++total_permutations;
-        Jets leptonic = permutation.leptonicJets();
-        Jets hadronic = permutation.hadronicJets();
+        permutation.init(::jets);
+
+        do
+        {
+            ++total_permutations;
+            Jets leptonic = permutation.leptonicJets();
+            Jets hadronic = permutation.hadronicJets();
+        }
+        while(permutation.next());
     }
-    while(permutation.next());
     end = clock();
 
     cout << total_permutations << " total permutations were generated" << endl;
@@ -140,5 +210,19 @@ int main(int argc, char *argv[])
         delete *jet;
     }
 
+    cout << failures << " failures found" << endl;
+
+    return failures ? 1 : 0;
+}
+catch(const std::exception &error)
+{
+    cerr << "error: " << error.what() << endl;
+
+    return 1;
+}
+catch(...)
+{
+    cerr << "Unknown error" << endl;
+
     return 1;
 }
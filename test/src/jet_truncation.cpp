@@ -0,0 +1,214 @@
+// Test jets truncation: leading jets and b-tagged jets are kept in the
+// input order. Random events are reconstructed with all jets and with
+// leading jets only to report how often the best hypothesis is changed
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include "bsm_input/interface/Algebra.h"
+#include "bsm_input/interface/Jet.pb.h"
+#include "bsm_input/interface/Physics.pb.h"
+#include "interface/Algorithm.h"
+#include "interface/Btag.h"
+#include "interface/RandomEvent.h"
+#include "interface/Utility.h"
+
+using namespace std;
+
+using boost::lexical_cast;
+
+using namespace bsm;
+
+typedef SynchSelector::GoodJets Jets;
+typedef ResonanceReconstructor::Mttbar Mttbar;
+
+bool isSameHypothesis(const Mttbar &result, const Mttbar &other_result)
+{
+    if (result.valid != other_result.valid)
+        return false;
+
+    return !result.valid
+        || (isSame(result.ltop_jets, other_result.ltop_jets)
+            && isSame(result.htop_jets, other_result.htop_jets));
+}
+
+// Leading jets and b-tagged jets beyond them should be kept in order
+//
+uint32_t testTruncation()
+{
+    Jet light_jet;
+    Jet::BTag *btag = light_jet.add_btag();
+    btag->set_type(Jet::BTag::CSV);
+    btag->set_discriminator(Btag::discriminator() / 2);
+
+    Jet b_jet;
+    btag = b_jet.add_btag();
+    btag->set_type(Jet::BTag::CSV);
+    btag->set_discriminator(1);
+
+    Jets jets(6);
+    random_jets(jets, light_jet);
+    jets[4].jet = &b_jet;
+
+    uint32_t failures = 0;
+
+    JetTruncation truncation;
+
+    Jets kept;
+    if (truncation.apply(jets, kept))
+    {
+        cerr << "jets are truncated without limit" << endl;
+
+        ++failures;
+    }
+
+    truncation.setMaxJets(6);
+    if (truncation.apply(jets, kept))
+    {
+        cerr << "jets are truncated at the limit" << endl;
+
+        ++failures;
+    }
+
+    truncation.setMaxJets(3);
+    if (!truncation.apply(jets, kept)
+            || 3 != kept.size()
+            || kept[0].corrected_p4 != jets[0].corrected_p4
+            || kept[2].corrected_p4 != jets[2].corrected_p4)
+    {
+        cerr << "leading jets are not kept" << endl;
+
+        ++failures;
+    }
+
+    truncation.setKeepBtags(true);
+    if (!truncation.apply(jets, kept)
+            || 4 != kept.size()
+            || kept[3].corrected_p4 != jets[4].corrected_p4)
+    {
+        cerr << "b-tagged jet is not kept" << endl;
+
+        ++failures;
+    }
+
+    truncation.setMaxJets(5);
+    jets[5].jet = &b_jet;
+    if (truncation.apply(jets, kept))
+    {
+        cerr << "jets are truncated with only b-tagged jets dropped" << endl;
+
+        ++failures;
+    }
+
+    return failures;
+}
+
+int main(int argc, char *argv[])
+try
+{
+    if (3 > argc)
+    {
+        cerr << "usage: " << argv[0] << " events max_jets" << endl;
+
+        return 0;
+    }
+
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    const uint32_t events = lexical_cast<uint32_t>(argv[1]);
+    const uint32_t max_jets = lexical_cast<uint32_t>(argv[2]);
+
+    if (3 > max_jets
+            || 10 < max_jets)
+    {
+        cerr << "max_jets should be in the range [3, 10]" << endl;
+
+        return 1;
+    }
+
+    uint32_t failures = testTruncation();
+
+    SimpleResonanceReconstructor reconstructor;
+
+    typedef vector<uint32_t> Counters;
+    typedef vector<double> Times;
+
+    Counters changed(max_jets, 0);
+    Times truncated_time(max_jets, 0);
+    double time = 0;
+
+    Jet jet;
+    for(uint32_t event = 0; events > event; ++event)
+    {
+        const LorentzVector lepton = random_p4(30, 500, 0.1);
+        const LorentzVector met = random_p4(20, 500, 0);
+
+        Jets jets(max_jets);
+        random_jets(jets, jet);
+
+        clock_t start = clock();
+        const Mttbar expected = reconstructor.run(lepton, met, jets);
+        time += double(clock() - start) / CLOCKS_PER_SEC;
+
+        for(uint32_t leading_jets = 2;
+                jets.size() > leading_jets;
+                ++leading_jets)
+        {
+            JetTruncation truncation;
+            truncation.setMaxJets(leading_jets);
+
+            Jets kept;
+            truncation.apply(jets, kept);
+
+            start = clock();
+            const Mttbar result = reconstructor.run(lepton, met, kept);
+            truncated_time[leading_jets] +=
+                double(clock() - start) / CLOCKS_PER_SEC;
+
+            if (!isSameHypothesis(expected, result))
+                ++changed[leading_jets];
+        }
+    }
+
+    cout << "all " << max_jets << " jets" << endl;
+    cout << "it took " << time << " seconds" << endl;
+    cout << endl;
+
+    for(uint32_t leading_jets = 2;
+            changed.size() > leading_jets;
+            ++leading_jets)
+    {
+        cout << leading_jets << " leading jets: " << changed[leading_jets]
+            << " of " << events << " events changed best hypothesis" << endl;
+        cout << "it took " << truncated_time[leading_jets] << " seconds"
+            << endl;
+        cout << endl;
+    }
+
+    cout << failures << " failures found" << endl;
+
+    return failures ? 1 : 0;
+}
+catch(const exception &error)
+{
+    cerr << "error: " << error.what() << endl;
+
+    return 1;
+}
+catch(...)
+{
+    cerr << "Unknown error" << endl;
+
+    return 1;
+}
@@ -0,0 +1,178 @@
+// Regression test of the pruned and incremental hypotheses search in
+// resonance reconstruction: random events are reconstructed with
+// exhaustive, pruned and incremental search, the best hypotheses should be
+// the same. Incremental search sums hadronic jets in different order:
+// p4s are compared with tolerance
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/pointer_cast.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "bsm_input/interface/Algebra.h"
+#include "bsm_input/interface/Jet.pb.h"
+#include "bsm_input/interface/Physics.pb.h"
+#include "interface/Algorithm.h"
+#include "interface/RandomEvent.h"
+#include "interface/Utility.h"
+
+using namespace std;
+
+using boost::dynamic_pointer_cast;
+using boost::lexical_cast;
+using boost::shared_ptr;
+
+using namespace bsm;
+
+typedef shared_ptr<ResonanceReconstructor> ReconstructorPtr;
+typedef vector<ReconstructorPtr> Reconstructors;
+typedef SynchSelector::GoodJets Jets;
+
+bool isClose(const ResonanceReconstructor::Mttbar &result,
+        const ResonanceReconstructor::Mttbar &other_result)
+{
+    if (result.valid != other_result.valid)
+        return false;
+
+    return !result.valid
+        || (isClose(result.mttbar, other_result.mttbar)
+            && isSame(result.ltop, other_result.ltop)
+            && isClose(result.htop, other_result.htop)
+            && isSame(result.neutrino, other_result.neutrino)
+            && result.htop_njets == other_result.htop_njets
+            && isSame(result.htop_jets, other_result.htop_jets)
+            && isSame(result.ltop_jets, other_result.ltop_jets));
+}
+
+int main(int argc, char *argv[])
+try
+{
+    if (3 > argc)
+    {
+        cerr << "usage: " << argv[0] << " events max_jets" << endl;
+
+        return 0;
+    }
+
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    const uint32_t events = lexical_cast<uint32_t>(argv[1]);
+    const uint32_t max_jets = lexical_cast<uint32_t>(argv[2]);
+
+    Reconstructors reconstructors;
+    reconstructors.push_back(ReconstructorPtr(
+                new SimpleResonanceReconstructor()));
+    reconstructors.push_back(ReconstructorPtr(
+                new BtagResonanceReconstructor()));
+    reconstructors.push_back(ReconstructorPtr(
+                new HemisphereResonanceReconstructor()));
+    reconstructors.push_back(ReconstructorPtr(
+                new ResonanceReconstructorWithMass()));
+    reconstructors.push_back(ReconstructorPtr(
+                new SimpleResonanceReconstructorWithMassAndPhi()));
+    reconstructors.push_back(ReconstructorPtr(
+                new CollimatedSimpleResonanceReconstructorWithTopMass()));
+    reconstructors.push_back(ReconstructorPtr(
+                new ResonanceReconstructorWithCollimatedTops()));
+
+    Jet jet;
+
+    uint32_t failures = 0;
+    double exhaustive_time = 0;
+    double pruned_time = 0;
+    double incremental_time = 0;
+    for(uint32_t event = 0; events > event; ++event)
+    {
+        const LorentzVector lepton = random_p4(30, 500, 0.1);
+        const LorentzVector met = random_p4(20, 500, 0);
+
+        const uint32_t number_of_jets = 2 + rand() % (max_jets - 1);
+
+        Jets jets(number_of_jets);
+        random_jets(jets, jet);
+
+        for(Reconstructors::const_iterator reconstructor =
+                    reconstructors.begin();
+                reconstructors.end() != reconstructor;
+                ++reconstructor)
+        {
+            (*reconstructor)->setSearch(ResonanceReconstructor::EXHAUSTIVE);
+
+            clock_t start = clock();
+            const ResonanceReconstructor::Mttbar expected =
+                (*reconstructor)->run(lepton, met, jets);
+            exhaustive_time += double(clock() - start) / CLOCKS_PER_SEC;
+
+            (*reconstructor)->setSearch(ResonanceReconstructor::PRUNED);
+
+            start = clock();
+            const ResonanceReconstructor::Mttbar result =
+                (*reconstructor)->run(lepton, met, jets);
+            pruned_time += double(clock() - start) / CLOCKS_PER_SEC;
+
+            if (!isSame(expected, result))
+            {
+                cerr << "event " << event << " with " << number_of_jets
+                    << " jets: different solution found by pruned ";
+                (*reconstructor)->print(cerr);
+
+                ++failures;
+            }
+
+            (*reconstructor)->setSearch(ResonanceReconstructor::INCREMENTAL);
+
+            start = clock();
+            const ResonanceReconstructor::Mttbar incremental_result =
+                (*reconstructor)->run(lepton, met, jets);
+            incremental_time += double(clock() - start) / CLOCKS_PER_SEC;
+
+            if (!isClose(expected, incremental_result))
+            {
+                cerr << "event " << event << " with " << number_of_jets
+                    << " jets: different solution found by incremental ";
+                (*reconstructor)->print(cerr);
+
+                ++failures;
+            }
+        }
+    }
+
+    cout << "exhaustive search" << endl;
+    cout << "it took " << exhaustive_time << " seconds" << endl;
+    cout << endl;
+
+    cout << "pruned search" << endl;
+    cout << "it took " << pruned_time << " seconds" << endl;
+    cout << endl;
+
+    cout << "incremental search" << endl;
+    cout << "it took " << incremental_time << " seconds" << endl;
+    cout << endl;
+
+    cout << failures << " different solutions found" << endl;
+
+    return failures ? 1 : 0;
+}
+catch(const exception &error)
+{
+    cerr << "error: " << error.what() << endl;
+
+    return 1;
+}
+catch(...)
+{
+    cerr << "Unknown error" << endl;
+
+    return 1;
+}
@@ -0,0 +1,156 @@
+// Regression test of the resonance reconstruction shootout: random events
+// are reconstructed with all reconstructors in one pass and with every
+// reconstructor separately, the best hypotheses should be the same
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "bsm_input/interface/Algebra.h"
+#include "bsm_input/interface/Jet.pb.h"
+#include "bsm_input/interface/Physics.pb.h"
+#include "interface/Algorithm.h"
+#include "interface/RandomEvent.h"
+#include "interface/Utility.h"
+
+using namespace std;
+
+using boost::lexical_cast;
+
+using namespace bsm;
+
+typedef ResonanceShootout::ReconstructorPtr ReconstructorPtr;
+typedef Chi2ResonanceReconstructor::Chi2DiscriminatorPtr DiscriminatorPtr;
+typedef Chi2ResonanceReconstructor::Chi2Discriminators Discriminators;
+typedef SynchSelector::GoodJets Jets;
+
+int main(int argc, char *argv[])
+try
+{
+    if (3 > argc)
+    {
+        cerr << "usage: " << argv[0] << " events max_jets" << endl;
+
+        return 0;
+    }
+
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    const uint32_t events = lexical_cast<uint32_t>(argv[1]);
+    const uint32_t max_jets = lexical_cast<uint32_t>(argv[2]);
+
+    Discriminators ltop;
+    ltop.push_back(DiscriminatorPtr(new LtopMassDiscriminator(180, 40)));
+
+    Discriminators htop;
+    htop.push_back(DiscriminatorPtr(new HtopMassDiscriminator(180, 40)));
+    htop.push_back(DiscriminatorPtr(new DeltaPhiDiscriminator(3.14, 0.5)));
+
+    Chi2ResonanceReconstructor *chi2 = new Chi2ResonanceReconstructor();
+    chi2->setLtopDiscriminators(ltop);
+    chi2->setHtopDiscriminators(htop);
+
+    ResonanceShootout shootout;
+    shootout.add("simple",
+            ReconstructorPtr(new SimpleResonanceReconstructor()));
+    shootout.add("btag",
+            ReconstructorPtr(new BtagResonanceReconstructor()));
+    shootout.add("simple_dr",
+            ReconstructorPtr(new SimpleDrResonanceReconstructor()));
+    shootout.add("hemisphere",
+            ReconstructorPtr(new HemisphereResonanceReconstructor()));
+    shootout.add("mass",
+            ReconstructorPtr(new ResonanceReconstructorWithMass()));
+    shootout.add("phi",
+            ReconstructorPtr(new ResonanceReconstructorWithPhi()));
+    shootout.add("mass_and_phi",
+            ReconstructorPtr(new ResonanceReconstructorWithMassAndPhi()));
+    shootout.add("simple_mass_and_phi",
+            ReconstructorPtr(new SimpleResonanceReconstructorWithMassAndPhi()));
+    shootout.add("simple_mass",
+            ReconstructorPtr(new SimpleResonanceReconstructorWithMass()));
+    shootout.add("collimated_simple_mass",
+            ReconstructorPtr(new CollimatedSimpleResonanceReconstructorWithMass()));
+    shootout.add("collimated_simple_top_mass",
+            ReconstructorPtr(new CollimatedSimpleResonanceReconstructorWithTopMass()));
+    shootout.add("collimated_tops",
+            ReconstructorPtr(new ResonanceReconstructorWithCollimatedTops()));
+    shootout.add("chi2", ReconstructorPtr(chi2));
+
+    Jet jet;
+
+    uint32_t failures = 0;
+    double separate_time = 0;
+    double shootout_time = 0;
+    for(uint32_t event = 0; events > event; ++event)
+    {
+        const LorentzVector lepton = random_p4(30, 500, 0.1);
+        const LorentzVector met = random_p4(20, 500, 0);
+
+        const uint32_t number_of_jets = 2 + rand() % (max_jets - 1);
+
+        Jets jets(number_of_jets);
+        random_jets(jets, jet);
+
+        ResonanceShootout::Results expected;
+
+        clock_t start = clock();
+        for(uint32_t index = 0; shootout.size() > index; ++index)
+            expected.push_back(shootout.reconstructor(index)->run(lepton,
+                        met, jets));
+        separate_time += double(clock() - start) / CLOCKS_PER_SEC;
+
+        ResonanceShootout::Results results;
+
+        start = clock();
+        shootout.run(lepton, met, jets, results);
+        shootout_time += double(clock() - start) / CLOCKS_PER_SEC;
+
+        for(uint32_t index = 0; shootout.size() > index; ++index)
+        {
+            if (!isSame(expected[index], results[index]))
+            {
+                cerr << "event " << event << " with " << number_of_jets
+                    << " jets: different solution found by shootout "
+                    << shootout.name(index) << endl;
+
+                ++failures;
+            }
+        }
+    }
+
+    cout << "separate reconstruction" << endl;
+    cout << "it took " << separate_time << " seconds" << endl;
+    cout << endl;
+
+    cout << "shootout reconstruction" << endl;
+    cout << "it took " << shootout_time << " seconds" << endl;
+    cout << endl;
+
+    cout << failures << " different solutions found" << endl;
+
+    return failures ? 1 : 0;
+}
+catch(const exception &error)
+{
+    cerr << "error: " << error.what() << endl;
+
+    return 1;
+}
+catch(...)
+{
+    cerr << "Unknown error" << endl;
+
+    return 1;
+}
@@ -0,0 +1,145 @@
+// Regression test of the SynchSelector applied on top of the prefix
+// selector: random events are selected by the nominal and inverted htlep
+// selectors independently and with the inverted one reusing the prefix
+// decisions, cutflows and good jets should be the same
+//
+// Created by agent, Oct 17, 2026
+// Copyright 2026, All rights reserved
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/pointer_cast.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "bsm_input/interface/Event.pb.h"
+#include "interface/Cut.h"
+#include "interface/RandomEvent.h"
+#include "interface/Selector.h"
+#include "interface/SynchSelector.h"
+
+using namespace std;
+
+using boost::dynamic_pointer_cast;
+using boost::lexical_cast;
+using boost::shared_ptr;
+
+using namespace bsm;
+
+typedef shared_ptr<SynchSelector> SynchSelectorPtr;
+
+SynchSelectorPtr createSelector(char *jec_files[])
+{
+    SynchSelectorPtr selector(new SynchSelector());
+    selector->setCorrection(JetEnergyCorrectionDelegate::L1, jec_files[0]);
+    selector->setCorrection(JetEnergyCorrectionDelegate::L2, jec_files[1]);
+    selector->setCorrection(JetEnergyCorrectionDelegate::L3, jec_files[2]);
+
+    return selector;
+}
+
+SynchSelectorPtr createInverted(const SynchSelectorPtr &selector)
+{
+    SynchSelectorPtr inverted =
+        dynamic_pointer_cast<SynchSelector>(selector->clone());
+    inverted->htlep()->invert();
+
+    return inverted;
+}
+
+bool isSame(const SynchSelector &selector, const SynchSelector &other)
+{
+    for(uint32_t cut = 0; SynchSelector::SELECTIONS > cut; ++cut)
+    {
+        if (selector.cutflow()->cut(cut)->events()->counts()
+                    != other.cutflow()->cut(cut)->events()->counts()
+                || selector.cutflow()->cut(cut)->objects()->counts()
+                    != other.cutflow()->cut(cut)->objects()->counts())
+            return false;
+    }
+
+    return isSameCorrection(selector.goodJets(), other.goodJets());
+}
+
+int main(int argc, char *argv[])
+try
+{
+    if (6 > argc)
+    {
+        cerr << "usage: " << argv[0]
+            << " events max_jets l1_jec.txt l2_jec.txt l3_jec.txt" << endl;
+
+        return 0;
+    }
+
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    const uint32_t events = lexical_cast<uint32_t>(argv[1]);
+    const uint32_t max_jets = lexical_cast<uint32_t>(argv[2]);
+
+    // Independent selection: every selector runs all the cuts
+    //
+    SynchSelectorPtr nominal = createSelector(argv + 3);
+    SynchSelectorPtr inverted = createInverted(nominal);
+
+    // Prefix selection: the inverted selector reuses prefix decisions
+    //
+    SynchSelectorPtr prefix = createSelector(argv + 3);
+    SynchSelectorPtr tail = createInverted(prefix);
+
+    Event event;
+
+    uint32_t failures = 0;
+    for(uint32_t event_number = 0; events > event_number; ++event_number)
+    {
+        random_event(event, max_jets);
+
+        const bool nominal_result = nominal->apply(&event);
+        const bool inverted_result = inverted->apply(&event);
+
+        const bool prefix_result = prefix->apply(&event);
+        const bool tail_result = tail->apply(&event, *prefix);
+
+        if (nominal_result != prefix_result
+                || !isSame(*nominal, *prefix))
+        {
+            cerr << "event " << event_number
+                << ": nominal and prefix selections differ" << endl;
+
+            ++failures;
+        }
+
+        if (inverted_result != tail_result
+                || !isSame(*inverted, *tail))
+        {
+            cerr << "event " << event_number
+                << ": inverted and tail selections differ" << endl;
+
+            ++failures;
+        }
+    }
+
+    cout << "nominal selection" << endl;
+    cout << *nominal->cutflow() << endl;
+
+    cout << "inverted selection" << endl;
+    cout << *inverted->cutflow() << endl;
+
+    cout << failures << " different selections found" << endl;
+
+    return failures ? 1 : 0;
+}
+catch(const exception &error)
+{
+    cerr << "error: " << error.what() << endl;
+
+    return 1;
+}
+catch(...)
+{
+    cerr << "Unknown error" << endl;
+
+    return 1;
+}
@@ -0,0 +1,173 @@
+// Test top-tag weight: probabilities of at least one and of exactly k
+// tagged jets are compared with the sum over all subsets of jets
+//
+// Created by agent, Oct 16, 2026
+// Copyright 2026, All rights reserved
+
+#include <time.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include "interface/ToptagWeight.h"
+
+using namespace std;
+
+using boost::lexical_cast;
+
+using bsm::ToptagWeight;
+
+typedef vector<float> Probabilities;
+
+// Sum of subset probabilities: multiplicity of tags is the index
+//
+vector<double> subsets(const Probabilities &probabilities)
+{
+    vector<double> weights(probabilities.size() + 1, 0);
+
+    const uint32_t nperm = 1u << probabilities.size();
+    for(uint32_t perm = 0; perm < nperm; ++perm)
+    {
+        double weight = 1;
+        uint32_t tags = 0;
+        for(uint32_t index = 0; probabilities.size() > index; ++index)
+        {
+            if ((perm >> index) & 1)
+            {
+                weight *= probabilities[index];
+                ++tags;
+            }
+            else
+                weight *= 1 - probabilities[index];
+        }
+
+        weights[tags] += weight;
+    }
+
+    return weights;
+}
+
+bool isClose(const double &value, const double &other_value)
+{
+    return fabs(value - other_value)
+        <= 1e-5 * max(fabs(value), fabs(other_value)) + 1e-12;
+}
+
+int main(int argc, char *argv[])
+try
+{
+    if (3 > argc)
+    {
+        cerr << "usage: " << argv[0] << " events max_jets" << endl;
+
+        return 0;
+    }
+
+    const uint32_t events = lexical_cast<uint32_t>(argv[1]);
+    const uint32_t max_jets = lexical_cast<uint32_t>(argv[2]);
+
+    if (20 < max_jets)
+    {
+        cerr << "max_jets should not exceed 20" << endl;
+
+        return 1;
+    }
+
+    uint32_t failures = 0;
+    double subsets_time = 0;
+    double weight_time = 0;
+    for(uint32_t event = 0; events > event; ++event)
+    {
+        const uint32_t jets = 1 + rand() % max_jets;
+
+        Probabilities probabilities;
+        for(uint32_t jet = 0; jets > jet; ++jet)
+        {
+            const float pt = 200 + 800.0 * rand() / RAND_MAX;
+
+            probabilities.push_back(ToptagWeight::probability(pt));
+        }
+
+        clock_t start = clock();
+        const vector<double> expected = subsets(probabilities);
+        subsets_time += double(clock() - start) / CLOCKS_PER_SEC;
+
+        start = clock();
+        ToptagWeight weight;
+        for(Probabilities::const_iterator probability = probabilities.begin();
+                probabilities.end() != probability;
+                ++probability)
+        {
+            weight.add(*probability);
+        }
+
+        const float at_least_one = weight.atLeastOne();
+        weight_time += double(clock() - start) / CLOCKS_PER_SEC;
+
+        // Sum non-empty subsets: 1 - expected[0] loses precision for small
+        // tag probabilities
+        //
+        double expected_at_least_one = 0;
+        for(uint32_t tags = 1; jets >= tags; ++tags)
+            expected_at_least_one += expected[tags];
+
+        if (!isClose(expected_at_least_one, at_least_one))
+        {
+            cerr << "event " << event << " with " << jets
+                << " jets: at least one tag weight " << at_least_one
+                << " is different from " << expected_at_least_one << endl;
+
+            ++failures;
+        }
+
+        for(uint32_t tags = 0; jets >= tags; ++tags)
+        {
+            if (!isClose(expected[tags], weight.exactly(tags)))
+            {
+                cerr << "event " << event << " with " << jets
+                    << " jets: " << tags << " tags weight "
+                    << weight.exactly(tags) << " is different from "
+                    << expected[tags] << endl;
+
+                ++failures;
+            }
+        }
+
+        if (weight.exactly(jets + 1))
+        {
+            cerr << "event " << event << " with " << jets
+                << " jets: more tags than jets have weight" << endl;
+
+            ++failures;
+        }
+    }
+
+    cout << "loop over all subsets" << endl;
+    cout << "it took " << subsets_time << " seconds" << endl;
+    cout << endl;
+
+    cout << "top-tag weight" << endl;
+    cout << "it took " << weight_time << " seconds" << endl;
+    cout << endl;
+
+    cout << failures << " differences found" << endl;
+
+    return failures ? 1 : 0;
+}
+catch(const exception &error)
+{
+    cerr << "error: " << error.what() << endl;
+
+    return 1;
+}
+catch(...)
+{
+    cerr << "Unknown error" << endl;
+
+    return 1;
+}